@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include "batch_io.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+int batch_tx_init(batch_tx_t *tx, int sockfd, unsigned cap) {
+    memset(tx, 0, sizeof(*tx));
+    if (cap == 0) cap = 1;
+    if (cap > BATCH_MAX) cap = BATCH_MAX;
+    tx->sockfd = sockfd;
+    tx->cap = cap;
+    tx->msgs = calloc(cap, sizeof(*tx->msgs));
+    tx->iovs = calloc((size_t)cap * 2, sizeof(*tx->iovs));
+    tx->hdrs = calloc(cap, sizeof(*tx->hdrs));
+    tx->addrs = calloc(cap, sizeof(*tx->addrs));
+    if (!tx->msgs || !tx->iovs || !tx->hdrs || !tx->addrs) {
+        batch_tx_free(tx);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void batch_tx_free(batch_tx_t *tx) {
+    free(tx->msgs);
+    free(tx->iovs);
+    free(tx->hdrs);
+    free(tx->addrs);
+    free(tx->gso_msgs);
+    free(tx->gso_cmsgs);
+    free(tx->gso_counts);
+    tx->msgs = NULL;
+    tx->iovs = NULL;
+    tx->hdrs = NULL;
+    tx->addrs = NULL;
+    tx->gso_msgs = NULL;
+    tx->gso_cmsgs = NULL;
+    tx->gso_counts = NULL;
+    tx->gso = false;
+    tx->count = 0;
+}
+
+int batch_tx_enable_gso(batch_tx_t *tx) {
+    // Setting a zero socket-wide size is a no-op that fails on kernels without GSO
+    int zero = 0;
+    if (setsockopt(tx->sockfd, SOL_UDP, UDP_SEGMENT, &zero, sizeof(zero)) < 0) return -1;
+    tx->gso_msgs = calloc(tx->cap, sizeof(*tx->gso_msgs));
+    tx->gso_cmsgs = calloc(tx->cap, sizeof(*tx->gso_cmsgs));
+    tx->gso_counts = calloc(tx->cap, sizeof(*tx->gso_counts));
+    if (!tx->gso_msgs || !tx->gso_cmsgs || !tx->gso_counts) {
+        errno = ENOMEM;
+        return -1;
+    }
+    tx->gso = true;
+    return 0;
+}
+
+int batch_tx_add(batch_tx_t *tx, const void *hdr, size_t hdr_len,
+                 const void *payload, size_t payload_len,
+                 const struct sockaddr *addr, socklen_t addr_len) {
+    if (tx->count == tx->cap && batch_tx_flush(tx) < 0) return -1;
+
+    unsigned i = tx->count++;
+    struct iovec *iov = &tx->iovs[i * 2];
+    memcpy(tx->hdrs[i], hdr, hdr_len);
+    memcpy(&tx->addrs[i], addr, addr_len);
+    iov[0].iov_base = tx->hdrs[i];
+    iov[0].iov_len = hdr_len;
+    iov[1].iov_base = (void *)payload;
+    iov[1].iov_len = payload_len;
+
+    struct msghdr *mh = &tx->msgs[i].msg_hdr;
+    memset(mh, 0, sizeof(*mh));
+    mh->msg_name = &tx->addrs[i];
+    mh->msg_namelen = addr_len;
+    mh->msg_iov = iov;
+    mh->msg_iovlen = 2;
+    return 0;
+}
+
+// A full socket buffer (EAGAIN on a non-blocking socket) or device queue
+// (ENOBUFS) passes; the flush waits it out and carries on from the first
+// unsent message instead of losing the batch
+static bool tx_transient(int err) {
+    return err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS;
+}
+
+static void tx_wait(const batch_tx_t *tx, int err) {
+    struct pollfd p = { .fd = tx->sockfd, .events = POLLOUT };
+    // ENOBUFS leaves the socket writable: just give the queue a moment
+    (void)poll(&p, err == ENOBUFS ? 0 : 1, BATCH_TX_WAIT_MS);
+}
+
+static int flush_plain(batch_tx_t *tx, unsigned done) {
+    while (done < tx->count) {
+        int n = sendmmsg(tx->sockfd, tx->msgs + done, tx->count - done, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (tx_transient(errno)) {
+                tx_wait(tx, errno);
+                continue;
+            }
+            tx->count = 0;
+            return -1;
+        }
+        tx->syscalls++;
+        done += (unsigned)n;
+        tx->packets += (uint64_t)n;
+    }
+    tx->count = 0;
+    return 0;
+}
+
+static size_t slot_size(const batch_tx_t *tx, unsigned i) {
+    return tx->iovs[i * 2].iov_len + tx->iovs[i * 2 + 1].iov_len;
+}
+
+static bool same_peer(const batch_tx_t *tx, unsigned a, unsigned b) {
+    socklen_t len = tx->msgs[a].msg_hdr.msg_namelen;
+    return len == tx->msgs[b].msg_hdr.msg_namelen &&
+           memcmp(&tx->addrs[a], &tx->addrs[b], len) == 0;
+}
+
+// GSO requires every segment but the last of a run to be exactly gso_size
+static int flush_gso(batch_tx_t *tx) {
+    unsigned runs = 0;
+    for (unsigned i = 0; i < tx->count;) {
+        size_t seg = slot_size(tx, i);
+        size_t total = seg;
+        unsigned j = i + 1;
+        while (j < tx->count && j - i < BATCH_GSO_MAX_SEGS && same_peer(tx, i, j)) {
+            size_t sz = slot_size(tx, j);
+            if (sz > seg || total + sz > BATCH_GSO_MAX_BYTES) break;
+            total += sz;
+            j++;
+            if (sz < seg) break;
+        }
+
+        struct msghdr *mh = &tx->gso_msgs[runs].msg_hdr;
+        *mh = tx->msgs[i].msg_hdr;
+        mh->msg_iovlen = (size_t)(j - i) * 2;
+        if (j - i > 1) {
+            mh->msg_control = tx->gso_cmsgs[runs].buf;
+            mh->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            struct cmsghdr *cm = CMSG_FIRSTHDR(mh);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gso_size = (uint16_t)seg;
+            memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+        }
+        tx->gso_counts[runs++] = j - i;
+        i = j;
+    }
+
+    unsigned done = 0;
+    unsigned slot = 0;   // first packet slot of run `done`
+    while (done < runs) {
+        int n = sendmmsg(tx->sockfd, tx->gso_msgs + done, runs - done, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT) {
+                // Device or path cannot segment for us; fall back permanently
+                tx->gso = false;
+                return flush_plain(tx, slot);
+            }
+            if (tx_transient(errno)) {
+                tx_wait(tx, errno);
+                continue;
+            }
+            tx->count = 0;
+            return -1;
+        }
+        tx->syscalls++;
+        for (int k = 0; k < n; k++) {
+            slot += tx->gso_counts[done + (unsigned)k];
+            tx->packets += tx->gso_counts[done + (unsigned)k];
+        }
+        done += (unsigned)n;
+    }
+    tx->count = 0;
+    return 0;
+}
+
+int batch_tx_flush(batch_tx_t *tx) {
+    if (tx->count == 0) return 0;
+    return tx->gso ? flush_gso(tx) : flush_plain(tx, 0);
+}
+
+static int rx_alloc_bufs(batch_rx_t *rx, size_t buf_size) {
+    uint8_t *bufs = malloc((size_t)rx->cap * buf_size);
+    if (!bufs) {
+        errno = ENOMEM;
+        return -1;
+    }
+    free(rx->bufs);
+    rx->bufs = bufs;
+    rx->buf_size = buf_size;
+    for (unsigned i = 0; i < rx->cap; i++) {
+        rx->iovs[i].iov_base = batch_rx_buf(rx, i);
+        rx->iovs[i].iov_len = buf_size;
+    }
+    return 0;
+}
+
+int batch_rx_init(batch_rx_t *rx, int sockfd, unsigned cap, size_t buf_size) {
+    memset(rx, 0, sizeof(*rx));
+    if (cap == 0) cap = 1;
+    if (cap > BATCH_MAX) cap = BATCH_MAX;
+    rx->sockfd = sockfd;
+    rx->cap = cap;
+    rx->msgs = calloc(cap, sizeof(*rx->msgs));
+    rx->iovs = calloc(cap, sizeof(*rx->iovs));
+    rx->addrs = calloc(cap, sizeof(*rx->addrs));
+    if (!rx->msgs || !rx->iovs || !rx->addrs || rx_alloc_bufs(rx, buf_size) < 0) {
+        batch_rx_free(rx);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void batch_rx_free(batch_rx_t *rx) {
+    free(rx->msgs);
+    free(rx->iovs);
+    free(rx->bufs);
+    free(rx->addrs);
+    free(rx->cmsgs);
+    rx->msgs = NULL;
+    rx->iovs = NULL;
+    rx->bufs = NULL;
+    rx->addrs = NULL;
+    rx->cmsgs = NULL;
+    rx->gro = false;
+}
+
+int batch_rx_enable_gro(batch_rx_t *rx) {
+    int one = 1;
+    if (setsockopt(rx->sockfd, SOL_UDP, UDP_GRO, &one, sizeof(one)) < 0) return -1;
+    rx->cmsgs = calloc(rx->cap, sizeof(*rx->cmsgs));
+    if (!rx->cmsgs) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (rx->buf_size < BATCH_GRO_BUF && rx_alloc_bufs(rx, BATCH_GRO_BUF) < 0) return -1;
+    rx->gro = true;
+    return 0;
+}
+
+size_t batch_rx_segsize(const batch_rx_t *rx, unsigned i) {
+    const struct msghdr *mh = &rx->msgs[i].msg_hdr;
+    size_t len = rx->msgs[i].msg_len;
+    if (!rx->gro) return len;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(mh); cm; cm = CMSG_NXTHDR((struct msghdr *)mh, cm)) {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+            int seg;
+            memcpy(&seg, CMSG_DATA(cm), sizeof(seg));
+            if (seg > 0 && (size_t)seg < len) return (size_t)seg;
+        }
+    }
+    return len;
+}
+
+int batch_rx_recv(batch_rx_t *rx, int flags) {
+    for (unsigned i = 0; i < rx->cap; i++) {
+        struct msghdr *mh = &rx->msgs[i].msg_hdr;
+        mh->msg_name = &rx->addrs[i];
+        mh->msg_namelen = sizeof(rx->addrs[i]);
+        mh->msg_iov = &rx->iovs[i];
+        mh->msg_iovlen = 1;
+        mh->msg_control = rx->gro ? rx->cmsgs[i].buf : NULL;
+        mh->msg_controllen = rx->gro ? sizeof(rx->cmsgs[i].buf) : 0;
+        mh->msg_flags = 0;
+    }
+    int n = recvmmsg(rx->sockfd, rx->msgs, rx->cap, flags, NULL);
+    if (n < 0) return -1;
+    rx->syscalls++;
+    for (int i = 0; i < n; i++) {
+        size_t len = rx->msgs[i].msg_len;
+        size_t seg = batch_rx_segsize(rx, (unsigned)i);
+        rx->packets += seg ? (len + seg - 1) / seg : 1;
+    }
+    return n;
+}
@@ -0,0 +1,101 @@
+#ifndef BATCH_IO_H
+#define BATCH_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+// Batched datagram I/O on top of sendmmsg/recvmmsg. Outgoing packets are
+// queued and flushed in one syscall; incoming packets are drained in one.
+// On Linux the TX side can additionally hand runs of equal-sized packets to
+// the kernel as one UDP_SEGMENT (GSO) buffer, and the RX side can accept
+// UDP_GRO super-datagrams and report their segment size.
+
+#define BATCH_DEFAULT 32
+#define BATCH_MAX 1024
+#define BATCH_HDR_MAX 64            // largest header a queued packet may carry
+#define BATCH_GSO_MAX_SEGS 64       // kernel UDP_MAX_SEGMENTS
+#define BATCH_GSO_MAX_BYTES 65000   // stay below the 64 KB IPv4 datagram limit
+#define BATCH_GRO_BUF 65535         // RX buffer for one coalesced super-datagram
+#define BATCH_TX_WAIT_MS 1          // longest wait for room before a send is retried
+
+typedef union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+} batch_cmsg_t;
+
+typedef struct {
+    int sockfd;
+    unsigned cap;
+    unsigned count;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;                  // two per slot: header copy, payload
+    uint8_t (*hdrs)[BATCH_HDR_MAX];
+    struct sockaddr_storage *addrs;
+    bool gso;
+    struct mmsghdr *gso_msgs;           // one entry per coalesced run
+    batch_cmsg_t *gso_cmsgs;
+    unsigned *gso_counts;               // packets in each run
+    uint64_t syscalls;
+    uint64_t packets;
+} batch_tx_t;
+
+typedef struct {
+    int sockfd;
+    unsigned cap;
+    size_t buf_size;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    uint8_t *bufs;
+    struct sockaddr_storage *addrs;
+    bool gro;
+    batch_cmsg_t *cmsgs;
+    uint64_t syscalls;
+    uint64_t packets;                   // wire packets (GRO segments counted individually)
+} batch_rx_t;
+
+int batch_tx_init(batch_tx_t *tx, int sockfd, unsigned cap);
+void batch_tx_free(batch_tx_t *tx);
+// Queue one datagram. The header is copied, the payload is referenced and
+// must stay valid until the next flush. Returns -1 if an implicit flush failed.
+int batch_tx_add(batch_tx_t *tx, const void *hdr, size_t hdr_len,
+                 const void *payload, size_t payload_len,
+                 const struct sockaddr *addr, socklen_t addr_len);
+// Send everything queued. A full socket buffer or device queue (EAGAIN,
+// ENOBUFS) is waited out, resuming at the first unsent message; on any
+// other error the batch is dropped and -1 returned with errno set.
+int batch_tx_flush(batch_tx_t *tx);
+// Coalesce runs of equal-sized packets to the same peer into UDP_SEGMENT
+// sends. Returns -1 if the kernel does not support UDP GSO.
+int batch_tx_enable_gso(batch_tx_t *tx);
+
+int batch_rx_init(batch_rx_t *rx, int sockfd, unsigned cap, size_t buf_size);
+void batch_rx_free(batch_rx_t *rx);
+// Receive up to cap datagrams. flags are passed to recvmmsg (MSG_DONTWAIT,
+// MSG_WAITFORONE). Returns the number received, or -1 with errno set.
+int batch_rx_recv(batch_rx_t *rx, int flags);
+// Accept UDP_GRO super-datagrams; grows the buffers to BATCH_GRO_BUF.
+// Returns -1 if the kernel does not support UDP GRO.
+int batch_rx_enable_gro(batch_rx_t *rx);
+// Size of each wire packet inside datagram i (the whole length without GRO)
+size_t batch_rx_segsize(const batch_rx_t *rx, unsigned i);
+
+static inline uint8_t *batch_rx_buf(const batch_rx_t *rx, unsigned i) {
+    return rx->bufs + (size_t)i * rx->buf_size;
+}
+
+static inline size_t batch_rx_len(const batch_rx_t *rx, unsigned i) {
+    return rx->msgs[i].msg_len;
+}
+
+static inline const struct sockaddr *batch_rx_addr(const batch_rx_t *rx, unsigned i, socklen_t *len) {
+    *len = rx->msgs[i].msg_hdr.msg_namelen;
+    return (const struct sockaddr *)&rx->addrs[i];
+}
+
+static inline double batch_ratio(uint64_t packets, uint64_t syscalls) {
+    return syscalls ? (double)packets / (double)syscalls : 0.0;
+}
+
+#endif
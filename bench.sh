@@ -0,0 +1,121 @@
+#!/bin/bash
+# 루프백 벤치마크 묶음: 크기·손실·MSS·알고리즘 조합마다 같은 전송을 반복해
+# 처리량, 재전송 바이트, CPU 시간, MB당 시스템 콜, 최대 RSS, 완료 시간 백분위를 모아 JSON으로 저장
+# 사용법: ./bench.sh [결과.json]
+#   BENCH_SIZES="1 100"        파일 크기 (MB, 1 ~ 10240)
+#   BENCH_LOSS="0 0.01"        수신측 손실 확률
+#   BENCH_MSS="1400"           MSS (바이트)
+#   BENCH_CC="reno cubic bbr"  혼잡 제어 알고리즘
+#   BENCH_RUNS=5               조합마다 반복 횟수
+#   BENCH_OPTS=""              송신측에 더 넘길 옵션 (예: "-g -b 64")
+#   BENCH_DIR=/tmp             입력·출력 파일을 둘 디렉터리 (10GB면 여유 공간 20GB 필요)
+cd "$(dirname "$0")"
+make > /dev/null 2>&1 || exit 1
+
+RESULT=${1:-bench.json}
+SIZES=${BENCH_SIZES:-1 100}
+LOSSES=${BENCH_LOSS:-0 0.01}
+MSSES=${BENCH_MSS:-1400}
+CCS=${BENCH_CC:-reno cubic bbr}
+RUNS=${BENCH_RUNS:-5}
+DIR=${BENCH_DIR:-/tmp}
+PORT=$((20000 + RANDOM % 20000))
+IN=$(mktemp "$DIR/bench_in.XXXXXX")
+OUT=$(mktemp "$DIR/bench_out.XXXXXX")
+RUNS_LOG=$(mktemp /tmp/bench_runs.XXXXXX)
+trap 'rm -f "$IN" "$OUT" "$OUT.r" "$OUT.s" "$RUNS_LOG" "$RESULT.tmp"' EXIT
+
+# 한 번 실행: 한 줄에 "완료 시간 처리량 재전송바이트 송신CPU(사용자 시스템) MB당콜 RSS 수신CPU(사용자 시스템) MB당콜 RSS 결과"
+run_once() {
+    local loss=$1 mss=$2 cc=$3 size=$4
+    ./receiver -q "$PORT" "$OUT" "$loss" > "$OUT.r" 2>&1 &
+    local rpid=$!
+    sleep 0.3
+    # 수신측은 FIN을 확인하면 쓰기 스레드가 파일을 다 쓰기를 기다렸다가 통계를 쓰고 스스로 끝남.
+    # 10GB를 --fsync로 쓰면 몇 분 걸리므로 크기에 비례해 기다림 (초당 20MB 이상 쓴다고 보고 30초 여유).
+    # 송신이 실패했으면 더 올 것이 없으니 바로 끝냄
+    if timeout 600 ./sender -q -c "$cc" $BENCH_OPTS 127.0.0.1 "$PORT" "$IN" "$mss" 200 > "$OUT.s" 2>&1; then
+        timeout "$((30 + size / 20))" tail --pid="$rpid" -f /dev/null
+    fi
+    kill "$rpid" 2>/dev/null
+    wait "$rpid" 2>/dev/null
+    PORT=$((PORT + 1))
+    local ok=1
+    cmp -s "$IN" "$OUT" || ok=0
+    awk -v ok="$ok" '
+        FNR == 1 { file++ }
+        file == 1 && /^전송 시간:/ { secs = $3 }
+        file == 1 && /^처리량:/ { mbs = $2 }
+        file == 1 && /^재전송 바이트:/ { retx = $3 }
+        /^시스템 콜:/ { s = $0; sub(/.*MB당 /, "", s); calls[file] = s + 0 }
+        /^CPU 시간:/ { user[file] = $4; sys[file] = $7; rss[file] = $11 }
+        END {
+            if (secs == "" || mbs == "") ok = 0
+            printf "%s %s %s %s %s %s %s %s %s %s %s %d\n", secs + 0, mbs + 0, retx + 0, user[1] + 0, sys[1] + 0,
+                   calls[1] + 0, rss[1] + 0, user[2] + 0, sys[2] + 0, calls[2] + 0, rss[2] + 0, ok
+        }' "$OUT.s" "$OUT.r"
+}
+
+# 한 조합의 실행 결과를 JSON 객체 한 줄로 (이름, 평균, 최대 RSS, 완료 시간 백분위)
+summarize() {
+    local name=$1 cc=$2 mss=$3 loss=$4 size=$5
+    sort -n -k1,1 "$RUNS_LOG" | awk -v name="$name" -v cc="$cc" -v mss="$mss" -v loss="$loss" -v size="$size" '
+        function pct(p,   i) { i = int((p * n + 99) / 100); if (i < 1) i = 1; return t[i] }
+        $12 == 1 {
+            n++; t[n] = $1; mbs += $2; retx += $3; cu += $4; cs += $5; calls += $6
+            if ($7 > rss) rss = $7
+            rcu += $8; rcs += $9; rcalls += $10
+            if ($11 > rrss) rrss = $11
+        }
+        $12 != 1 { failed++ }
+        END {
+            k = n ? n : 1
+            printf "    {\"name\": \"%s\", \"cc\": \"%s\", \"mss\": %d, \"loss\": %s, \"size_mb\": %d, \"runs\": %d, \"failed\": %d, ",
+                   name, cc, mss, loss, size, n + failed, failed
+            printf "\"goodput_mbs\": %.2f, \"retrans_bytes\": %.0f, ", mbs / k, retx / k
+            printf "\"cpu_user_s\": %.3f, \"cpu_sys_s\": %.3f, \"syscalls_per_mb\": %.1f, \"peak_rss_kb\": %d, ",
+                   cu / k, cs / k, calls / k, rss
+            printf "\"rx_cpu_user_s\": %.3f, \"rx_cpu_sys_s\": %.3f, \"rx_syscalls_per_mb\": %.1f, \"rx_peak_rss_kb\": %d, ",
+                   rcu / k, rcs / k, rcalls / k, rrss
+            printf "\"time_p50_s\": %.3f, \"time_p90_s\": %.3f, \"time_p99_s\": %.3f, \"time_max_s\": %.3f}",
+                   n ? pct(50) : 0, n ? pct(90) : 0, n ? pct(99) : 0, n ? t[n] : 0
+        }'
+}
+
+echo "=== 벤치마크: 크기 ${SIZES// /,}MB, 손실 ${LOSSES// /,}, MSS ${MSSES// /,}, ${CCS// /,}, ${RUNS}회씩 ==="
+printf "%-28s %-10s %-10s %-10s %-12s %-10s %-10s %s\n" "조합" "처리량" "p50(초)" "p90(초)" "재전송(B)" "CPU(초)" "콜/MB" "실패"
+{
+    echo "{"
+    echo "  \"version\": 1,"
+    echo "  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\","
+    echo "  \"commit\": \"$(git rev-parse --short HEAD 2>/dev/null || echo unknown)\","
+    echo "  \"host\": \"$(uname -n)\","
+    echo "  \"results\": ["
+} > "$RESULT.tmp"
+first=1
+for size in $SIZES; do
+    dd if=/dev/urandom of="$IN" bs=1M count="$size" 2>/dev/null
+    for loss in $LOSSES; do
+        for mss in $MSSES; do
+            for cc in $CCS; do
+                name="$cc/mss$mss/loss$loss/${size}MB"
+                : > "$RUNS_LOG"
+                for ((r = 0; r < RUNS; r++)); do
+                    run_once "$loss" "$mss" "$cc" "$size" >> "$RUNS_LOG"
+                done
+                line=$(summarize "$name" "$cc" "$mss" "$loss" "$size")
+                [ "$first" = 1 ] || echo "," >> "$RESULT.tmp"
+                printf "%s" "$line" >> "$RESULT.tmp"
+                first=0
+                echo "$line" | awk -v name="$name" '{
+                    for (i = 1; i <= NF; i++) { k = $i; gsub(/[",:{}]/, "", k); v = $(i + 1); gsub(/[",}]/, "", v); m[k] = v }
+                    printf "%-28s %-10s %-10s %-10s %-12s %-10.3f %-10s %s\n", name, m["goodput_mbs"], m["time_p50_s"],
+                           m["time_p90_s"], m["retrans_bytes"], m["cpu_user_s"] + m["cpu_sys_s"], m["syscalls_per_mb"], m["failed"]
+                }'
+            done
+        done
+    done
+done
+printf "\n  ]\n}\n" >> "$RESULT.tmp"
+mv "$RESULT.tmp" "$RESULT"
+echo "결과: $RESULT"
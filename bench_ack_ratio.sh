@@ -0,0 +1,35 @@
+#!/bin/bash
+# ACK 빈도별 처리량 비교: 루프백에서 같은 파일을 ACK 빈도만 바꿔 전송
+# 사용법: ./bench_ack_ratio.sh [크기_MB] [손실확률] [빈도...]
+cd "$(dirname "$0")"
+make > /dev/null 2>&1 || exit 1
+
+SIZE_MB=${1:-100}
+LOSS=${2:-0}
+shift 2 2>/dev/null
+RATIOS=${*:-1 2 4 8 15}
+PORT=$((20000 + RANDOM % 20000))
+IN=$(mktemp /tmp/bench_in.XXXXXX)
+OUT=$(mktemp /tmp/bench_out.XXXXXX)
+trap 'rm -f "$IN" "$OUT" "$OUT.r" "$OUT.s"' EXIT
+
+dd if=/dev/urandom of="$IN" bs=1M count="$SIZE_MB" 2>/dev/null
+
+echo "=== ACK 빈도 벤치마크: ${SIZE_MB}MB, 손실 ${LOSS} ==="
+printf "%-8s %-12s %-12s %-14s %-10s %s\n" "ACK빈도" "처리량(MB/s)" "보낸 ACK" "ACK당 패킷" "재전송" "결과"
+for a in $RATIOS; do
+    ./receiver -q "$PORT" "$OUT" "$LOSS" > "$OUT.r" 2>&1 &
+    rpid=$!
+    sleep 0.3
+    timeout 300 ./sender -q -a "$a" 127.0.0.1 "$PORT" "$IN" 1400 200 > "$OUT.s" 2>&1
+    sleep 0.3
+    kill "$rpid" 2>/dev/null
+    wait "$rpid" 2>/dev/null
+    tput=$(sed -n 's/^처리량: \([0-9.]*\).*/\1/p' "$OUT.s")
+    acks=$(sed -n 's/^보낸 ACK: \([0-9]*\).*/\1/p' "$OUT.r")
+    per=$(sed -n 's/.*데이터 패킷 \([0-9.]*\)개당.*/\1/p' "$OUT.r")
+    retx=$(sed -n 's/^총 재전송 횟수: \([0-9]*\).*/\1/p' "$OUT.s")
+    cmp -s "$IN" "$OUT" && ok="일치" || ok="불일치"
+    printf "%-8s %-12s %-12s %-14s %-10s %s\n" "$a" "${tput:--}" "${acks:--}" "${per:--}" "${retx:--}" "$ok"
+    PORT=$((PORT + 1))
+done
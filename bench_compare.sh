@@ -0,0 +1,94 @@
+#!/bin/bash
+# 벤치마크 결과(bench.sh의 JSON)를 기준 결과와 비교해 회귀를 표시
+# 사용법: ./bench_compare.sh <기준.json> <현재.json> [허용_변화율_%]
+#   처리량이 허용치보다 줄거나, 완료 시간·CPU 시간·MB당 시스템 콜·최대 RSS·재전송 바이트가
+#   허용치(기본 10%)보다 늘면 회귀. 실패한 실행이 늘어도 회귀. 회귀가 있으면 종료 코드 1
+if [ $# -lt 2 ]; then
+    echo "사용법: $0 <기준.json> <현재.json> [허용_변화율_%]" >&2
+    exit 2
+fi
+BASE=$1
+CUR=$2
+THRESH=${3:-${BENCH_THRESHOLD:-10}}
+for f in "$BASE" "$CUR"; do
+    if [ ! -r "$f" ]; then
+        echo "오류: 결과 파일을 읽을 수 없습니다: $f" >&2
+        exit 2
+    fi
+done
+
+echo "=== 벤치마크 비교: $BASE → $CUR (허용 ${THRESH}%) ==="
+# 결과 객체는 한 줄에 하나 ("name"이 있는 줄); 키와 숫자 값만 읽는다
+awk -v thresh="$THRESH" '
+    # 지표: 좋은 방향 (1: 클수록 좋음, -1: 작을수록 좋음)과 잡음으로 볼 절대 변화량
+    BEGIN {
+        nm = split("goodput_mbs time_p50_s time_p90_s cpu_s rx_cpu_s syscalls_per_mb peak_rss_kb rx_peak_rss_kb retrans_bytes", metric, " ")
+        dir["goodput_mbs"] = 1;      floor["goodput_mbs"] = 1
+        dir["time_p50_s"] = -1;      floor["time_p50_s"] = 0.005
+        dir["time_p90_s"] = -1;      floor["time_p90_s"] = 0.005
+        dir["cpu_s"] = -1;           floor["cpu_s"] = 0.01
+        dir["rx_cpu_s"] = -1;        floor["rx_cpu_s"] = 0.01
+        dir["syscalls_per_mb"] = -1; floor["syscalls_per_mb"] = 2
+        dir["peak_rss_kb"] = -1;     floor["peak_rss_kb"] = 1024
+        dir["rx_peak_rss_kb"] = -1;  floor["rx_peak_rss_kb"] = 1024
+        dir["retrans_bytes"] = -1;   floor["retrans_bytes"] = 65536
+    }
+    FNR == 1 { file++ }
+    /"name":/ {
+        line = $0
+        sub(/^[ \t]*\{/, "", line)
+        sub(/\}[ \t,]*$/, "", line)
+        n = split(line, kv, ",")
+        delete m
+        for (i = 1; i <= n; i++) {
+            split(kv[i], p, ":")
+            k = p[1]; v = p[2]
+            gsub(/[ "]/, "", k); gsub(/[ "]/, "", v)
+            m[k] = v
+        }
+        name = m["name"]
+        m["cpu_s"] = m["cpu_user_s"] + m["cpu_sys_s"]
+        m["rx_cpu_s"] = m["rx_cpu_user_s"] + m["rx_cpu_sys_s"]
+        if (file == 1) {
+            for (j = 1; j <= nm; j++) base[name, metric[j]] = m[metric[j]]
+            base_failed[name] = m["failed"] + 0
+            in_base[name] = 1
+        } else {
+            order[++count] = name
+            for (j = 1; j <= nm; j++) cur[name, metric[j]] = m[metric[j]]
+            cur_failed[name] = m["failed"] + 0
+        }
+    }
+    END {
+        printf "%-28s %-16s %-12s %-12s %-9s %s\n", "조합", "지표", "기준", "현재", "변화", "판정"
+        for (c = 1; c <= count; c++) {
+            name = order[c]
+            if (!(name in in_base)) {
+                printf "%-28s %-16s %-12s %-12s %-9s %s\n", name, "-", "-", "-", "-", "기준 없음"
+                continue
+            }
+            if (cur_failed[name] > base_failed[name]) {
+                printf "%-28s %-16s %-12d %-12d %-9s %s\n", name, "failed", base_failed[name], cur_failed[name], "-", "회귀"
+                regressions++
+            }
+            for (j = 1; j <= nm; j++) {
+                k = metric[j]
+                b = base[name, k] + 0
+                v = cur[name, k] + 0
+                d = v - b
+                pct = b != 0 ? d * 100.0 / b : (v != 0 ? 100.0 : 0.0)
+                worse = dir[k] > 0 ? -d : d
+                verdict = ""
+                if (worse > floor[k] && (b == 0 || worse * 100.0 / b > thresh)) {
+                    verdict = "회귀"
+                    regressions++
+                } else if (-worse > floor[k] && b != 0 && -worse * 100.0 / b > thresh) {
+                    verdict = "개선"
+                    improvements++
+                }
+                if (verdict != "") printf "%-28s %-16s %-12g %-12g %+7.1f%%  %s\n", name, k, b, v, pct, verdict
+            }
+        }
+        printf "\n비교한 조합 %d개: 회귀 %d건, 개선 %d건\n", count, regressions, improvements
+        exit regressions > 0 ? 1 : 0
+    }' "$BASE" "$CUR"
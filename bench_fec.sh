@@ -0,0 +1,51 @@
+#!/bin/bash
+# FEC와 재전송만 쓰는 경우의 완료 시간 비교: 손실 확률별로 같은 전송을 반복
+# 사용법: ./bench_fec.sh [-s] [크기_MB] [손실확률...]
+#   -s  루프백 대신 시뮬레이터(sim)로 측정 (가상 시각, 결과가 결정적)
+cd "$(dirname "$0")"
+make > /dev/null 2>&1 || exit 1
+
+SIM=0
+if [ "$1" = "-s" ]; then
+    SIM=1
+    shift
+fi
+SIZE_MB=${1:-20}
+shift 2>/dev/null
+LOSSES=${*:-0 0.005 0.01 0.02 0.05 0.1}
+MODES=("재전송만:" "FEC:-F" "FEC(윈도우 유지):--fec-keep-cwnd")
+PORT=$((20000 + RANDOM % 20000))
+IN=$(mktemp /tmp/bench_in.XXXXXX)
+OUT=$(mktemp /tmp/bench_out.XXXXXX)
+trap 'rm -f "$IN" "$OUT" "$OUT.r" "$OUT.s"' EXIT
+
+[ "$SIM" = 0 ] && dd if=/dev/urandom of="$IN" bs=1M count="$SIZE_MB" 2>/dev/null
+
+echo "=== FEC 벤치마크: ${SIZE_MB}MB, $([ "$SIM" = 1 ] && echo 시뮬레이터 || echo 루프백) ==="
+printf "%-8s %-18s %-12s %-10s %-10s %-10s %s\n" "손실" "모드" "완료(초)" "재전송" "타임아웃" "FEC복구" "결과"
+for loss in $LOSSES; do
+    for m in "${MODES[@]}"; do
+        name=${m%%:*}
+        opts=${m#*:}
+        if [ "$SIM" = 1 ]; then
+            ./sim -l "$loss" $opts $((SIZE_MB * 1024 * 1024)) > "$OUT.s" 2>&1
+            secs=$(sed -n 's/^가상 전송 시간: \([0-9.]*\).*/\1/p' "$OUT.s")
+            grep -q '^전송 완료: 예' "$OUT.s" && ok="완료" || ok="미완료"
+        else
+            ./receiver -q "$PORT" "$OUT" "$loss" > "$OUT.r" 2>&1 &
+            rpid=$!
+            sleep 0.3
+            timeout 300 ./sender -q $opts 127.0.0.1 "$PORT" "$IN" 1400 200 > "$OUT.s" 2>&1
+            sleep 0.3
+            kill "$rpid" 2>/dev/null
+            wait "$rpid" 2>/dev/null
+            secs=$(sed -n 's/^전송 시간: \([0-9.]*\).*/\1/p' "$OUT.s")
+            cmp -s "$IN" "$OUT" && ok="일치" || ok="불일치"
+            PORT=$((PORT + 1))
+        fi
+        retx=$(sed -n 's/^총 재전송 횟수: \([0-9]*\).*/\1/p' "$OUT.s" | head -1)
+        rto=$(sed -n 's/^타임아웃 횟수: \([0-9]*\).*/\1/p' "$OUT.s")
+        rep=$(sed -n 's/.*수신측 복구 \([0-9]*\)개.*/\1/p' "$OUT.s")
+        printf "%-8s %-18s %-12s %-10s %-10s %-10s %s\n" "$loss" "$name" "${secs:--}" "${retx:--}" "${rto:--}" "${rep:--}" "$ok"
+    done
+done
@@ -0,0 +1,94 @@
+#include "cc.h"
+
+#include <string.h>
+
+#define CC_INIT_SSTHRESH 65536.0   // 초기 임계값: 65536 바이트 (임의 설정)
+
+const cc_ops_t *const cc_algorithms[] = {
+    &cc_reno,
+    &cc_newreno,
+    &cc_cubic,
+    &cc_bbr,
+    NULL,
+};
+
+const cc_ops_t *cc_find(const char *name) {
+    for (const cc_ops_t *const *ops = cc_algorithms; *ops; ops++) {
+        if (strcmp((*ops)->name, name) == 0) return *ops;
+    }
+    return NULL;
+}
+
+void cc_init(cc_t *cc, const cc_ops_t *ops, uint32_t mss, bool sack, bool pace) {
+    memset(cc, 0, sizeof(*cc));
+    cc->ops = ops;
+    cc->mss = (double)mss;
+    cc->cwnd = (double)mss;    // 초기값: 1 MSS
+    cc->ssthresh = CC_INIT_SSTHRESH;
+    cc->sack = sack;
+    cc->pace = pace;
+    if (ops->init) ops->init(cc);
+}
+
+void cc_on_ack(cc_t *cc, const cc_ack_t *ack) {
+    if (ack->rtt_ns != 0) {
+        if (cc->min_rtt_ns == 0 || ack->rtt_ns < cc->min_rtt_ns) cc->min_rtt_ns = ack->rtt_ns;
+        // srtt only steers pacing here; the RTO keeps its own estimator
+        cc->srtt_ns = cc->srtt_ns == 0 ? ack->rtt_ns : (7 * cc->srtt_ns + ack->rtt_ns) / 8;
+    }
+    // Without SACK the pipe only shrinks on cumulative ACKs, so recovery
+    // inflates the window per dup ACK and deflates it on partial ACKs
+    // (RFC 5681 / RFC 6582). That is recovery mechanics, not the
+    // algorithm's response to congestion, so every algorithm gets it.
+    if (!cc->sack && ack->in_recovery) {
+        if (ack->kind == CC_ACK_DUP) {
+            cc->cwnd += cc->mss;
+        } else if (ack->kind == CC_ACK_PARTIAL) {
+            cc->cwnd -= (double)ack->acked_bytes;
+            if ((double)ack->acked_bytes >= cc->mss) cc->cwnd += cc->mss;
+        }
+    }
+    // A window the sender could not fill says nothing about the path, so
+    // it does not grow while the receiver is the limit (RFC 7661)
+    double before = cc->cwnd;
+    cc->ops->on_ack(cc, ack);
+    if (ack->rwnd_limited && cc->cwnd > before) cc->cwnd = before;
+    if (cc->cwnd < cc->mss) cc->cwnd = cc->mss;
+}
+
+void cc_on_loss(cc_t *cc, const cc_ack_t *ack) {
+    cc->ops->on_loss(cc, ack);
+    // Fast Recovery: 이미 받은 중복 ACK 3개만큼 (SACK이면 파이프가 대신함)
+    if (!cc->sack) cc->cwnd += 3.0 * cc->mss;
+    if (cc->cwnd < cc->mss) cc->cwnd = cc->mss;
+}
+
+void cc_on_repaired(cc_t *cc, const cc_ack_t *ack) {
+    cc->ops->on_loss(cc, ack);
+    if (cc->cwnd < cc->mss) cc->cwnd = cc->mss;
+}
+
+void cc_on_timeout(cc_t *cc) {
+    cc->ops->on_timeout(cc);
+    if (cc->cwnd < cc->mss) cc->cwnd = cc->mss;
+}
+
+double cc_pacing_rate(const cc_t *cc) {
+    if (cc->ops->pacing_rate) return cc->ops->pacing_rate(cc);
+    if (!cc->pace || cc->srtt_ns == 0) return 0.0;
+    // Window-based algorithms: spread cwnd over one srtt, with headroom so
+    // pacing never becomes the bottleneck (2x in slow start, 1.2x after)
+    double gain = cc->cwnd < cc->ssthresh ? 2.0 : 1.2;
+    return gain * cc->cwnd * 1e9 / (double)cc->srtt_ns;
+}
+
+void cc_reno_grow(cc_t *cc, uint32_t acked_segs) {
+    double mss = cc->mss;
+    if (cc->cwnd < cc->ssthresh) {
+        // Slow Start: ACK당 +MSS (지수적 증가)
+        cc->cwnd += mss * (double)acked_segs;
+    } else {
+        // Congestion Avoidance: ACK당 +MSS × (MSS / cwnd) (선형 증가)
+        cc->cwnd += mss * (mss / cc->cwnd) * (double)acked_segs;
+    }
+}
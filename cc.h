@@ -0,0 +1,115 @@
+#ifndef CC_H
+#define CC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Congestion control behind an ops table. The flow owns loss detection and
+// the recovery episode (dup ACK counting, SACK, recovery point); an
+// algorithm only turns those events into cwnd, ssthresh and optionally a
+// pacing rate. All window values are in bytes.
+
+enum {
+    CC_ACK_NEW = 0,     // cumulative ACK advanced outside recovery
+    CC_ACK_DUP,         // duplicate ACK (may carry new SACK information)
+    CC_ACK_PARTIAL,     // advanced, but below the recovery point
+    CC_ACK_RECOVERED,   // advanced past the recovery point: recovery ends
+};
+
+typedef struct {
+    uint8_t kind;
+    bool in_recovery;
+    uint64_t now_ns;
+    uint64_t acked_bytes;      // newly cumulatively acked
+    uint32_t acked_segs;
+    uint64_t sacked_bytes;     // newly selectively acked
+    uint64_t flight_bytes;     // sent, not yet acked or sacked (in flight + lost)
+    uint64_t rtt_ns;           // RTT sample, 0 if none (Karn's rule)
+    uint64_t delivered;        // total bytes delivered so far
+    uint64_t prior_delivered;  // delivered when the sampled segment was sent
+    double delivery_rate;      // bytes/s, 0 if this ACK gave no sample
+    bool rwnd_limited;         // the receive window, not cwnd, held the sender back
+} cc_ack_t;
+
+typedef struct cc cc_t;
+
+typedef struct {
+    const char *name;
+    const char *desc;
+    bool hold_recovery;        // partial ACKs keep recovery going (RFC 6582)
+    void (*init)(cc_t *cc);
+    void (*on_ack)(cc_t *cc, const cc_ack_t *ack);
+    void (*on_loss)(cc_t *cc, const cc_ack_t *ack);   // fast recovery starts
+    void (*on_timeout)(cc_t *cc);
+    double (*pacing_rate)(const cc_t *cc);            // bytes/s; NULL: window only
+} cc_ops_t;
+
+typedef struct {
+    double w_max;              // window before the last reduction
+    double w_last_max;         // for fast convergence
+    double k_s;                // time to climb back to w_max, seconds
+    double origin;             // plateau of the current curve
+    double w_est;              // Reno-friendly estimate
+    uint64_t epoch_ns;         // start of the current growth epoch, 0 if none
+} cc_cubic_t;
+
+#define CC_BBR_BW_ROUNDS 10
+
+typedef struct {
+    uint8_t mode;
+    double pacing_gain;
+    double cwnd_gain;
+    double bw_rounds[CC_BBR_BW_ROUNDS];   // per-round max delivery rate
+    double btl_bw;                        // windowed max of bw_rounds, bytes/s
+    uint64_t round;
+    uint64_t next_round_delivered;
+    bool round_start;
+    uint64_t min_rtt_ns;
+    uint64_t min_rtt_stamp_ns;
+    double full_bw;
+    uint32_t full_bw_rounds;
+    bool filled_pipe;
+    uint32_t cycle_idx;
+    uint64_t cycle_stamp_ns;
+    uint64_t probe_rtt_done_ns;
+    double prior_cwnd;
+} cc_bbr_t;
+
+struct cc {
+    const cc_ops_t *ops;
+    double mss;
+    double cwnd;
+    double ssthresh;
+    bool sack;                 // flow recovers from SACK (no window inflation)
+    bool pace;                 // pace window-based algorithms at cwnd / srtt
+    uint64_t min_rtt_ns;
+    uint64_t srtt_ns;
+    union {
+        cc_cubic_t cubic;
+        cc_bbr_t bbr;
+    } u;
+};
+
+extern const cc_ops_t cc_reno;
+extern const cc_ops_t cc_newreno;
+extern const cc_ops_t cc_cubic;
+extern const cc_ops_t cc_bbr;
+
+// NULL-terminated list of every algorithm, for lookup and usage text
+extern const cc_ops_t *const cc_algorithms[];
+
+const cc_ops_t *cc_find(const char *name);
+
+void cc_init(cc_t *cc, const cc_ops_t *ops, uint32_t mss, bool sack, bool pace);
+void cc_on_ack(cc_t *cc, const cc_ack_t *ack);
+void cc_on_loss(cc_t *cc, const cc_ack_t *ack);
+// A loss the receiver repaired by itself (FEC): the algorithm's response to
+// the loss, with no recovery episode and hence no window inflation
+void cc_on_repaired(cc_t *cc, const cc_ack_t *ack);
+void cc_on_timeout(cc_t *cc);
+double cc_pacing_rate(const cc_t *cc);
+
+// Shared Reno growth: slow start below ssthresh, else +MSS per window
+void cc_reno_grow(cc_t *cc, uint32_t acked_segs);
+
+#endif
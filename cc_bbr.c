@@ -0,0 +1,194 @@
+#include "cc.h"
+
+// BBR-style model-based control. Instead of reacting to loss it estimates
+// the bottleneck bandwidth (windowed max of delivery rate samples) and the
+// propagation delay (windowed min RTT), paces at gain × bandwidth and caps
+// inflight at gain × BDP. Modes follow BBR v1: STARTUP doubles the rate
+// each round until bandwidth stops growing, DRAIN empties the queue that
+// built, PROBE_BW cycles the pacing gain around 1, and PROBE_RTT briefly
+// shrinks inflight to refresh a stale min RTT.
+
+enum {
+    BBR_STARTUP = 0,
+    BBR_DRAIN,
+    BBR_PROBE_BW,
+    BBR_PROBE_RTT,
+};
+
+#define BBR_HIGH_GAIN 2.885           // 2/ln(2)
+#define BBR_MIN_RTT_WIN_NS 10000000000ull
+#define BBR_PROBE_RTT_NS 200000000ull
+#define BBR_MIN_CWND_SEGS 4.0
+#define BBR_FULL_BW_GROWTH 1.25
+#define BBR_FULL_BW_ROUNDS 3
+#define BBR_CYCLE_LEN 8
+
+static const double bbr_cycle_gain[BBR_CYCLE_LEN] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+static void bbr_init(cc_t *cc) {
+    cc_bbr_t *b = &cc->u.bbr;
+    b->mode = BBR_STARTUP;
+    b->pacing_gain = BBR_HIGH_GAIN;
+    b->cwnd_gain = BBR_HIGH_GAIN;
+}
+
+static double bbr_bdp(const cc_t *cc) {
+    const cc_bbr_t *b = &cc->u.bbr;
+    if (b->btl_bw <= 0.0 || b->min_rtt_ns == 0) return 0.0;
+    return b->btl_bw * (double)b->min_rtt_ns / 1e9;
+}
+
+static void bbr_enter_probe_bw(cc_t *cc, uint64_t now_ns) {
+    cc_bbr_t *b = &cc->u.bbr;
+    b->mode = BBR_PROBE_BW;
+    b->cwnd_gain = 2.0;
+    // Start anywhere but the draining phase; the round count is as good as random
+    b->cycle_idx = (uint32_t)(b->round % BBR_CYCLE_LEN);
+    if (b->cycle_idx == 1) b->cycle_idx = 2;
+    b->pacing_gain = bbr_cycle_gain[b->cycle_idx];
+    b->cycle_stamp_ns = now_ns;
+}
+
+static void bbr_update_model(cc_t *cc, const cc_ack_t *ack) {
+    cc_bbr_t *b = &cc->u.bbr;
+
+    // A round trip ends when data sent after the previous round end is delivered
+    b->round_start = false;
+    if (ack->delivery_rate > 0.0 && ack->prior_delivered >= b->next_round_delivered) {
+        b->next_round_delivered = ack->delivered;
+        b->round++;
+        b->round_start = true;
+        b->bw_rounds[b->round % CC_BBR_BW_ROUNDS] = 0.0;
+    }
+    if (ack->delivery_rate > 0.0) {
+        double *slot = &b->bw_rounds[b->round % CC_BBR_BW_ROUNDS];
+        if (ack->delivery_rate > *slot) *slot = ack->delivery_rate;
+        b->btl_bw = 0.0;
+        for (int i = 0; i < CC_BBR_BW_ROUNDS; i++) {
+            if (b->bw_rounds[i] > b->btl_bw) b->btl_bw = b->bw_rounds[i];
+        }
+    }
+
+    bool rtt_expired = b->min_rtt_ns != 0 && ack->now_ns - b->min_rtt_stamp_ns > BBR_MIN_RTT_WIN_NS;
+    if (ack->rtt_ns != 0 && (b->min_rtt_ns == 0 || ack->rtt_ns <= b->min_rtt_ns || rtt_expired)) {
+        b->min_rtt_ns = ack->rtt_ns;
+        b->min_rtt_stamp_ns = ack->now_ns;
+    }
+
+    // STARTUP is over once bandwidth grew less than 25% for three rounds
+    if (!b->filled_pipe && b->round_start) {
+        if (b->btl_bw >= b->full_bw * BBR_FULL_BW_GROWTH) {
+            b->full_bw = b->btl_bw;
+            b->full_bw_rounds = 0;
+        } else if (++b->full_bw_rounds >= BBR_FULL_BW_ROUNDS) {
+            b->filled_pipe = true;
+        }
+    }
+
+    double bdp = bbr_bdp(cc);
+    switch (b->mode) {
+    case BBR_STARTUP:
+        if (b->filled_pipe) {
+            b->mode = BBR_DRAIN;
+            b->pacing_gain = 1.0 / BBR_HIGH_GAIN;
+            b->cwnd_gain = BBR_HIGH_GAIN;
+        }
+        break;
+    case BBR_DRAIN:
+        if ((double)ack->flight_bytes <= bdp) bbr_enter_probe_bw(cc, ack->now_ns);
+        break;
+    case BBR_PROBE_BW: {
+        // Each gain phase lasts about one min RTT; cut the probe short once
+        // the queue it meant to build is there, the drain once it is gone
+        bool elapsed = ack->now_ns - b->cycle_stamp_ns > b->min_rtt_ns;
+        if (b->pacing_gain > 1.0) {
+            elapsed = elapsed && (double)ack->flight_bytes >= b->pacing_gain * bdp;
+        } else if (b->pacing_gain < 1.0) {
+            elapsed = elapsed || (double)ack->flight_bytes <= bdp;
+        }
+        if (elapsed) {
+            b->cycle_idx = (b->cycle_idx + 1) % BBR_CYCLE_LEN;
+            b->pacing_gain = bbr_cycle_gain[b->cycle_idx];
+            b->cycle_stamp_ns = ack->now_ns;
+        }
+        break;
+    }
+    case BBR_PROBE_RTT:
+        if (b->probe_rtt_done_ns == 0 && (double)ack->flight_bytes <= BBR_MIN_CWND_SEGS * cc->mss) {
+            b->probe_rtt_done_ns = ack->now_ns + BBR_PROBE_RTT_NS;
+        } else if (b->probe_rtt_done_ns != 0 && ack->now_ns >= b->probe_rtt_done_ns) {
+            b->min_rtt_stamp_ns = ack->now_ns;
+            if (cc->cwnd < b->prior_cwnd) cc->cwnd = b->prior_cwnd;
+            if (b->filled_pipe) {
+                bbr_enter_probe_bw(cc, ack->now_ns);
+            } else {
+                b->mode = BBR_STARTUP;
+                b->pacing_gain = BBR_HIGH_GAIN;
+                b->cwnd_gain = BBR_HIGH_GAIN;
+            }
+        }
+        break;
+    }
+
+    // Min RTT not refreshed for 10 s: drain the queue to measure it again
+    if (rtt_expired && b->mode != BBR_PROBE_RTT) {
+        b->mode = BBR_PROBE_RTT;
+        b->pacing_gain = 1.0;
+        b->prior_cwnd = cc->cwnd;
+        b->probe_rtt_done_ns = 0;
+    }
+}
+
+static void bbr_on_ack(cc_t *cc, const cc_ack_t *ack) {
+    cc_bbr_t *b = &cc->u.bbr;
+    bbr_update_model(cc, ack);
+
+    double min_cwnd = BBR_MIN_CWND_SEGS * cc->mss;
+    if (ack->kind == CC_ACK_RECOVERED && cc->cwnd < b->prior_cwnd) cc->cwnd = b->prior_cwnd;
+
+    double newly = (double)(ack->acked_bytes + ack->sacked_bytes);
+    double target = b->cwnd_gain * bbr_bdp(cc);
+    if (b->filled_pipe) {
+        cc->cwnd += newly;
+        if (target > 0.0 && cc->cwnd > target) cc->cwnd = target;
+    } else if (target == 0.0 || cc->cwnd < target) {
+        cc->cwnd += newly;
+    }
+    if (cc->cwnd < min_cwnd) cc->cwnd = min_cwnd;
+    if (b->mode == BBR_PROBE_RTT && cc->cwnd > min_cwnd) cc->cwnd = min_cwnd;
+}
+
+static void bbr_on_loss(cc_t *cc, const cc_ack_t *ack) {
+    cc_bbr_t *b = &cc->u.bbr;
+    // Loss is not a congestion signal for the model; conserve packets for
+    // the recovery episode and restore the window afterwards
+    b->prior_cwnd = cc->cwnd;
+    cc->cwnd = (double)ack->flight_bytes;
+    if (cc->cwnd < BBR_MIN_CWND_SEGS * cc->mss) cc->cwnd = BBR_MIN_CWND_SEGS * cc->mss;
+    cc->ssthresh = cc->cwnd;
+}
+
+static void bbr_on_timeout(cc_t *cc) {
+    cc_bbr_t *b = &cc->u.bbr;
+    if (cc->cwnd > b->prior_cwnd) b->prior_cwnd = cc->cwnd;
+    cc->cwnd = cc->mss;
+}
+
+static double bbr_pacing_rate(const cc_t *cc) {
+    const cc_bbr_t *b = &cc->u.bbr;
+    if (b->btl_bw > 0.0) return b->pacing_gain * b->btl_bw;
+    // No bandwidth sample yet: initial window over the first RTT seen
+    if (cc->srtt_ns == 0) return 0.0;
+    return b->pacing_gain * cc->cwnd * 1e9 / (double)cc->srtt_ns;
+}
+
+const cc_ops_t cc_bbr = {
+    .name = "bbr",
+    .desc = "BBR 방식: 병목 대역폭과 최소 RTT 모델로 페이싱 (손실에 반응하지 않음)",
+    .hold_recovery = true,
+    .init = bbr_init,
+    .on_ack = bbr_on_ack,
+    .on_loss = bbr_on_loss,
+    .on_timeout = bbr_on_timeout,
+    .pacing_rate = bbr_pacing_rate,
+};
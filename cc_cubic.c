@@ -0,0 +1,98 @@
+#include "cc.h"
+
+#include <math.h>
+
+// CUBIC (RFC 9438). After a reduction the window follows a cubic curve in
+// time since the loss: fast back toward the old maximum, flat around it,
+// then probing beyond. Growth depends on elapsed time rather than the ACK
+// clock, so long-RTT, high-BDP paths refill much faster than with Reno.
+
+#define CUBIC_C 0.4
+#define CUBIC_BETA 0.7
+
+// Multiplicative decrease shared by loss and timeout
+static void cubic_reduce(cc_t *cc) {
+    cc_cubic_t *c = &cc->u.cubic;
+    c->epoch_ns = 0;
+    // Fast convergence: yield bandwidth to newer flows when still shrinking
+    if (cc->cwnd < c->w_last_max) {
+        c->w_last_max = cc->cwnd;
+        c->w_max = cc->cwnd * (1.0 + CUBIC_BETA) / 2.0;
+    } else {
+        c->w_last_max = cc->cwnd;
+        c->w_max = cc->cwnd;
+    }
+    cc->ssthresh = cc->cwnd * CUBIC_BETA;
+    if (cc->ssthresh < 2.0 * cc->mss) cc->ssthresh = 2.0 * cc->mss;
+}
+
+static void cubic_on_loss(cc_t *cc, const cc_ack_t *ack) {
+    (void)ack;
+    cubic_reduce(cc);
+    cc->cwnd = cc->ssthresh;
+}
+
+static void cubic_on_timeout(cc_t *cc) {
+    cubic_reduce(cc);
+    cc->cwnd = cc->mss;
+}
+
+static void cubic_grow(cc_t *cc, const cc_ack_t *ack) {
+    cc_cubic_t *c = &cc->u.cubic;
+    double mss = cc->mss;
+    if (c->epoch_ns == 0) {
+        c->epoch_ns = ack->now_ns;
+        if (cc->cwnd < c->w_max) {
+            c->k_s = cbrt((c->w_max - cc->cwnd) / mss / CUBIC_C);
+            c->origin = c->w_max;
+        } else {
+            c->k_s = 0.0;
+            c->origin = cc->cwnd;
+        }
+        c->w_est = cc->cwnd;
+    }
+
+    // Aim one RTT ahead on the curve
+    double t = (double)(ack->now_ns - c->epoch_ns + cc->min_rtt_ns) / 1e9;
+    double d = t - c->k_s;
+    double target = c->origin + CUBIC_C * d * d * d * mss;
+    if (target > 1.5 * cc->cwnd) target = 1.5 * cc->cwnd;
+
+    // Reno-friendly region: never grow slower than standard TCP would
+    double alpha = 3.0 * (1.0 - CUBIC_BETA) / (1.0 + CUBIC_BETA);
+    c->w_est += alpha * mss * (mss / cc->cwnd) * (double)ack->acked_segs;
+    if (c->w_est > target) target = c->w_est;
+
+    if (target > cc->cwnd) {
+        cc->cwnd += (target - cc->cwnd) / cc->cwnd * mss * (double)ack->acked_segs;
+    } else {
+        cc->cwnd += 0.01 * mss * (mss / cc->cwnd) * (double)ack->acked_segs;
+    }
+}
+
+static void cubic_on_ack(cc_t *cc, const cc_ack_t *ack) {
+    switch (ack->kind) {
+    case CC_ACK_NEW:
+        if (cc->cwnd < cc->ssthresh) {
+            cc_reno_grow(cc, ack->acked_segs);
+        } else {
+            cubic_grow(cc, ack);
+        }
+        break;
+    case CC_ACK_RECOVERED:
+        // Leave recovery at the reduced window; the curve starts from here
+        cc->cwnd = cc->ssthresh;
+        break;
+    default:
+        break;
+    }
+}
+
+const cc_ops_t cc_cubic = {
+    .name = "cubic",
+    .desc = "CUBIC: 손실 이후 경과 시간의 3차 함수로 cwnd 증가 (RFC 9438)",
+    .hold_recovery = true,
+    .on_ack = cubic_on_ack,
+    .on_loss = cubic_on_loss,
+    .on_timeout = cubic_on_timeout,
+};
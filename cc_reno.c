@@ -0,0 +1,78 @@
+#include "cc.h"
+
+// TCP Reno (RFC 5681) and NewReno (RFC 6582). Both grow the same way; they
+// differ in how recovery ends. Reno leaves fast recovery on the first new
+// ACK, NewReno stays until everything outstanding at the loss is acked, so
+// several losses in one window cost one reduction and no timeout.
+
+static void reno_on_loss(cc_t *cc, const cc_ack_t *ack) {
+    (void)ack;
+    // 현재 cwnd의 절반을 ssthresh로 설정
+    cc->ssthresh = cc->cwnd / 2.0;
+    if (cc->ssthresh < cc->mss) cc->ssthresh = cc->mss;
+    cc->cwnd = cc->ssthresh;
+}
+
+static void reno_on_timeout(cc_t *cc) {
+    double mss = cc->mss;
+    cc->ssthresh = cc->cwnd / 2.0;
+    if (cc->ssthresh < mss) cc->ssthresh = mss;
+    cc->cwnd = mss; // 1 MSS로 초기화
+    // Slow Start로 시작하기 위해 ssthresh가 cwnd보다 크도록 보장
+    if (cc->ssthresh <= mss) cc->ssthresh = mss * 2.0;
+}
+
+static void reno_on_ack(cc_t *cc, const cc_ack_t *ack) {
+    double mss = cc->mss;
+    switch (ack->kind) {
+    case CC_ACK_NEW:
+        cc_reno_grow(cc, ack->acked_segs);
+        break;
+    case CC_ACK_RECOVERED: {
+        // Fast Recovery 종료 시: cwnd = max(ssthresh, inflight + 3*MSS)
+        // inflight를 고려하여 cwnd를 조정 (다음 데이터 전송 시 자연스럽게 MSS 단위로 맞춰짐)
+        double w = ack->flight_bytes > 0 ? (double)ack->flight_bytes + 3.0 * mss : cc->ssthresh;
+        if (w < cc->ssthresh) w = cc->ssthresh;
+        cc->cwnd = w;
+        // cwnd >= ssthresh이므로 바로 Congestion Avoidance 적용
+        cc->cwnd += mss * (mss / cc->cwnd) * (double)ack->acked_segs;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void newreno_on_ack(cc_t *cc, const cc_ack_t *ack) {
+    switch (ack->kind) {
+    case CC_ACK_NEW:
+        cc_reno_grow(cc, ack->acked_segs);
+        break;
+    case CC_ACK_RECOVERED: {
+        // Deflate: cwnd = min(ssthresh, FlightSize + MSS), avoiding a burst
+        double w = (double)ack->flight_bytes + cc->mss;
+        cc->cwnd = w < cc->ssthresh ? w : cc->ssthresh;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+const cc_ops_t cc_reno = {
+    .name = "reno",
+    .desc = "TCP Reno (기본)",
+    .hold_recovery = false,
+    .on_ack = reno_on_ack,
+    .on_loss = reno_on_loss,
+    .on_timeout = reno_on_timeout,
+};
+
+const cc_ops_t cc_newreno = {
+    .name = "newreno",
+    .desc = "NewReno: 부분 ACK에도 Fast Recovery 유지 (RFC 6582)",
+    .hold_recovery = true,
+    .on_ack = newreno_on_ack,
+    .on_loss = reno_on_loss,
+    .on_timeout = reno_on_timeout,
+};
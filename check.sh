@@ -0,0 +1,259 @@
+#!/bin/bash
+# 회귀 검사: 루프백 전송과 시뮬레이터로 알려진 문제가 다시 생기지 않는지 확인
+# 사용법: ./check.sh   (make check)
+cd "$(dirname "$0")"
+make > /dev/null 2>&1 || exit 1
+
+PORT=$((20000 + RANDOM % 20000))
+IN=$(mktemp /tmp/check_in.XXXXXX)
+OUT=$(mktemp /tmp/check_out.XXXXXX)
+trap 'rm -f "$IN" "$OUT" "$OUT.r" "$OUT.s" "$OUT.csv" "$OUT.bin" "$OUT.tx" "$OUT.rx" "$OUT.d"' EXIT
+FAILED=0
+
+pass() { echo "통과: $1"; }
+fail() {
+    echo "실패: $1"
+    sed 's/^/    /' "$2" | tail -20
+    FAILED=$((FAILED + 1))
+}
+
+# 루프백 전송 한 번: 수신측 손실 확률과 송신 옵션을 받아 파일과 다이제스트를 확인
+loopback() {
+    local name=$1 loss=$2
+    shift 2
+    ./receiver -q "$PORT" "$OUT" "$loss" > "$OUT.r" 2>&1 &
+    local rpid=$!
+    sleep 0.3
+    timeout 120 ./sender -q "$@" 127.0.0.1 "$PORT" "$IN" 1400 200 > "$OUT.s" 2>&1
+    sleep 0.3
+    kill "$rpid" 2>/dev/null
+    wait "$rpid" 2>/dev/null
+    PORT=$((PORT + 1))
+    if ! cmp -s "$IN" "$OUT"; then
+        fail "$name: 수신 파일이 원본과 다름" "$OUT.r"
+    elif ! grep -q '^파일 다이제스트.*일치' "$OUT.r"; then
+        fail "$name: 다이제스트 불일치 또는 검증 안 됨" "$OUT.r"
+    elif grep -q '수신측 확인: 아니오\|FIN이 확인되지' "$OUT.s"; then
+        fail "$name: FIN 확인 없음" "$OUT.s"
+    else
+        pass "$name"
+    fi
+}
+
+# 시뮬레이션 한 번: 전송을 끝내고 타임아웃이 max_rto번 이하인지 확인
+sim_rto() {
+    local name=$1 max_rto=$2
+    shift 2
+    ./sim "$@" > "$OUT.s" 2>&1
+    local rto
+    rto=$(sed -n 's/^타임아웃 횟수: \([0-9]*\).*/\1/p' "$OUT.s")
+    if ! grep -q '^전송 완료: 예' "$OUT.s"; then
+        fail "$name: 전송 미완료" "$OUT.s"
+    elif [ "${rto:-999}" -gt "$max_rto" ]; then
+        fail "$name: 타임아웃 ${rto}번 (허용 ${max_rto}번)" "$OUT.s"
+    else
+        pass "$name (타임아웃 ${rto}번)"
+    fi
+}
+
+# 시뮬레이션 한 번: 재전송한 세그먼트가 정방향 링크 손실의 125% 이하인지 확인.
+# 가짜 타임아웃은 go-back-N으로 윈도우를 통째로 다시 보내므로 여기서 드러난다 (MSS는 기본 1400)
+sim_retx() {
+    local name=$1
+    shift
+    ./sim "$@" > "$OUT.s" 2>&1
+    local retx loss
+    retx=$(sed -n 's/^재전송 바이트: \([0-9]*\).*/\1/p' "$OUT.s")
+    loss=$(sed -n 's/^정방향 링크:.*링크 손실 \([0-9]*\).*/\1/p' "$OUT.s")
+    retx=$(( (${retx:-0} + 1399) / 1400 ))
+    if ! grep -q '^전송 완료: 예' "$OUT.s"; then
+        fail "$name: 전송 미완료" "$OUT.s"
+    elif [ "$((retx * 100))" -gt "$((${loss:-0} * 125))" ]; then
+        fail "$name: 재전송 ${retx}개, 링크 손실 ${loss}개" "$OUT.s"
+    else
+        pass "$name (재전송 ${retx}개, 링크 손실 ${loss}개)"
+    fi
+}
+
+# 시뮬레이션 한 번: 가상 전송 시간이 max_ms 밀리초 이하인지 확인
+sim_time() {
+    local name=$1 max_ms=$2
+    shift 2
+    ./sim "$@" > "$OUT.s" 2>&1
+    local ms
+    ms=$(awk '/^가상 전송 시간:/ { printf "%d", $4 * 1000 }' "$OUT.s")
+    if ! grep -q '^전송 완료: 예' "$OUT.s"; then
+        fail "$name: 전송 미완료" "$OUT.s"
+    elif [ "${ms:-999999}" -gt "$max_ms" ]; then
+        fail "$name: ${ms} 밀리초 (허용 ${max_ms} 밀리초)" "$OUT.s"
+    else
+        pass "$name (${ms} 밀리초)"
+    fi
+}
+
+# 시뮬레이션 한 번: 정방향 링크가 FIN을 drop개 잃어도 재전송으로 확인받는지 확인
+sim_fin() {
+    local name=$1 drop=$2
+    shift 2
+    ./sim --drop-fin "$drop" "$@" > "$OUT.s" 2>&1
+    if ! grep -q "^FIN 송신: $((drop + 1))번 (수신측 확인: 예)" "$OUT.s"; then
+        fail "$name" "$OUT.s"
+    else
+        pass "$name"
+    fi
+}
+
+# 시뮬레이션 한 번: 꼬리 손실을 프로브로 찾아 타임아웃 없이 끝내는지 확인
+sim_tlp() {
+    local name=$1
+    shift
+    ./sim "$@" > "$OUT.s" 2>&1
+    if ! grep -q '^전송 완료: 예' "$OUT.s"; then
+        fail "$name: 전송 미완료" "$OUT.s"
+    elif ! grep -q '꼬리 손실 프로브 [1-9]' "$OUT.s" || ! grep -q '^타임아웃 횟수: 0' "$OUT.s"; then
+        fail "$name: 프로브 없이 또는 타임아웃으로 복구" "$OUT.s"
+    else
+        pass "$name"
+    fi
+}
+
+# 시뮬레이션 시계열: 켜도 이벤트 다이제스트가 같고, CSV와 바이너리를 변환한 결과가 같은지 확인
+sim_series() {
+    local name=$1
+    shift
+    ./sim "$@" > "$OUT.s" 2>&1
+    local plain
+    plain=$(grep '^이벤트 다이제스트' "$OUT.s")
+    ./sim --series "$OUT.csv" "$@" > "$OUT.s" 2>&1
+    ./sim --series "$OUT.bin" "$@" > /dev/null 2>&1
+    ./telemetry_dump -s "$OUT.bin" > "$OUT.d" 2>&1
+    if [ "$(grep '^이벤트 다이제스트' "$OUT.s")" != "$plain" ]; then
+        fail "$name: 시계열 기록이 시뮬레이션을 바꿈" "$OUT.s"
+    elif [ "$(wc -l < "$OUT.csv")" -lt 2 ] || ! cmp -s "$OUT.csv" "$OUT.d"; then
+        fail "$name: CSV와 바이너리 시계열이 다름" "$OUT.d"
+    else
+        pass "$name (샘플 $(($(wc -l < "$OUT.csv") - 1))개)"
+    fi
+}
+
+# 루프백 전송 중 통계 엔드포인트를 읽고, 끝난 뒤의 값이 최종 통계와 같은지 확인
+loopback_telemetry() {
+    local name=$1 loss=$2
+    ./receiver -q --stats "$OUT.rx" "$PORT" "$OUT" "$loss" > "$OUT.r" 2>&1 &
+    local rpid=$!
+    sleep 0.3
+    timeout 120 ./sender -q --stats "$OUT.tx" --series "$OUT.csv" --sample-ms 1 127.0.0.1 "$PORT" "$IN" 1400 200 > "$OUT.s" 2>&1 &
+    local spid=$!
+    for _ in $(seq 50); do
+        [ -s "$OUT.tx" ] && break
+        sleep 0.01
+    done
+    ./telemetry_dump -w 5 "$OUT.tx" > "$OUT.d" 2>&1
+    wait "$spid"
+    sleep 0.3
+    kill "$rpid" 2>/dev/null
+    wait "$rpid" 2>/dev/null
+    PORT=$((PORT + 1))
+    local tx rx dup drop
+    tx=$(./telemetry_dump "$OUT.tx")
+    rx=$(./telemetry_dump "$OUT.rx")
+    dup=$(sed -n 's/^중복 ACK 재전송: \([0-9]*\).*/\1/p' "$OUT.s")
+    drop=$(sed -n 's/^드롭된 패킷: \([0-9]*\).*/\1/p' "$OUT.r")
+    if ! cmp -s "$IN" "$OUT"; then
+        fail "$name: 수신 파일이 원본과 다름" "$OUT.r"
+    elif [ "$(grep -c 'done=0' "$OUT.d")" -lt 1 ]; then
+        fail "$name: 전송 중 통계를 읽지 못함" "$OUT.d"
+    elif ! echo "$tx" | grep -q "done=1 .* dup_ack_retransmits=$dup "; then
+        echo "$tx" > "$OUT.d"
+        fail "$name: 송신측 통계가 최종 값과 다름 (중복 ACK 재전송 $dup)" "$OUT.d"
+    elif ! echo "$rx" | grep -q "done=1 .* dropped_packets=$drop "; then
+        echo "$rx" > "$OUT.d"
+        fail "$name: 수신측 통계가 최종 값과 다름 (드롭 $drop)" "$OUT.d"
+    elif [ "$(wc -l < "$OUT.csv")" -lt 2 ]; then
+        fail "$name: 시계열이 비어 있음" "$OUT.s"
+    else
+        pass "$name (전송 중 $(grep -c 'done=0' "$OUT.d")번 읽음, 샘플 $(($(wc -l < "$OUT.csv") - 1))개)"
+    fi
+}
+
+# 서버 모드 통계는 워커 합계: 끝난 연결의 드롭 수 합과 같고, 종료 신호 뒤 done=1
+server_telemetry() {
+    local name=$1 loss=$2
+    local dir="$OUT.dir"
+    rm -rf "$dir"
+    mkdir -p "$dir"
+    ./receiver -S -W 2 --stats "$OUT.rx" --sample-ms 1 "$PORT" "$dir" "$loss" > "$OUT.r" 2>&1 &
+    local rpid=$!
+    sleep 0.3
+    for _ in 1 2; do
+        timeout 120 ./sender -q 127.0.0.1 "$PORT" "$IN" 1400 200 > "$OUT.s" 2>&1
+    done
+    sleep 0.3
+    local live
+    live=$(./telemetry_dump "$OUT.rx")
+    kill "$rpid" 2>/dev/null
+    wait "$rpid" 2>/dev/null
+    PORT=$((PORT + 1))
+    local rx drop conns size
+    rx=$(./telemetry_dump "$OUT.rx")
+    drop=$(sed -n 's/.*연결 .* 완료: .*(드롭 \([0-9]*\),.*/\1/p' "$OUT.r" | awk '{ s += $1 } END { print s + 0 }')
+    conns=$(grep -c '연결 .* 완료:' "$OUT.r")
+    size=$(($(stat -c %s "$IN") * 2))
+    if [ "$conns" -ne 2 ]; then
+        fail "$name: 연결 2개가 끝나지 않음" "$OUT.r"
+    elif ! echo "$live" | grep -q "done=0 bytes=$size "; then
+        echo "$live" > "$OUT.d"
+        fail "$name: 실행 중 통계가 두 연결의 합이 아님 ($size 바이트)" "$OUT.d"
+    elif ! echo "$rx" | grep -q "done=1 .* dropped_packets=$drop "; then
+        echo "$rx" > "$OUT.d"
+        fail "$name: 종료 후 통계가 연결별 합과 다름 (드롭 $drop)" "$OUT.d"
+    else
+        pass "$name (연결 ${conns}개, 드롭 $drop)"
+    fi
+    rm -rf "$dir"
+}
+
+echo "=== 시뮬레이터 ==="
+# Fast Retransmit이 cwnd에 막혀 대기하면 RTO가 먼저 만료되어 go-back-N으로 떨어진다
+sim_rto "1% 손실, 첫 재전송 즉시 송신 (시드 3)" 0 -s 3 -r 100 -d 10 -l 0.01 -R 30 10000000
+sim_rto "1% 손실, 첫 재전송 즉시 송신 (시드 7)" 0 -s 7 -r 100 -d 10 -l 0.01 -R 30 10000000
+sim_rto "1% 손실, 첫 재전송 즉시 송신, RACK 끔 (시드 3)" 0 --no-rack -s 3 -r 100 -d 10 -l 0.01 -R 30 10000000
+sim_rto "1% 손실, 첫 재전송 즉시 송신, RACK 끔 (시드 7)" 0 --no-rack -s 7 -r 100 -d 10 -l 0.01 -R 30 10000000
+# 다시 손실된 재전송은 DupThresh 규칙으로는 RTO까지 기다려야 한다 (RACK은 송신 시각으로 찾음)
+sim_rto "RACK, 3% 손실 (시드 1)" 0 -s 1 -l 0.03 10000000
+sim_rto "RACK, 3% 손실 (시드 4)" 0 -s 4 -l 0.03 10000000
+# 윈도우 전체가 손실되면 중복 ACK가 오지 않는다: 프로브가 없으면 RTO
+sim_tlp "꼬리 손실 프로브 (시드 40)" -s 40 -l 0.05 200000
+# 낮은 최소 RTO에서도 버스트 손실·순서 뒤바뀜이 가짜 타임아웃으로 번지지 않아야 한다:
+# 타임아웃 뒤의 늦은 ACK는 백오프를 풀지 않고, 재정렬은 RACK의 시간 창이 흡수한다
+sim_rto "버스트 손실과 순서 뒤바뀜, 기본 최소 RTO (시드 1)" 2 -s 1 -G 0.01,0.3 -O 0.05 10000000
+sim_rto "버스트 손실과 순서 뒤바뀜, 기본 최소 RTO (시드 3)" 2 -s 3 -G 0.01,0.3 -O 0.05 10000000
+sim_retx "버스트 손실과 순서 뒤바뀜, 재전송은 손실만큼 (시드 2)" -s 2 -G 0.01,0.3 -O 0.05 10000000
+sim_retx "버스트 손실과 순서 뒤바뀜, 재전송은 손실만큼 (시드 4)" -s 4 -G 0.01,0.3 -O 0.05 10000000
+# RTT 0.1ms 경로에서 RTO 바닥값이 RTT의 수천 배면 타임아웃마다 전송이 멈춘다
+sim_time "저지연 경로 1% 손실, 누적 ACK (시드 3)" 300 -s 3 -r 1000 -d 0.05 -l 0.01 -N 10000000
+# FIN을 한 번만 보내면 그것을 잃은 수신측은 전송이 끝난 줄 모른다
+sim_fin "FIN 2번 손실 후 재전송" 2 1000000
+sim_fin "FIN 손실, 1% 손실과 함께" 1 -s 5 -l 0.01 1000000
+sim_series "시계열 기록 (3% 손실)" -s 2 -l 0.03 --sample-ms 2 5000000
+
+dd if=/dev/urandom of="$IN" bs=1M count=8 2>/dev/null
+
+echo
+
+echo "=== 루프백 ==="
+loopback "손실 5%, SACK" 0.05
+# 패리티 버퍼가 TX 배치에 남아 있는 동안 다음 블록이 덮어쓰면 복구가 틀어진다
+loopback "손실 5%, FEC" 0.05 -F
+loopback "손실 5%, FEC 고정 블록 4" 0.05 --fec-k 4
+loopback "손실 5%, FEC, 흐름 3개" 0.05 -F -j 3
+loopback "손실 5%, FEC, GSO" 0.05 -F -g
+loopback_telemetry "손실 2%, 통계 엔드포인트와 시계열" 0.02
+server_telemetry "서버 모드 통계, 워커 2개 합계" 0.02
+
+echo
+if [ "$FAILED" -gt 0 ]; then
+    echo "실패 ${FAILED}개"
+    exit 1
+fi
+echo "모두 통과"
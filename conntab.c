@@ -0,0 +1,89 @@
+#include "conntab.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t key_hash(const conn_key_t *k) {
+    uint64_t x = ((uint64_t)k->addr << 32) ^ ((uint64_t)k->port << 16) ^ ((uint64_t)k->conn_id * 0x9e3779b97f4a7c15ull);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+int conntab_init(conntab_t *t, uint32_t cap) {
+    memset(t, 0, sizeof(*t));
+    if (cap < 16) cap = 16;
+    if ((cap & (cap - 1)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    t->slots = calloc(cap, sizeof(*t->slots));
+    if (!t->slots) return -1;
+    t->mask = cap - 1;
+    return 0;
+}
+
+void conntab_free(conntab_t *t) {
+    free(t->slots);
+    t->slots = NULL;
+    t->count = 0;
+}
+
+static uint32_t find_slot(const conntab_t *t, const conn_key_t *key, uint32_t hash) {
+    uint32_t i = hash & t->mask;
+    while (t->slots[i].val && !(t->slots[i].hash == hash && conn_key_eq(&t->slots[i].key, key))) {
+        i = (i + 1) & t->mask;
+    }
+    return i;
+}
+
+void *conntab_get(const conntab_t *t, const conn_key_t *key) {
+    return t->slots[find_slot(t, key, key_hash(key))].val;
+}
+
+static int grow(conntab_t *t) {
+    conntab_t bigger;
+    if (conntab_init(&bigger, (t->mask + 1) * 2) < 0) return -1;
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        if (!t->slots[i].val) continue;
+        bigger.slots[find_slot(&bigger, &t->slots[i].key, t->slots[i].hash)] = t->slots[i];
+    }
+    bigger.count = t->count;
+    free(t->slots);
+    *t = bigger;
+    return 0;
+}
+
+int conntab_put(conntab_t *t, const conn_key_t *key, void *val) {
+    if ((t->count + 1) * 2 > t->mask + 1 && grow(t) < 0) return -1;
+    uint32_t hash = key_hash(key);
+    uint32_t i = find_slot(t, key, hash);
+    if (!t->slots[i].val) t->count++;
+    t->slots[i].key = *key;
+    t->slots[i].hash = hash;
+    t->slots[i].val = val;
+    return 0;
+}
+
+void *conntab_del(conntab_t *t, const conn_key_t *key) {
+    uint32_t i = find_slot(t, key, key_hash(key));
+    void *val = t->slots[i].val;
+    if (!val) return NULL;
+    // Backward-shift: pull later entries of the run into the hole unless
+    // that would move them before their home slot
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & t->mask; t->slots[j].val; j = (j + 1) & t->mask) {
+        uint32_t home = t->slots[j].hash & t->mask;
+        if (((j - home) & t->mask) >= ((j - hole) & t->mask)) {
+            t->slots[hole] = t->slots[j];
+            hole = j;
+        }
+    }
+    t->slots[hole].val = NULL;
+    t->count--;
+    return val;
+}
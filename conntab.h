@@ -0,0 +1,44 @@
+#ifndef CONNTAB_H
+#define CONNTAB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Receiver connection table: open addressing with linear probing, keyed by
+// peer address, port and the sender's connection ID. Deletion shifts the
+// rest of the probe run back (no tombstones), so lookups stay short on a
+// server that keeps running across many transfers. One table per worker
+// thread; no locking.
+
+typedef struct {
+    uint32_t addr;          // IPv4, network byte order
+    uint32_t conn_id;
+    uint16_t port;          // network byte order
+} conn_key_t;
+
+typedef struct {
+    conn_key_t key;
+    uint32_t hash;
+    void *val;              // NULL: empty slot
+} conntab_slot_t;
+
+typedef struct {
+    conntab_slot_t *slots;
+    uint32_t mask;
+    uint32_t count;
+} conntab_t;
+
+int conntab_init(conntab_t *t, uint32_t cap);
+void conntab_free(conntab_t *t);
+
+void *conntab_get(const conntab_t *t, const conn_key_t *key);
+// Insert a new key (grows at half load)
+int conntab_put(conntab_t *t, const conn_key_t *key, void *val);
+// Remove and return the value, NULL when absent
+void *conntab_del(conntab_t *t, const conn_key_t *key);
+
+static inline bool conn_key_eq(const conn_key_t *a, const conn_key_t *b) {
+    return a->addr == b->addr && a->port == b->port && a->conn_id == b->conn_id;
+}
+
+#endif
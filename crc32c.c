@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include "crc32c.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define CRC32C_ARM 1
+#endif
+
+#define CRC32C_POLY 0x82f63b78u     // 0x1edc6f41 bit-reversed
+
+static uint32_t table[8][256];
+static uint32_t x2n_table[32];      // x^(2^n) mod P
+
+// ---- portable: slicing-by-8 ----
+
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        w ^= crc;
+        crc = table[7][w & 0xff] ^ table[6][(w >> 8) & 0xff] ^ table[5][(w >> 16) & 0xff] ^
+              table[4][(w >> 24) & 0xff] ^ table[3][(w >> 32) & 0xff] ^ table[2][(w >> 40) & 0xff] ^
+              table[1][(w >> 48) & 0xff] ^ table[0][w >> 56];
+        p += 8;
+        len -= 8;
+    }
+#endif
+    while (len-- > 0) crc = table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ---- hardware ----
+
+#if CRC32C_X86
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+    while (len > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        len--;
+    }
+#if defined(__x86_64__)
+    uint64_t c = crc;
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        c = _mm_crc32_u64(c, w);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c;
+#endif
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, sizeof(w));
+        crc = _mm_crc32_u32(crc, w);
+        p += 4;
+        len -= 4;
+    }
+    while (len-- > 0) crc = _mm_crc32_u8(crc, *p++);
+    return ~crc;
+}
+#endif
+
+#if CRC32C_ARM
+__attribute__((target("+crc"))) static uint32_t crc32c_armv8(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+    while (len > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = __crc32cb(crc, *p++);
+        len--;
+    }
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        crc = __crc32cd(crc, w);
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0) crc = __crc32cb(crc, *p++);
+    return ~crc;
+}
+#endif
+
+static uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t *p, size_t len) = crc32c_sw;
+static const char *crc32c_name = "테이블";
+
+// a * b mod P, both polynomials in the reflected bit order
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+// x^(n * 2^k) mod P
+static uint32_t x2nmodp(uint64_t n, unsigned k) {
+    uint32_t p = 1u << 31;          // x^0
+    while (n) {
+        if (n & 1) p = multmodp(x2n_table[k & 31], p);
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+// Tables and the implementation are settled before main, so threads
+// never race on them
+__attribute__((constructor)) static void crc32c_setup(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+    }
+    uint32_t p = 1u << 30;          // x^1
+    x2n_table[0] = p;
+    for (int n = 1; n < 32; n++) x2n_table[n] = p = multmodp(p, p);
+
+#if CRC32C_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc32c_fn = crc32c_sse42;
+        crc32c_name = "SSE4.2";
+    }
+#elif CRC32C_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        crc32c_fn = crc32c_armv8;
+        crc32c_name = "ARMv8 CRC";
+    }
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    return crc32c_fn(crc, data, len);
+}
+
+uint32_t crc32c_combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b) {
+    return multmodp(x2nmodp(len_b, 3), crc_a) ^ crc_b;
+}
+
+const char *crc32c_impl(void) {
+    return crc32c_name;
+}
+
+uint32_t packet_csum(const packet_header_t *hdr, const uint8_t *payload, size_t len) {
+    packet_header_t h = *hdr;
+    h.csum = 0;
+    uint32_t crc = crc32c(0, &h, sizeof(h));
+    if (payload && len > 0) crc = crc32c(crc, payload, len);
+    return crc ? crc : 0xffffffffu;
+}
+
+bool packet_csum_ok(const uint8_t *buf, size_t n) {
+    packet_header_t hdr;
+    if (n < sizeof(hdr)) return false;
+    memcpy(&hdr, buf, sizeof(hdr));
+    return packet_csum(&hdr, buf + sizeof(hdr), n - sizeof(hdr)) == ntohl(hdr.csum);
+}
+
+// ---- out-of-order stream ----
+
+void crc_stream_init(crc_stream_t *cs) {
+    memset(cs, 0, sizeof(*cs));
+}
+
+void crc_stream_free(crc_stream_t *cs) {
+    free(cs->heap);
+    cs->heap = NULL;
+    cs->count = cs->cap = 0;
+}
+
+static void heap_push(crc_stream_t *cs, crc_piece_t piece) {
+    if (cs->count == cs->cap) {
+        uint32_t cap = cs->cap ? cs->cap * 2 : 64;
+        crc_piece_t *heap = realloc(cs->heap, cap * sizeof(*heap));
+        if (!heap) {
+            cs->broken = true;
+            return;
+        }
+        cs->heap = heap;
+        cs->cap = cap;
+    }
+    uint32_t i = cs->count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (cs->heap[parent].off <= piece.off) break;
+        cs->heap[i] = cs->heap[parent];
+        i = parent;
+    }
+    cs->heap[i] = piece;
+}
+
+static void heap_pop(crc_stream_t *cs) {
+    crc_piece_t last = cs->heap[--cs->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= cs->count) break;
+        if (child + 1 < cs->count && cs->heap[child + 1].off < cs->heap[child].off) child++;
+        if (last.off <= cs->heap[child].off) break;
+        cs->heap[i] = cs->heap[child];
+        i = child;
+    }
+    if (cs->count > 0) cs->heap[i] = last;
+}
+
+void crc_stream_add(crc_stream_t *cs, uint64_t off, const uint8_t *data, uint32_t len) {
+    if (cs->broken || len == 0) return;
+    if (off < cs->pos) {
+        cs->broken = true;
+        return;
+    }
+    if (off > cs->pos) {
+        heap_push(cs, (crc_piece_t){.off = off, .len = len, .crc = crc32c(0, data, len)});
+        return;
+    }
+    cs->crc = crc32c(cs->crc, data, len);
+    cs->pos += len;
+    while (cs->count > 0 && cs->heap[0].off <= cs->pos) {
+        crc_piece_t piece = cs->heap[0];
+        heap_pop(cs);
+        if (piece.off != cs->pos) {
+            cs->broken = true;
+            return;
+        }
+        cs->crc = crc32c_combine(cs->crc, piece.crc, piece.len);
+        cs->pos += piece.len;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+// CRC32C (Castagnoli), the iSCSI/SCTP/ext4 checksum. The CRC instructions
+// of SSE4.2 or ARMv8 are used when the CPU has them, picked once at
+// startup; otherwise slicing-by-8 tables. Either way a single core runs it
+// at several GB/s, well ahead of the per-packet budget.
+
+// Extend crc (0 for an empty prefix) over len more bytes
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+// CRC of A followed by B from crc(A), crc(B) and the length of B
+uint32_t crc32c_combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b);
+// "SSE4.2", "ARMv8 CRC" or "테이블"
+const char *crc32c_impl(void);
+
+// packet_header_t.csum for a packet: CRC32C of the header (csum taken as
+// 0) and the payload. A result of 0 goes out as 0xffffffff, so 0 always
+// means "not computed".
+uint32_t packet_csum(const packet_header_t *hdr, const uint8_t *payload, size_t len);
+// Check a received packet (header + payload) against its csum field
+bool packet_csum_ok(const uint8_t *buf, size_t n);
+
+// CRC32C of a byte stream whose pieces may arrive out of order. Pieces
+// above the covered prefix wait in a min-heap with their own CRC and are
+// folded in with crc32c_combine once the prefix reaches them, so every
+// byte is read once. Pieces that overlap can't be folded; the stream is
+// then marked broken.
+typedef struct {
+    uint64_t off;
+    uint32_t len;
+    uint32_t crc;
+} crc_piece_t;
+
+typedef struct {
+    uint32_t crc;           // of [0, pos)
+    uint64_t pos;
+    crc_piece_t *heap;      // pieces above pos, ordered by off
+    uint32_t count;
+    uint32_t cap;
+    bool broken;
+} crc_stream_t;
+
+void crc_stream_init(crc_stream_t *cs);
+void crc_stream_free(crc_stream_t *cs);
+void crc_stream_add(crc_stream_t *cs, uint64_t off, const uint8_t *data, uint32_t len);
+
+#endif
@@ -0,0 +1,78 @@
+#include "eventq.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool ev_before(const eventq_ev_t *a, const eventq_ev_t *b) {
+    if (a->time_ns != b->time_ns) return a->time_ns < b->time_ns;
+    return a->order < b->order;
+}
+
+int eventq_init(eventq_t *q, size_t initial_cap) {
+    memset(q, 0, sizeof(*q));
+    if (initial_cap == 0) initial_cap = 64;
+    q->heap = malloc(initial_cap * sizeof(*q->heap));
+    if (!q->heap) return -1;
+    q->cap = initial_cap;
+    return 0;
+}
+
+void eventq_free(eventq_t *q) {
+    free(q->heap);
+    q->heap = NULL;
+    q->count = 0;
+    q->cap = 0;
+}
+
+int eventq_push(eventq_t *q, uint64_t time_ns, int kind, uint64_t tag, const void *data, uint32_t len) {
+    if (len > EVENTQ_DATA_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (q->count == q->cap) {
+        eventq_ev_t *grown = realloc(q->heap, q->cap * 2 * sizeof(*q->heap));
+        if (!grown) return -1;
+        q->heap = grown;
+        q->cap *= 2;
+    }
+    eventq_ev_t ev;
+    ev.time_ns = time_ns;
+    ev.order = q->next_order++;
+    ev.tag = tag;
+    ev.kind = kind;
+    ev.len = len;
+    if (len > 0) memcpy(ev.data, data, len);
+
+    // Sift up
+    size_t i = q->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!ev_before(&ev, &q->heap[parent])) break;
+        q->heap[i] = q->heap[parent];
+        i = parent;
+    }
+    q->heap[i] = ev;
+    q->pushed++;
+    if (q->count > q->max_count) q->max_count = q->count;
+    return 0;
+}
+
+bool eventq_pop(eventq_t *q, eventq_ev_t *out) {
+    if (q->count == 0) return false;
+    *out = q->heap[0];
+    eventq_ev_t last = q->heap[--q->count];
+
+    // Sift the last element down from the root
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= q->count) break;
+        if (child + 1 < q->count && ev_before(&q->heap[child + 1], &q->heap[child])) child++;
+        if (!ev_before(&q->heap[child], &last)) break;
+        q->heap[i] = q->heap[child];
+        i = child;
+    }
+    if (q->count > 0) q->heap[i] = last;
+    return true;
+}
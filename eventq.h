@@ -0,0 +1,46 @@
+#ifndef EVENTQ_H
+#define EVENTQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pending-event list for the discrete-event simulator: a binary min-heap
+// ordered by (time, insertion number). The insertion number breaks ties,
+// so events due at the same instant run in the order they were scheduled
+// and a run is reproducible bit for bit. Each event carries a small copy
+// of its data (a packet header, an ACK) instead of a pointer.
+
+#define EVENTQ_DATA_MAX 48
+
+typedef struct {
+    uint64_t time_ns;
+    uint64_t order;         // insertion number, tie-break
+    uint64_t tag;           // caller defined (timer generation, ...)
+    int kind;
+    uint32_t len;
+    uint8_t data[EVENTQ_DATA_MAX];
+} eventq_ev_t;
+
+typedef struct {
+    eventq_ev_t *heap;
+    size_t count;
+    size_t cap;
+    uint64_t next_order;
+    uint64_t pushed;
+    size_t max_count;
+} eventq_t;
+
+int eventq_init(eventq_t *q, size_t initial_cap);
+void eventq_free(eventq_t *q);
+
+// Schedule an event; data (len <= EVENTQ_DATA_MAX bytes) is copied
+int eventq_push(eventq_t *q, uint64_t time_ns, int kind, uint64_t tag, const void *data, uint32_t len);
+// Remove the earliest event into *out; false when empty
+bool eventq_pop(eventq_t *q, eventq_ev_t *out);
+
+static inline bool eventq_empty(const eventq_t *q) {
+    return q->count == 0;
+}
+
+#endif
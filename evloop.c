@@ -0,0 +1,156 @@
+#define _GNU_SOURCE
+#include "evloop.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t evloop_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void timers_fired(evloop_t *loop, uint32_t events, void *arg);
+
+int evloop_init(evloop_t *loop) {
+    memset(loop, 0, sizeof(*loop));
+    loop->tfd.fd = -1;
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd < 0) return -1;
+    loop->wheel = malloc(sizeof(*loop->wheel));
+    if (!loop->wheel) goto fail;
+    twheel_init(loop->wheel, evloop_now_ns());
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) goto fail;
+    if (evloop_add(loop, &loop->tfd, fd, EPOLLIN, timers_fired, loop) < 0) {
+        close(fd);
+        goto fail;
+    }
+    return 0;
+fail:
+    evloop_close(loop);
+    return -1;
+}
+
+void evloop_close(evloop_t *loop) {
+    if (loop->tfd.fd >= 0) close(loop->tfd.fd);
+    loop->tfd.fd = -1;
+    free(loop->wheel);
+    loop->wheel = NULL;
+    if (loop->epfd >= 0) close(loop->epfd);
+    loop->epfd = -1;
+}
+
+int evloop_add(evloop_t *loop, evloop_handler_t *h, int fd, uint32_t events, evloop_cb cb, void *arg) {
+    h->fd = fd;
+    h->cb = cb;
+    h->arg = arg;
+    struct epoll_event ev = { .events = events, .data.ptr = h };
+    return epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+int evloop_del(evloop_t *loop, evloop_handler_t *h) {
+    return epoll_ctl(loop->epfd, EPOLL_CTL_DEL, h->fd, NULL);
+}
+
+// Program the timerfd for the wheel's next non-empty tick; 0 disarms it
+static int tfd_set(evloop_t *loop, uint64_t deadline_ns) {
+    if (deadline_ns == loop->tfd_ns) return 0;
+    struct itimerspec its = {0};
+    its.it_value.tv_sec = (time_t)(deadline_ns / 1000000000ull);
+    its.it_value.tv_nsec = (long)(deadline_ns % 1000000000ull);
+    loop->timer_syscalls++;
+    if (timerfd_settime(loop->tfd.fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) return -1;
+    loop->tfd_ns = deadline_ns;
+    return 0;
+}
+
+// Run every timer the wheel has taken; a callback may arm or cancel any
+// timer, including one still waiting on the expired list. After
+// evloop_stop the rest wait for the next run.
+static void run_expired(evloop_t *loop) {
+    twheel_entry_t *e;
+    while (!loop->stop && (e = twheel_pop_expired(loop->wheel)) != NULL) {
+        evloop_timer_t *t = (evloop_timer_t *)e;
+        t->deadline_ns = 0;
+        t->cb(loop, EPOLLIN, t->arg);
+    }
+}
+
+static void timers_fired(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    uint64_t expirations;
+    (void)read(loop->tfd.fd, &expirations, sizeof(expirations));
+    loop->tfd_ns = 0;
+    twheel_advance(loop->wheel, evloop_now_ns());
+    run_expired(loop);
+    // An early wakeup (the slot held a later revolution, or its timer was
+    // cancelled) just finds the next one
+    if (tfd_set(loop, twheel_next_ns(loop->wheel)) < 0) loop->tfd_failed = true;
+}
+
+void evloop_timer_init(evloop_t *loop, evloop_timer_t *t, evloop_cb cb, void *arg) {
+    memset(t, 0, sizeof(*t));
+    t->loop = loop;
+    t->cb = cb;
+    t->arg = arg;
+}
+
+void evloop_timer_close(evloop_timer_t *t) {
+    evloop_timer_disarm(t);
+}
+
+int evloop_timer_arm_at(evloop_timer_t *t, uint64_t deadline_ns) {
+    if (deadline_ns == 0) deadline_ns = 1;
+    if (deadline_ns == t->deadline_ns) return 0;
+    evloop_t *loop = t->loop;
+    twheel_del(loop->wheel, &t->entry);
+    twheel_add(loop->wheel, &t->entry, deadline_ns);
+    t->deadline_ns = deadline_ns;
+    // Only an earlier wakeup needs the timerfd; a later one is found when
+    // the current one fires
+    uint64_t tick_ns = twheel_tick_ns(t->entry.tick);
+    if (loop->tfd_ns == 0 || tick_ns < loop->tfd_ns) return tfd_set(loop, tick_ns);
+    return 0;
+}
+
+int evloop_timer_arm(evloop_timer_t *t, uint64_t delay_ns) {
+    return evloop_timer_arm_at(t, evloop_now_ns() + delay_ns);
+}
+
+void evloop_timer_disarm(evloop_timer_t *t) {
+    if (t->loop && t->loop->wheel) twheel_del(t->loop->wheel, &t->entry);
+    t->deadline_ns = 0;
+}
+
+int evloop_run_once(evloop_t *loop, int timeout_ms) {
+    // Timers left over from a stopped run go first
+    run_expired(loop);
+    if (loop->stop) return 0;
+    struct epoll_event events[EVLOOP_MAX_EVENTS];
+    int n = epoll_wait(loop->epfd, events, EVLOOP_MAX_EVENTS, timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    loop->wakeups++;
+    for (int i = 0; i < n && !loop->stop; i++) {
+        evloop_handler_t *h = events[i].data.ptr;
+        h->cb(loop, events[i].events, h->arg);
+    }
+    return loop->tfd_failed ? -1 : n;
+}
+
+int evloop_run(evloop_t *loop) {
+    loop->stop = false;
+    while (!loop->stop) {
+        if (evloop_run_once(loop, -1) < 0) return -1;
+    }
+    return 0;
+}
+
+void evloop_stop(evloop_t *loop) {
+    loop->stop = true;
+}
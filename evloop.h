@@ -0,0 +1,76 @@
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include "twheel.h"
+
+// Single-threaded event loop on epoll. Every registered fd carries its own
+// handler, so a wakeup dispatches in O(1) no matter how many sockets and
+// flows one thread drives. Timers live in a hashed timer wheel (twheel.h)
+// behind a single timerfd on CLOCK_MONOTONIC: arming and cancelling one is
+// a list operation, not a syscall, and the timerfd is only reprogrammed
+// when the earliest deadline moves earlier or after it fires. A timer runs
+// at most one wheel tick (~65 us) after its deadline, never before.
+
+typedef struct evloop evloop_t;
+typedef void (*evloop_cb)(evloop_t *loop, uint32_t events, void *arg);
+
+typedef struct {
+    int fd;
+    evloop_cb cb;
+    void *arg;
+} evloop_handler_t;
+
+typedef struct {
+    twheel_entry_t entry;   // first: the wheel hands back this pointer
+    evloop_t *loop;
+    evloop_cb cb;
+    void *arg;
+    uint64_t deadline_ns;   // absolute CLOCK_MONOTONIC, 0 when disarmed
+} evloop_timer_t;
+
+#define EVLOOP_MAX_EVENTS 64
+
+struct evloop {
+    int epfd;
+    bool stop;
+    uint64_t wakeups;
+    twheel_t *wheel;
+    evloop_handler_t tfd;   // the one timerfd, armed for the wheel
+    uint64_t tfd_ns;        // its deadline, 0 when disarmed
+    bool tfd_failed;        // reprogramming it failed inside the loop
+    uint64_t timer_syscalls;
+};
+
+uint64_t evloop_now_ns(void);
+
+int evloop_init(evloop_t *loop);
+void evloop_close(evloop_t *loop);
+
+// Watch fd for events (EPOLLIN, EPOLLOUT, ...). h must outlive the registration.
+int evloop_add(evloop_t *loop, evloop_handler_t *h, int fd, uint32_t events, evloop_cb cb, void *arg);
+int evloop_del(evloop_t *loop, evloop_handler_t *h);
+
+// One-shot timer; cb runs once the deadline passes (events is EPOLLIN).
+// A timer is a wheel entry: only arming can fail, when the earlier
+// deadline has to go to the timerfd (-1 with errno from timerfd_settime).
+void evloop_timer_init(evloop_t *loop, evloop_timer_t *t, evloop_cb cb, void *arg);
+void evloop_timer_close(evloop_timer_t *t);
+int evloop_timer_arm_at(evloop_timer_t *t, uint64_t deadline_ns);
+int evloop_timer_arm(evloop_timer_t *t, uint64_t delay_ns);
+void evloop_timer_disarm(evloop_timer_t *t);
+
+static inline bool evloop_timer_armed(const evloop_timer_t *t) {
+    return t->deadline_ns != 0;
+}
+
+// Dispatch ready handlers once, waiting at most timeout_ms (-1: forever)
+int evloop_run_once(evloop_t *loop, int timeout_ms);
+// Dispatch until evloop_stop() is called from a handler
+int evloop_run(evloop_t *loop);
+void evloop_stop(evloop_t *loop);
+
+#endif
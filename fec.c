@@ -0,0 +1,228 @@
+#include "fec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+
+#define FEC_FREE UINT64_MAX
+
+// Two 16-byte lanes per step; the compiler maps them onto whatever vector
+// registers the target has (SSE2 at least on x86-64, NEON on aarch64)
+typedef uint64_t fec_vec_t __attribute__((vector_size(16)));
+
+void fec_xor(uint8_t *dst, const uint8_t *src, size_t len) {
+    while (len >= 32) {
+        fec_vec_t a0, a1, b0, b1;
+        memcpy(&a0, dst, 16);
+        memcpy(&a1, dst + 16, 16);
+        memcpy(&b0, src, 16);
+        memcpy(&b1, src + 16, 16);
+        a0 ^= b0;
+        a1 ^= b1;
+        memcpy(dst, &a0, 16);
+        memcpy(dst + 16, &a1, 16);
+        dst += 32;
+        src += 32;
+        len -= 32;
+    }
+    while (len >= 8) {
+        uint64_t a, b;
+        memcpy(&a, dst, 8);
+        memcpy(&b, src, 8);
+        a ^= b;
+        memcpy(dst, &a, 8);
+        dst += 8;
+        src += 8;
+        len -= 8;
+    }
+    while (len-- > 0) *dst++ ^= *src++;
+}
+
+// ---- sender ----
+
+int fec_enc_init(fec_enc_t *e, uint32_t seg, uint32_t fixed_k, bool payload) {
+    memset(e, 0, sizeof(*e));
+    e->seg = seg;
+    e->loss = FEC_LOSS_INIT;
+    if (fixed_k > 0) {
+        // Round down to a power of two in range
+        uint32_t k = FEC_K_MAX;
+        while (k > 1 && k > fixed_k) k /= 2;
+        e->fixed_k = k;
+    }
+    if (payload) {
+        e->bufs = malloc((size_t)seg * FEC_PARITY_BUFS);
+        if (!e->bufs) return -1;
+        e->parity = e->bufs;
+    }
+    return 0;
+}
+
+void fec_enc_free(fec_enc_t *e) {
+    free(e->bufs);
+    e->bufs = NULL;
+    e->parity = NULL;
+}
+
+static uint32_t k_for_loss(double loss) {
+    uint32_t k = FEC_K_MAX;
+    while (k > FEC_K_MIN && (double)k * loss > FEC_KP) k /= 2;
+    return k;
+}
+
+// Fold the segments sent since the last sample into the loss estimate
+static void loss_sample(fec_enc_t *e) {
+    if (e->sample_sent < FEC_LOSS_SAMPLE) return;
+    double rate = (double)e->sample_lost / (double)e->sample_sent;
+    if (rate > 1.0) rate = 1.0;
+    e->loss += (rate - e->loss) / 8.0;
+    e->sample_sent = 0;
+    e->sample_lost = 0;
+}
+
+uint8_t fec_enc_add(fec_enc_t *e, uint64_t seq, uint32_t len, const uint8_t *payload) {
+    if (e->n == 0) {
+        loss_sample(e);
+        uint64_t idx = seq / e->seg;
+        uint32_t k = 1;
+        if (len == e->seg) {
+            k = e->fixed_k ? e->fixed_k : k_for_loss(e->loss);
+            while (idx % k != 0) k /= 2;   // blocks start on a multiple of k
+        }
+        e->start = seq;
+        e->k = k;
+        e->plen = 0;
+    }
+    if (e->parity && payload) {
+        if (e->n == 0) {
+            memcpy(e->parity, payload, len);
+        } else {
+            fec_xor(e->parity, payload, len);
+        }
+    }
+    if (len > e->plen) e->plen = len;
+    e->n++;
+    e->sample_sent++;
+    e->data_bytes += len;
+    return (uint8_t)(FEC_DATA | __builtin_ctz(e->k));
+}
+
+void fec_enc_close(fec_enc_t *e, fec_parity_t *out) {
+    out->start = e->start;
+    out->len = e->plen;
+    out->fec = (uint8_t)(FEC_PARITY | (e->n - 1));
+    out->k = e->k;
+    out->data = e->parity;
+    e->blocks++;
+    e->parity_bytes += e->plen;
+    e->n = 0;
+    // The next block XORs into the next buffer, leaving this one to the batch
+    if (e->bufs) {
+        e->buf_idx = (e->buf_idx + 1) % FEC_PARITY_BUFS;
+        e->parity = e->bufs + (size_t)e->buf_idx * e->seg;
+    }
+}
+
+void fec_enc_loss(fec_enc_t *e, uint32_t segs) {
+    e->sample_lost += segs;
+}
+
+// ---- receiver ----
+
+int fec_dec_init(fec_dec_t *d, uint32_t slots) {
+    memset(d, 0, sizeof(*d));
+    d->slots = calloc(slots, sizeof(*d->slots));
+    if (!d->slots) return -1;
+    d->mask = slots - 1;
+    for (uint32_t i = 0; i < slots; i++) d->slots[i].start = FEC_FREE;
+    return 0;
+}
+
+void fec_dec_free(fec_dec_t *d) {
+    if (!d->slots) return;
+    for (uint32_t i = 0; i <= d->mask; i++) free(d->slots[i].acc);
+    free(d->slots);
+    d->slots = NULL;
+}
+
+// The block at start, set up afresh (evicting an older block from the
+// slot) if it isn't tracked. NULL when the slot holds a newer block or the
+// buffer can't be had.
+static fec_block_t *block_get(fec_dec_t *d, uint64_t start, uint32_t seg, bool payload) {
+    fec_block_t *b = &d->slots[(uint32_t)((start * 0x9e3779b97f4a7c15ull) >> 32) & d->mask];
+    if (b->start == start && b->seg == seg) return b;
+    // A finished block keeps its slot until a newer one needs it, so a
+    // parity or data packet straggling in after it does not open it again
+    if (b->start != FEC_FREE && b->start > start) return NULL;
+    if (payload && b->acc_cap < seg) {
+        uint8_t *acc = realloc(b->acc, seg);
+        if (!acc) return NULL;
+        b->acc = acc;
+        b->acc_cap = seg;
+    }
+    if (payload) memset(b->acc, 0, seg);
+    b->start = start;
+    b->seg = seg;
+    b->k = 0;
+    b->n = 0;
+    b->have = 0;
+    b->done = false;
+    return b;
+}
+
+// With the parity in, one missing segment is the accumulated XOR
+static bool block_try_repair(fec_block_t *b, fec_repair_t *out) {
+    if (b->n == 0) {
+        // Everything a full block can hold arrived: no parity needed
+        if (b->k > 0 && (uint32_t)__builtin_popcountll(b->have) == b->k) b->done = true;
+        return false;
+    }
+    uint64_t all = b->n == 64 ? UINT64_MAX : (1ull << b->n) - 1;
+    uint32_t missing = b->n - (uint32_t)__builtin_popcountll(b->have & all);
+    if (missing == 0) {
+        b->done = true;
+        return false;
+    }
+    if (missing > 1) return false;
+    uint32_t i = (uint32_t)__builtin_ctzll(~b->have & all);
+    out->off = b->start + (uint64_t)i * b->seg;
+    out->len = b->seg;
+    out->data = b->acc;
+    b->have |= 1ull << i;
+    b->done = true;
+    return true;
+}
+
+bool fec_dec_data(fec_dec_t *d, uint64_t off, uint32_t len, uint8_t fec, const uint8_t *payload, fec_repair_t *out) {
+    uint32_t shift = fec & FEC_ARG_MASK;
+    if (!(fec & FEC_DATA) || len == 0 || (1u << shift) > FEC_K_MAX) return false;
+    uint32_t k = 1u << shift;
+    uint64_t start = off;
+    if (k > 1) {
+        if (off % len != 0) return false;
+        start = (off / len) & ~(uint64_t)(k - 1);
+        start *= len;
+    }
+    fec_block_t *b = block_get(d, start, len, payload != NULL);
+    if (!b || b->done) return false;
+    uint64_t bit = 1ull << ((off - start) / len);
+    if (b->have & bit) return false;
+    b->have |= bit;
+    b->k = k;
+    if (payload) fec_xor(b->acc, payload, len);
+    return block_try_repair(b, out);
+}
+
+bool fec_dec_parity(fec_dec_t *d, uint64_t start, uint32_t len, uint8_t fec, const uint8_t *payload, fec_repair_t *out) {
+    uint32_t n = (fec & FEC_ARG_MASK) + 1;
+    if (!(fec & FEC_PARITY) || len == 0 || n > FEC_K_MAX) return false;
+    d->parity_packets++;
+    fec_block_t *b = block_get(d, start, len, payload != NULL);
+    if (!b || b->done || b->n != 0) return false;   // a duplicate would cancel itself out
+    b->n = n;
+    if (payload) fec_xor(b->acc, payload, len);
+    bool repaired = block_try_repair(b, out);
+    if (!repaired && !b->done) d->multi_loss++;
+    return repaired;
+}
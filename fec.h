@@ -0,0 +1,126 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward error correction over blocks of data segments. The sender XORs
+// the first transmission of every segment of a block into one parity
+// packet; a receiver missing exactly one segment of the block gets it back
+// as the XOR of the parity and the segments it has, without waiting a
+// round trip for the retransmission.
+//
+// A block is k segments (a power of two up to FEC_K_MAX) starting at a
+// segment index that is a multiple of k, so a data packet only has to name
+// its k for the receiver to know which block it belongs to. Blocks hold
+// full-sized segments; the short last segment of a flow is a block of its
+// own (k = 1, the parity is a copy). The parity packet starts at the
+// block's first byte and says how many segments the block ended up with.
+//
+// The receiver never keeps segments, only one running XOR per open block,
+// so its memory is a segment per block in flight rather than the window.
+//
+// k follows the loss rate: the sender counts the segments it found lost
+// plus those the receiver reports rebuilt (it never sees those lost) and
+// picks the largest k with k * loss <= FEC_KP. One parity per k segments
+// is then set against blocks that lose two, which still need the usual
+// retransmission.
+
+#define FEC_K_MIN 2
+#define FEC_K_MAX 64            // fits the receiver's per-block bitmap
+#define FEC_KP 0.2              // k * loss target: ~2% of blocks lose two
+#define FEC_LOSS_INIT 0.01      // until the first sample (k = 16)
+#define FEC_LOSS_SAMPLE 64      // new segments per loss sample
+#define FEC_DEC_SLOTS 4096      // receiver blocks tracked, power of two
+#define FEC_PARITY_BUFS 16      // closed parities that may wait in a TX batch
+
+// ---- sender ----
+
+typedef struct {
+    uint32_t seg;           // full segment size (the MSS)
+    uint32_t fixed_k;       // 0: follow the loss rate
+    uint8_t *bufs;          // FEC_PARITY_BUFS parities; NULL without payloads
+    uint8_t *parity;        // the open block's, one of bufs
+    uint32_t buf_idx;
+    uint64_t start;         // first byte of the open block
+    uint32_t k;             // its length in segments (also the latest k)
+    uint32_t n;             // segments in it so far, 0 when none is open
+    uint32_t plen;          // parity bytes in use
+
+    double loss;            // EWMA of per-sample loss rates
+    uint64_t sample_sent;   // new segments since the last sample
+    uint64_t sample_lost;   // losses reported meanwhile
+    uint64_t blocks;        // parity packets sent
+    uint64_t parity_bytes;
+    uint64_t data_bytes;    // protected payload
+} fec_enc_t;
+
+// Parity of a closed block; data is NULL without payloads. The packet may
+// sit in a TX batch: its buffer is only reused FEC_PARITY_BUFS - 1 blocks
+// later, so the caller flushes before that many are queued.
+typedef struct {
+    uint64_t start;
+    uint32_t len;
+    uint8_t fec;            // FEC_PARITY | segments - 1
+    uint32_t k;
+    const uint8_t *data;
+} fec_parity_t;
+
+int fec_enc_init(fec_enc_t *e, uint32_t seg, uint32_t fixed_k, bool payload);
+void fec_enc_free(fec_enc_t *e);
+
+// A new segment goes out: open a block if none is, fold it in and return
+// the data packet's fec byte. A short segment must find no block open.
+uint8_t fec_enc_add(fec_enc_t *e, uint64_t seq, uint32_t len, const uint8_t *payload);
+// Close the open block (full, or the data ran out) into its parity
+void fec_enc_close(fec_enc_t *e, fec_parity_t *out);
+// Segments found lost or reported rebuilt
+void fec_enc_loss(fec_enc_t *e, uint32_t segs);
+
+static inline bool fec_enc_full(const fec_enc_t *e) {
+    return e->n > 0 && e->n == e->k;
+}
+
+// ---- receiver ----
+
+typedef struct {
+    uint64_t start;         // first byte; UINT64_MAX when the slot is free
+    uint32_t seg;
+    uint32_t k;             // from the data packets (0 until one arrived)
+    uint32_t n;             // from the parity (0 until it arrived)
+    uint64_t have;          // bit i: segment at start + i * seg taken in
+    bool done;              // complete or repaired: later packets are stale
+    uint8_t *acc;           // XOR of those and the parity, seg bytes
+    uint32_t acc_cap;
+} fec_block_t;
+
+typedef struct {
+    fec_block_t *slots;     // by hash of the block start; a newer block evicts
+    uint32_t mask;
+    uint64_t parity_packets;
+    uint64_t repaired;      // rebuilt segments that brought new bytes (the caller counts)
+    uint64_t multi_loss;    // parity found two or more segments missing
+} fec_dec_t;
+
+// Segment rebuilt from a parity; data is NULL without payloads and valid
+// until the next call
+typedef struct {
+    uint64_t off;
+    uint32_t len;
+    const uint8_t *data;
+} fec_repair_t;
+
+int fec_dec_init(fec_dec_t *d, uint32_t slots);
+void fec_dec_free(fec_dec_t *d);
+
+// A data segment taken in for the first time, with its header's fec byte.
+// Returns true with *out filled when it completes a repair.
+bool fec_dec_data(fec_dec_t *d, uint64_t off, uint32_t len, uint8_t fec, const uint8_t *payload, fec_repair_t *out);
+// A parity packet for the block at start
+bool fec_dec_parity(fec_dec_t *d, uint64_t start, uint32_t len, uint8_t fec, const uint8_t *payload, fec_repair_t *out);
+
+// dst ^= src
+void fec_xor(uint8_t *dst, const uint8_t *src, size_t len);
+
+#endif
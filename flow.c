@@ -0,0 +1,677 @@
+#define _GNU_SOURCE
+#include "flow.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "crc32c.h"
+#include "protocol.h"
+
+#define RELEASE_CHUNK (8u * 1024 * 1024) // acked bytes between madvise(DONTNEED) calls
+
+// Drop fully acked pages from our address space so RSS stays flat
+static void input_release(input_map_t *in, uint64_t acked_bytes) {
+    if (!in->mapped) return;
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t upto = acked_bytes & ~(page - 1);
+    if (upto < in->released + RELEASE_CHUNK && acked_bytes < in->size) return;
+    if (upto > in->released) {
+        (void)madvise((void *)(in->data + in->released), (size_t)(upto - in->released), MADV_DONTNEED);
+        in->released = upto;
+    }
+}
+
+// Trace one event with the window state after it
+static void flow_trace(flow_t *f, uint8_t type, uint64_t seq, uint32_t len, uint64_t arg, int32_t aux) {
+    if (f->trace.mode == TRACE_OFF) return;
+    trace_rec_t rec = {0};
+    rec.ts_ns = f->io.now_ns(f->io.ctx);
+    rec.type = type;
+    rec.seq = seq;
+    rec.len = len;
+    rec.arg = arg;
+    rec.aux = aux;
+    rec.cwnd = (uint32_t)lround(f->cc.cwnd);
+    rec.ssthresh = (uint32_t)lround(f->cc.ssthresh);
+    trace_write(&f->trace, &rec);
+}
+
+// ACK frequency to ask for: the configured ratio, but never so stretched
+// that fewer than FLOW_ACKS_PER_WINDOW ACKs come back per window (a small
+// window, cwnd or the receiver's, would otherwise stall on the receiver's
+// delayed ACK timer)
+static uint8_t ack_freq_hint(const flow_t *f) {
+    double wnd = f->cc.cwnd < (double)f->rwnd ? f->cc.cwnd : (double)f->rwnd;
+    uint32_t by_window = (uint32_t)(wnd / ((double)f->mss * FLOW_ACKS_PER_WINDOW));
+    uint32_t freq = by_window < f->ack_freq ? by_window : f->ack_freq;
+    if (freq < 1) freq = 1;
+    return (uint8_t)(freq << ACK_FREQ_SHIFT);
+}
+
+// Push the TX batch out; queued parities no longer hold their buffers
+static void flow_flush(flow_t *f) {
+    f->io.flush(f->io.ctx);
+    f->fec_queued = 0;
+}
+
+// Close the open FEC block, whose last segment is idx, and send its parity
+// (never retransmitted)
+static void send_parity(flow_t *f, uint64_t idx) {
+    fec_parity_t par;
+    fec_enc_close(&f->fec, &par);
+    packet_header_t hdr;
+    hdr.conn_id = htonl(f->conn_id);
+    hdr.seq = htonl((uint32_t)par.start);
+    hdr.len = htonl(par.len);
+    hdr.flags = 0;
+    hdr.csum = 0;
+    hdr.fec = par.fec;
+    f->io.send(f->io.ctx, &hdr, sizeof(hdr), par.data, par.len);
+    sb_parity_sent(&f->sb, idx, par.len);
+    flow_trace(f, TR_FEC_PARITY, par.start, par.len, (par.fec & FEC_ARG_MASK) + 1u, (int32_t)par.k);
+    // The batch points into the encoder's parity buffers; go out before
+    // it wraps around to one still queued
+    if (par.data && ++f->fec_queued >= FEC_PARITY_BUFS - 1) flow_flush(f);
+}
+
+// Queue a segment on the TX batch; it goes out with the next flush
+static void send_segment(flow_t *f, segment_t *seg, bool is_retransmit, bool has_timer) {
+    packet_header_t hdr;
+    hdr.conn_id = htonl(f->conn_id);
+    hdr.seq = htonl((uint32_t)seg->seq);
+    hdr.len = htonl(seg->len);
+    hdr.flags = ack_freq_hint(f);
+    hdr.csum = 0;
+    hdr.fec = 0;
+    const uint8_t *payload = f->in.data ? f->in.data + seg->seq : NULL;
+    if (f->use_digest && payload && seg->seq == f->digest_pos) {
+        f->digest = crc32c(f->digest, payload, seg->len);
+        f->digest_pos += seg->len;
+    }
+    // First sends go out in order, so they are what the blocks are made
+    // of; a retransmission names the same block so the receiver can still
+    // count it towards the block
+    uint64_t idx = seg->seq / (uint64_t)f->mss;
+    bool fec = f->use_fec && !is_retransmit;
+    if (fec) {
+        if (seg->len < (uint32_t)f->mss && f->fec.n > 0) send_parity(f, idx - 1);
+        seg->fec = fec_enc_add(&f->fec, seg->seq, seg->len, payload);
+    }
+    hdr.fec = seg->fec;
+    f->io.send(f->io.ctx, &hdr, sizeof(hdr), payload, seg->len);
+    if (is_retransmit) {
+        flow_trace(f, TR_RETRANSMIT, seg->seq, seg->len, 0, 0);
+    } else {
+        flow_trace(f, TR_SEND, seg->seq, seg->len, 0, has_timer);
+    }
+    if (fec && (fec_enc_full(&f->fec) || seg->seq + seg->len >= f->sb.end_seq)) send_parity(f, idx);
+}
+
+// Persist timer (RFC 9293 3.8.6.1): the RTO, doubled per unanswered probe
+static uint64_t persist_interval(const flow_t *f) {
+    uint64_t ivl = f->rtt.rto_ns;
+    for (uint32_t i = 0; i < f->persist_backoff && ivl < RTT_MAX_RTO_NS; i++) ivl *= 2;
+    return ivl < RTT_MAX_RTO_NS ? ivl : RTT_MAX_RTO_NS;
+}
+
+// Probe timeout (RFC 8985 7.2): two SRTTs, plus the receiver's delayed ACK
+// when a lone segment in flight cannot make it answer at once. The slack
+// (Linux's TCP_TIMEOUT_MIN) keeps a receiver that stalls for a moment on a
+// microsecond-RTT path such as loopback from drawing a probe every time.
+static uint64_t tlp_pto(const flow_t *f) {
+    uint64_t pto = 2 * f->rtt.srtt_ns + FLOW_TLP_SLACK_NS;
+    if (f->sb.bytes_in_flight <= (uint64_t)f->mss) pto += FLOW_TLP_ACK_DELAY_NS;
+    return pto;
+}
+
+// One probe per episode, and none while recovery or a backed-off RTO is
+// already repairing the window
+static bool tlp_allowed(const flow_t *f) {
+    return f->use_rack && !f->in_fast_recovery && f->tlp_end_seq == 0 && f->rtt.srtt_ns != 0 &&
+           f->rtt.backoffs == 0 && f->sb.gbn_cursor >= f->sb.gbn_end && f->sb.bytes_in_flight > 0;
+}
+
+// Arm the RTO slot for the earliest of the RACK reordering deadline, the
+// tail loss probe and the RTO (timer_start_ns + RTO)
+static void flow_arm_loss_timer(flow_t *f) {
+    uint64_t deadline = f->timer_start_ns != 0 ? f->timer_start_ns + f->rtt.rto_ns : 0;
+    uint8_t kind = FLOW_LOSS_RTO;
+    if (f->rack_deadline_ns != 0 && (deadline == 0 || f->rack_deadline_ns < deadline)) {
+        deadline = f->rack_deadline_ns;
+        kind = FLOW_LOSS_RACK;
+    } else if (deadline != 0 && tlp_allowed(f)) {
+        uint64_t pto = f->tlp_base_ns + tlp_pto(f);
+        if (pto < deadline) {
+            deadline = pto;
+            kind = FLOW_LOSS_TLP;
+        }
+    }
+    f->loss_timer = kind;
+    if (deadline == f->loss_deadline_ns) return;
+    f->loss_deadline_ns = deadline;
+    f->io.timer(f->io.ctx, FLOW_TIMER_RTO, deadline);
+}
+
+// Send as much as allowed by cwnd (바이트 단위) and the receive window,
+// flush the burst and re-arm the loss timer
+void flow_pump(flow_t *f) {
+    if (f->done) return;
+    uint64_t now_ns = f->io.now_ns(f->io.ctx);
+    double rate = cc_pacing_rate(&f->cc);   // bytes/s, 0 when not paced
+    bool paced_out = false;
+    bool wnd_blocked = false;
+
+    // Pipe is tracked incrementally by the scoreboard; no window rescan
+    while (f->sb.bytes_in_flight + f->sb.bytes_parity < (uint64_t)f->cc.cwnd) {
+        if (rate > 0.0 && f->pace_next_ns > now_ns + FLOW_PACE_QUANTUM_NS) {
+            paced_out = true;
+            break;
+        }
+        bool retransmit;
+        bool timer_running = f->timer_start_ns != 0;
+        segment_t *seg = sb_take_next(&f->sb, &retransmit);
+        if (!seg) {
+            wnd_blocked = sb_wnd_blocked(&f->sb);
+            break;
+        }
+        sb_stamp(&f->sb, seg, now_ns);
+        send_segment(f, seg, retransmit, timer_running);
+        if (retransmit) {
+            f->retransmitted_bytes += seg->len;
+        } else {
+            f->tlp_base_ns = now_ns;
+        }
+        // The RTO guards the oldest segment: once that is sent again, it
+        // runs from the new copy (as Linux rearms on the head's
+        // retransmission), or a low floor fires just after RACK repaired it
+        if (!timer_running || (retransmit && seg->seq == f->sb.snd_una)) f->timer_start_ns = now_ns;
+        if (rate > 0.0) {
+            if (f->pace_next_ns < now_ns) f->pace_next_ns = now_ns;
+            f->pace_next_ns += (uint64_t)((double)seg->len * 1e9 / rate);
+        }
+    }
+
+    // Whole burst goes out at once (as few sendmmsg calls as possible)
+    flow_flush(f);
+
+    // Ahead of the pacing schedule: come back when the next quantum is due
+    if (paced_out) f->io.timer(f->io.ctx, FLOW_TIMER_PACE, f->pace_next_ns - FLOW_PACE_QUANTUM_NS);
+    flow_arm_loss_timer(f);
+
+    // Held by the receiver, not by cwnd. With data outstanding its ACKs
+    // (or the RTO) bring the next window; with none, probe for it.
+    if (wnd_blocked && !f->rwnd_limited) f->rwnd_stalls++;
+    f->rwnd_limited = wnd_blocked;
+    bool persist = wnd_blocked && sb_idle(&f->sb);
+    if (persist && !f->persist_armed) {
+        f->io.timer(f->io.ctx, FLOW_TIMER_PERSIST, now_ns + persist_interval(f));
+        f->persist_armed = true;
+    } else if (!persist && f->persist_armed) {
+        f->io.timer(f->io.ctx, FLOW_TIMER_PERSIST, 0);
+        f->persist_armed = false;
+    }
+    if (!wnd_blocked) f->persist_backoff = 0;
+}
+
+static void flow_on_timeout(flow_t *f) {
+    // timeout -> loss detected
+    f->timeout_count++;
+    f->total_retransmits++;
+    cc_on_timeout(&f->cc);
+    f->in_fast_recovery = false;
+    // Exponential backoff until a fresh (never retransmitted) segment is acked
+    rtt_backoff(&f->rtt, f->io.now_ns(f->io.ctx));
+    if (f->use_fec) fec_enc_loss(&f->fec, 1);
+    flow_trace(f, TR_TIMEOUT, f->sb.snd_una, 0, f->rtt.rto_ns, (int32_t)f->rtt.backoffs);
+    // 미확인 세그먼트 전체를 손실로 처리: 가장 오래된 것부터 cwnd 만큼씩 재전송 (go-back-N)
+    sb_timeout(&f->sb);
+    f->timer_start_ns = f->io.now_ns(f->io.ctx);
+    f->dup_ack_count = 0;
+    f->rack_deadline_ns = 0;
+    f->tlp_end_seq = 0;
+}
+
+// Wire seq/ack values are 32-bit; extend to a 64-bit file offset relative to the last ACK
+static uint64_t flow_extend_seq(const flow_t *f, uint32_t wire) {
+    int32_t delta = (int32_t)(wire - (uint32_t)f->last_acked_seq);
+    return f->last_acked_seq + (int64_t)delta;
+}
+
+static void flow_enter_recovery(flow_t *f, const cc_ack_t *ev, int reason) {
+    f->dup_ack_retransmits++;
+    f->total_retransmits++;
+    if (f->use_fec && reason == TR_REASON_DUPACK) fec_enc_loss(&f->fec, 1);
+    cc_on_loss(&f->cc, ev);
+    f->in_fast_recovery = true;
+    f->recovery_point = f->sb.fill_seq;
+    // The episode answers for any probe still out
+    f->tlp_end_seq = 0;
+    flow_trace(f, TR_RECOVERY, f->sb.snd_una, 0, f->recovery_point, reason);
+    // Retransmit the oldest lost segment now, whatever the pipe says (RFC
+    // 5681 3.2 step 2, RFC 6675 5 step 4.3): after the window cut the pump
+    // could hold it back until the RTO fired. The rest follow as cwnd
+    // allows; the caller's pump flushes the batch. RACK has already
+    // marked what it found lost.
+    if (reason != TR_REASON_RACK) sb_mark_lost(&f->sb, f->sb.base_idx);
+    if (f->sb.rtx_head != SB_NONE) {
+        bool retransmit;
+        segment_t *seg = sb_take_next(&f->sb, &retransmit);
+        sb_stamp(&f->sb, seg, ev->now_ns);
+        send_segment(f, seg, true, true);
+        f->retransmitted_bytes += seg->len;
+    }
+    f->timer_start_ns = ev->now_ns;
+    f->dup_ack_count = 0; // Fast Recovery 시작 후 리셋
+}
+
+// RACK reordering window (RFC 8985 6.2): none while no reordering has been
+// seen and a loss episode (or DupThresh segments sacked) already says the
+// holes are losses; otherwise a quarter of the minimum RTT, at most SRTT
+static uint64_t rack_reo_wnd(const flow_t *f) {
+    if (!f->sb.reordering_seen &&
+        (f->in_fast_recovery || f->sb.bytes_sacked >= (uint64_t)FLOW_DUP_THRESH * (uint64_t)f->mss)) {
+        return 0;
+    }
+    uint64_t wnd = f->rtt.min_ns / 4;
+    return wnd < f->rtt.srtt_ns ? wnd : f->rtt.srtt_ns;
+}
+
+// Run RACK loss detection and start recovery for what it finds
+static void flow_rack(flow_t *f, const cc_ack_t *ev) {
+    uint32_t lost = sb_rack_detect(&f->sb, ev->now_ns, rack_reo_wnd(f), &f->rack_deadline_ns);
+    if (lost == 0) return;
+    f->rack_losses += lost;
+    if (f->use_fec) fec_enc_loss(&f->fec, lost);
+    if (!f->in_fast_recovery) flow_enter_recovery(f, ev, TR_REASON_RACK);
+}
+
+static void flow_on_ack(flow_t *f, const ack_packet_t *ack) {
+    uint64_t ack_seq = flow_extend_seq(f, ntohl(ack->ack));
+    int64_t ack_delta = (int64_t)(ack_seq - f->last_acked_seq);
+    if (ack_delta < 0) return;   // reordered, older than what we know
+
+    // The newest ACK sets the window edge, even if that shrinks it
+    uint32_t wnd = ntohl(ack->wnd);
+    bool wnd_changed = ack_seq + wnd != f->sb.wnd_end;
+    f->sb.wnd_end = ack_seq + wnd;
+    f->rwnd = wnd;
+    if (wnd < f->min_rwnd) f->min_rwnd = wnd;
+
+    cc_ack_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.now_ns = f->io.now_ns(f->io.ctx);
+    ev.in_recovery = f->in_fast_recovery;
+    ev.rwnd_limited = f->rwnd_limited;
+
+    // SACK blocks first, so pipe and loss marks reflect this ACK
+    if (f->use_sack) {
+        for (uint8_t i = 0; i < ack->sack_count; i++) {
+            uint64_t start = flow_extend_seq(f, ntohl(ack->sack[i].start));
+            uint64_t end = flow_extend_seq(f, ntohl(ack->sack[i].end));
+            ev.sacked_bytes += sb_sack(&f->sb, start, end);
+        }
+    }
+    if (ack_delta > 0) {
+        // New ACK: mark segments acked
+        f->last_acked_seq = ack_seq;
+        ev.acked_bytes = sb_ack(&f->sb, ack_seq, &ev.acked_segs);
+        input_release(&f->in, f->last_acked_seq);
+    }
+    if (f->use_rack) sb_rack_update(&f->sb, ev.now_ns, f->rtt.min_ns);
+    sb_rate_t rs;
+    if (sb_rate_sample(&f->sb, ev.now_ns, &rs)) {
+        // Only segments sent once give a sample (Karn's rule)
+        ev.rtt_ns = rs.rtt_ns;
+        rtt_sample(&f->rtt, rs.rtt_ns, rs.rtt_sent_ns);
+        ev.prior_delivered = rs.prior_delivered;
+        if (rs.interval_ns > 0) ev.delivery_rate = (double)rs.delivered * 1e9 / (double)rs.interval_ns;
+    }
+    ev.delivered = f->sb.delivered;
+    ev.flight_bytes = f->sb.bytes_in_flight + f->sb.bytes_lost;
+
+    double old_cwnd = f->cc.cwnd;
+    if (ack_delta > 0) {
+        bool hold = f->use_sack || f->cc.ops->hold_recovery;
+        f->dup_ack_count = 0;
+        if (f->in_fast_recovery && hold && ack_seq < f->recovery_point) {
+            // 부분 ACK: 복구 지점까지 Fast Recovery 유지
+            ev.kind = CC_ACK_PARTIAL;
+            cc_on_ack(&f->cc, &ev);
+            // Without SACK the next hole is the new oldest segment (RFC 6582);
+            // with SACK the scoreboard already knows which holes are lost
+            if (!f->use_sack) sb_mark_lost(&f->sb, f->sb.base_idx);
+            flow_trace(f, TR_ACK_PARTIAL, ack_seq, 0, 0, 0);
+        } else if (f->in_fast_recovery) {
+            ev.kind = CC_ACK_RECOVERED;
+            f->in_fast_recovery = false;
+            cc_on_ack(&f->cc, &ev);
+            flow_trace(f, TR_ACK_RECOVERED, ack_seq, 0, 0, 0);
+        } else {
+            ev.kind = CC_ACK_NEW;
+            cc_on_ack(&f->cc, &ev);
+            flow_trace(f, TR_ACK_NEW, ack_seq, 0, 0, (int32_t)lround(f->cc.cwnd - old_cwnd));
+        }
+
+        // If all outstanding acked, stop timer
+        if (sb_idle(&f->sb)) {
+            f->timer_start_ns = 0;
+        } else {
+            f->timer_start_ns = ev.now_ns;
+        }
+        f->tlp_base_ns = ev.now_ns;
+    } else if (sb_idle(&f->sb) || (wnd_changed && ev.sacked_bytes == 0)) {
+        // Window update or probe answer: only an ACK with data outstanding,
+        // no new SACK and an unchanged window is a duplicate (RFC 5681)
+    } else {
+        // Duplicate ACK
+        f->dup_ack_count++;
+        ev.kind = CC_ACK_DUP;
+        cc_on_ack(&f->cc, &ev);
+        flow_trace(f, TR_ACK_DUP, ack_seq, f->dup_ack_count, 0, f->cc.cwnd > old_cwnd);
+        // With FEC the oldest hole may still be rebuilt by its block's parity
+        uint32_t thresh = FLOW_DUP_THRESH + sb_fec_grace(&f->sb, f->sb.base_idx);
+        if (!f->use_rack && !f->in_fast_recovery && f->dup_ack_count >= thresh && !sb_all_acked(&f->sb)) {
+            // Fast Retransmit: 3중복 ACK를 받으면
+            flow_enter_recovery(f, &ev, TR_REASON_DUPACK);
+        }
+    }
+
+    // RFC 6675 IsLost: an unsacked segment with more than (DupThresh - 1) * MSS
+    // sacked above it is lost; only those holes get retransmitted. RACK
+    // judges by send time instead.
+    if (f->use_rack) {
+        flow_rack(f, &ev);
+    } else if (f->use_sack && !sb_all_acked(&f->sb)) {
+        uint32_t lost = sb_detect_losses(&f->sb, (uint64_t)(FLOW_DUP_THRESH - 1) * (uint64_t)f->mss);
+        if (f->use_fec) fec_enc_loss(&f->fec, lost);
+        if (lost > 0 && !f->in_fast_recovery) flow_enter_recovery(f, &ev, TR_REASON_SACK);
+    }
+
+    // The probe is answered once the cumulative ACK covers it. A
+    // retransmitted probe that got there with no recovery episode repaired
+    // a tail loss by itself: reduce once, as for any loss. There is no
+    // DSACK to flag a spurious probe, but an answer sooner than the minimum
+    // RTT after it went out was for the original.
+    if (f->tlp_end_seq != 0 && ack_seq >= f->tlp_end_seq) {
+        bool spurious = ev.now_ns - f->tlp_sent_ns < f->rtt.min_ns;
+        if (f->tlp_retrans && !f->in_fast_recovery && !spurious) {
+            cc_on_repaired(&f->cc, &ev);
+            f->tlp_recoveries++;
+            flow_trace(f, TR_TLP_RECOVERED, ack_seq, 0, 0, 0);
+        }
+        f->tlp_end_seq = 0;
+    }
+
+    // Segments the receiver rebuilt were lost all the same
+    if (f->use_fec) {
+        uint16_t repaired = ntohs(ack->fec_repaired);
+        int16_t delta = (int16_t)(repaired - f->fec_repaired);
+        if (delta > 0) {
+            f->fec_repaired = repaired;
+            f->fec_repaired_total += (uint64_t)delta;
+            fec_enc_loss(&f->fec, (uint32_t)delta);
+            if (!f->fec_keep_cwnd && !f->in_fast_recovery && f->sb.snd_una >= f->fec_cwr_point) {
+                cc_on_repaired(&f->cc, &ev);
+                f->fec_cwr_point = f->sb.fill_seq;
+                f->fec_reductions++;
+            }
+            flow_trace(f, TR_FEC_REPAIRED, ack_seq, 0, f->fec_repaired_total, delta);
+        }
+    }
+}
+
+static void flow_check_done(flow_t *f) {
+    if (sb_all_acked(&f->sb) && !f->done) {
+        f->done = true;
+        f->io.timer(f->io.ctx, FLOW_TIMER_RTO, 0);
+        f->loss_deadline_ns = 0;
+        f->io.timer(f->io.ctx, FLOW_TIMER_PACE, 0);
+        f->io.timer(f->io.ctx, FLOW_TIMER_PERSIST, 0);
+        f->persist_armed = false;
+    }
+}
+
+// The receiver confirms the FIN with a control ACK of its own
+static void flow_on_fin_ack(flow_t *f, const uint8_t *buf, size_t n) {
+    ctl_ack_t ack;
+    if (f->closed || f->fin_sends == 0 || n < sizeof(ack)) return;
+    memcpy(&ack, buf, sizeof(ack));
+    if (ntohl(ack.conn_id) != f->conn_id || !(ack.flags & ACK_F_FIN)) return;
+    f->fin_acked = true;
+    f->closed = true;
+    f->io.timer(f->io.ctx, FLOW_TIMER_RTO, 0);
+    f->loss_deadline_ns = 0;
+    flow_trace(f, TR_FIN_ACKED, f->in.size, 0, 0, (int32_t)f->fin_sends);
+}
+
+void flow_on_ack_packet(flow_t *f, const uint8_t *buf, size_t n) {
+    if (f->done) {
+        flow_on_fin_ack(f, buf, n);
+        return;
+    }
+    if (n < ACK_BASE_LEN) return;
+    ack_packet_t ack;
+    memcpy(&ack, buf, n < sizeof(ack) ? n : sizeof(ack));
+    if (ntohl(ack.conn_id) != f->conn_id || ack.flags != 0) return;
+    if (ack.sack_count > MAX_SACK_BLOCKS || n < ack_wire_len(&ack)) ack.sack_count = 0;
+    flow_on_ack(f, &ack);
+    flow_check_done(f);
+}
+
+// PTO expired with the tail unanswered (RFC 8985 7.3): send one new segment
+// if there is one the receive window allows, else the highest unsacked one
+// again, outside cwnd. Its ACK, or the SACK it draws, lets RACK find
+// whatever was lost at the tail.
+static void flow_send_probe(flow_t *f) {
+    uint64_t now_ns = f->io.now_ns(f->io.ctx);
+    bool retransmit;
+    segment_t *seg = sb_take_next(&f->sb, &retransmit);
+    if (!seg) {
+        uint64_t idx = sb_last_unsacked(&f->sb);
+        if (idx == SB_NONE) return;
+        sb_mark_lost(&f->sb, idx);
+        seg = sb_take_next(&f->sb, &retransmit);
+    }
+    sb_stamp(&f->sb, seg, now_ns);
+    send_segment(f, seg, retransmit, true);
+    if (retransmit) {
+        f->retransmitted_bytes += seg->len;
+        f->total_retransmits++;
+    }
+    f->tlp_probes++;
+    f->tlp_end_seq = f->sb.fill_seq;
+    f->tlp_retrans = retransmit;
+    f->tlp_sent_ns = now_ns;
+    flow_trace(f, TR_TLP, seg->seq, seg->len, f->tlp_end_seq, retransmit);
+    // The RTO runs again from the probe
+    f->timer_start_ns = now_ns;
+}
+
+void flow_on_rto(flow_t *f) {
+    // Only the FIN is left; back off as for data (Karn keeps it backed off)
+    if (f->done) {
+        if (f->closed || f->fin_sends == 0) return;
+        if (f->fin_sends >= FLOW_FIN_TRIES) {
+            f->closed = true;
+            return;
+        }
+        rtt_backoff(&f->rtt, f->io.now_ns(f->io.ctx));
+        flow_send_fin(f);
+        return;
+    }
+    f->loss_deadline_ns = 0;
+    switch (f->loss_timer) {
+    case FLOW_LOSS_RACK: {
+        cc_ack_t ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.now_ns = f->io.now_ns(f->io.ctx);
+        ev.in_recovery = f->in_fast_recovery;
+        ev.delivered = f->sb.delivered;
+        ev.flight_bytes = f->sb.bytes_in_flight + f->sb.bytes_lost;
+        flow_rack(f, &ev);
+        break;
+    }
+    case FLOW_LOSS_TLP:
+        flow_send_probe(f);
+        break;
+    default:
+        flow_on_timeout(f);
+        break;
+    }
+    flow_pump(f);
+}
+
+void flow_on_pace(flow_t *f) {
+    flow_pump(f);
+}
+
+// Persist timer: a header-only probe at the next new byte makes the
+// receiver answer with its current window
+void flow_on_persist(flow_t *f) {
+    if (f->done) return;
+    f->persist_armed = false;
+    packet_header_t hdr;
+    hdr.conn_id = htonl(f->conn_id);
+    hdr.seq = htonl((uint32_t)f->sb.fill_seq);
+    hdr.len = htonl(0);
+    hdr.flags = FLAG_WND_PROBE;
+    hdr.csum = 0;
+    hdr.fec = 0;
+    f->io.send(f->io.ctx, &hdr, sizeof(hdr), NULL, 0);
+    f->wnd_probes++;
+    if (f->persist_backoff < 32) f->persist_backoff++;
+    flow_trace(f, TR_WND_PROBE, f->sb.fill_seq, 0, f->rwnd, (int32_t)f->wnd_probes);
+    flow_pump(f);
+}
+
+void flow_send_fin(flow_t *f) {
+    packet_header_t hdr;
+    hdr.conn_id = htonl(f->conn_id);
+    hdr.seq = htonl((uint32_t)f->in.size);
+    hdr.len = htonl(0);
+    hdr.flags = FLAG_FIN;
+    hdr.csum = 0;
+    hdr.fec = 0;
+    // Only a digest over every byte is worth sending
+    fin_t fin;
+    if (f->use_digest && f->digest_pos == f->in.size) {
+        fin.bytes = htobe64(f->digest_pos);
+        fin.digest = htonl(f->digest);
+        hdr.len = htonl((uint32_t)sizeof(fin));
+        f->io.send(f->io.ctx, &hdr, sizeof(hdr), (const uint8_t *)&fin, sizeof(fin));
+    } else {
+        f->io.send(f->io.ctx, &hdr, sizeof(hdr), NULL, 0);
+    }
+    flow_flush(f);
+    f->fin_sends++;
+    flow_trace(f, TR_FIN, f->in.size, 0, 0, (int32_t)f->fin_sends);
+    uint64_t now_ns = f->io.now_ns(f->io.ctx);
+    f->loss_timer = FLOW_LOSS_RTO;
+    f->loss_deadline_ns = now_ns + f->rtt.rto_ns;
+    f->io.timer(f->io.ctx, FLOW_TIMER_RTO, f->loss_deadline_ns);
+}
+
+int flow_init(flow_t *f, const flow_config_t *cfg, const flow_io_t *io, const input_map_t *in) {
+    memset(f, 0, sizeof(*f));
+    f->io = *io;
+    f->in = *in;
+    f->conn_id = cfg->conn_id;
+    f->mss = (int)cfg->mss;
+    f->use_sack = cfg->sack;
+    f->use_rack = cfg->rack && cfg->sack;
+    f->ack_freq = cfg->ack_freq == 0 ? 1 : cfg->ack_freq > ACK_FREQ_MAX ? ACK_FREQ_MAX : cfg->ack_freq;
+    if (sb_init(&f->sb, cfg->sb_cap ? cfg->sb_cap : SB_DEFAULT_CAP, in->size, cfg->mss) < 0) return -1;
+    f->sb.wnd_end = cfg->rwnd;
+    f->rwnd = cfg->rwnd;
+    f->min_rwnd = UINT32_MAX;
+    f->use_digest = cfg->digest;
+    f->use_fec = cfg->fec;
+    f->fec_keep_cwnd = cfg->fec_keep_cwnd;
+    if (f->use_fec && fec_enc_init(&f->fec, cfg->mss, cfg->fec_k, in->data != NULL) < 0) return -1;
+    rtt_init(&f->rtt, cfg->initial_rto_ns, cfg->min_rto_ns);
+    cc_init(&f->cc, cfg->cc, cfg->mss, cfg->sack, cfg->pacing);
+    trace_init(&f->trace, TRACE_TEXT);
+    flow_check_done(f);   // empty input
+    return 0;
+}
+
+void flow_free(flow_t *f) {
+    trace_close(&f->trace);
+    fec_enc_free(&f->fec);
+    sb_free(&f->sb);
+}
+
+void flow_print_stats(const flow_t *f, FILE *out) {
+    fprintf(out, "타임아웃 횟수: %u\n", f->timeout_count);
+    fprintf(out, "중복 ACK 재전송: %u\n", f->dup_ack_retransmits);
+    fprintf(out, "총 재전송 횟수: %u\n", f->total_retransmits);
+    fprintf(out, "재전송 바이트: %" PRIu64 " 바이트\n", f->retransmitted_bytes);
+    rtt_print(&f->rtt, out);
+    if (f->rwnd_stalls > 0 || f->wnd_probes > 0) {
+        fprintf(out, "수신 윈도우 제한: %u회 (최소 수신 윈도우 %u 바이트, 제로 윈도우 프로브 %u개)\n",
+                f->rwnd_stalls, f->min_rwnd, f->wnd_probes);
+    }
+    if (f->use_rack) {
+        fprintf(out, "RACK-TLP: 손실 판정 %u개, 꼬리 손실 프로브 %u개 (프로브 재전송만으로 복구 %u회), 순서 뒤바뀜 %s\n",
+                f->rack_losses, f->tlp_probes, f->tlp_recoveries, f->sb.reordering_seen ? "관찰됨" : "없음");
+    }
+    if (f->use_fec) {
+        const fec_enc_t *e = &f->fec;
+        fprintf(out, "FEC: 패리티 %" PRIu64 "개 (%" PRIu64 " 바이트, 오버헤드 %.1f%%), 수신측 복구 %" PRIu64 "개, 복구로 인한 윈도우 감소 %u회, 추정 손실률 %.2f%%, 마지막 블록 %u개\n",
+                e->blocks, e->parity_bytes, e->data_bytes ? (double)e->parity_bytes * 100.0 / (double)e->data_bytes : 0.0,
+                f->fec_repaired_total, f->fec_reductions, e->loss * 100.0, e->k);
+    }
+    if (f->use_digest && f->digest_pos == f->in.size) fprintf(out, "파일 다이제스트 (CRC32C): %08x\n", f->digest);
+    if (f->fin_sends > 0) {
+        fprintf(out, "FIN 송신: %u번 (수신측 확인: %s)\n", f->fin_sends, f->fin_acked ? "예" : "아니오");
+    }
+    fprintf(out, "최종 cwnd: %.0f 바이트\n", f->cc.cwnd);
+    fprintf(out, "최종 ssthresh: %.0f 바이트\n", f->cc.ssthresh);
+    double pacing = cc_pacing_rate(&f->cc);
+    if (pacing > 0.0) fprintf(out, "최종 페이싱 속도: %.2f MB/s\n", pacing / 1024.0 / 1024.0);
+}
+
+static uint32_t clamp_u32(double v) {
+    return v >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+static uint8_t flow_state(const flow_t *f) {
+    if (f->rtt.backoffs > 0) return TELEM_STATE_TIMEOUT;
+    return f->in_fast_recovery ? TELEM_STATE_RECOVERY : TELEM_STATE_OPEN;
+}
+
+void flow_sample(const flow_t *f, telem_row_t *row) {
+    row->acked = f->sb.snd_una;
+    row->cwnd = clamp_u32(f->cc.cwnd);
+    row->ssthresh = clamp_u32(f->cc.ssthresh);
+    row->inflight = (uint32_t)f->sb.bytes_in_flight;
+    row->srtt_us = (uint32_t)(f->rtt.srtt_ns / 1000);
+    row->rtt_us = (uint32_t)(f->rtt.last_ns / 1000);
+    row->retransmits = f->total_retransmits;
+    row->timeouts = f->timeout_count;
+    row->state = flow_state(f);
+}
+
+void flow_counters(const flow_t *f, telem_counters_t *c) {
+    c->bytes = f->sb.snd_una;
+    c->size = f->in.size;
+    c->done = f->done;
+    c->flows = 1;
+    c->cwnd = clamp_u32(f->cc.cwnd);
+    c->ssthresh = clamp_u32(f->cc.ssthresh);
+    c->inflight = (uint32_t)f->sb.bytes_in_flight;
+    c->srtt_us = (uint32_t)(f->rtt.srtt_ns / 1000);
+    c->rto_us = (uint32_t)(f->rtt.rto_ns / 1000);
+    c->state = flow_state(f);
+    c->total_retransmits = f->total_retransmits;
+    c->timeout_count = f->timeout_count;
+    c->dup_ack_retransmits = f->dup_ack_retransmits;
+    c->rack_losses = f->rack_losses;
+    c->tlp_probes = f->tlp_probes;
+    c->retransmitted_bytes = f->retransmitted_bytes;
+}
@@ -0,0 +1,190 @@
+#ifndef FLOW_H
+#define FLOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cc.h"
+#include "fec.h"
+#include "rtt.h"
+#include "scoreboard.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// Sender side of one transfer as a state machine with no I/O of its own:
+// packets, timers and the clock go through flow_io_t. The UDP sender wires
+// it to sendmmsg, event loop timers and CLOCK_MONOTONIC; the simulator
+// wires it to a virtual clock and a modelled link, so both run the same
+// code path.
+
+#define FLOW_DUP_THRESH 3
+#define FLOW_PACE_QUANTUM_NS 1000000ull  // paced sends may run this far ahead of schedule
+#define FLOW_ACK_FREQ_DEFAULT 2          // ask for an ACK every 2nd segment, like TCP
+#define FLOW_ACKS_PER_WINDOW 4           // ... but at least this many ACKs per cwnd
+#define FLOW_FIN_TRIES 6                 // FIN sends before giving up on its ACK
+#define FLOW_TLP_SLACK_NS 2000000ull     // PTO margin over 2 SRTT for ACK scheduling jitter
+#define FLOW_TLP_ACK_DELAY_NS 2000000ull // PTO allowance for a lone segment's delayed ACK
+
+enum {
+    FLOW_TIMER_RTO = 0,
+    FLOW_TIMER_PACE,
+    FLOW_TIMER_PERSIST,     // zero-window probe
+};
+
+// What the FLOW_TIMER_RTO slot is armed for: one timer per flow serves the
+// earliest of the three
+enum {
+    FLOW_LOSS_RTO = 0,
+    FLOW_LOSS_RACK,         // the oldest suspect segment's reordering window ends
+    FLOW_LOSS_TLP,          // tail loss probe
+};
+
+typedef struct {
+    void *ctx;
+    uint64_t (*now_ns)(void *ctx);
+    // Queue one packet; payload is NULL when the data is not materialized
+    void (*send)(void *ctx, const void *hdr, size_t hlen, const uint8_t *payload, size_t plen);
+    // Push queued packets out (end of a burst)
+    void (*flush)(void *ctx);
+    // One-shot timer at an absolute deadline; deadline 0 disarms
+    void (*timer)(void *ctx, int which, uint64_t deadline_ns);
+} flow_io_t;
+
+typedef struct {
+    uint32_t conn_id;
+    uint32_t mss;
+    uint64_t initial_rto_ns;
+    uint64_t min_rto_ns;
+    const cc_ops_t *cc;
+    bool sack;
+    bool rack;                   // RACK-TLP loss detection (with sack)
+    bool pacing;
+    uint32_t ack_freq;           // ACK ratio asked of the receiver (0: 1)
+    uint32_t sb_cap;             // scoreboard ring size in segments
+    uint32_t rwnd;               // receive window from the handshake
+    bool digest;                 // CRC32C of the data goes out with the FIN
+    bool fec;                    // parity packet per block of segments (fec.h)
+    uint32_t fec_k;              // ... of this many segments; 0 follows the loss rate
+    bool fec_keep_cwnd;          // rebuilt segments are not a congestion signal
+} flow_config_t;
+
+// The data being sent. With mapped set, fully acked pages are released
+// with MADV_DONTNEED as the transfer advances.
+typedef struct {
+    const uint8_t *data;
+    uint64_t size;
+    bool mapped;
+    uint64_t released;
+} input_map_t;
+
+// One congestion-controlled transfer. All state the event handlers need
+// lives here so a single event loop can drive any number of flows.
+typedef struct {
+    flow_io_t io;
+    uint32_t conn_id;
+    int mss;
+    rtt_est_t rtt;           // RFC 6298 SRTT/RTTVAR/RTO
+    input_map_t in;
+    scoreboard_t sb;
+    trace_t trace;
+
+    // Congestion control (바이트 단위): the algorithm sits behind cc.ops,
+    // loss detection and the recovery episode stay here
+    cc_t cc;
+    uint64_t pace_next_ns;   // earliest send time of the next paced segment
+    uint64_t last_acked_seq; // last cumulatively acked byte
+    uint32_t dup_ack_count;
+    bool in_fast_recovery;   // Fast Recovery 상태 추적
+    bool use_sack;           // RFC 6675 SACK 기반 손실 복구
+    uint32_t ack_freq;       // requested ACK ratio (capped per packet by cwnd)
+    uint64_t recovery_point; // SACK: highest byte sent when recovery began
+    uint64_t timer_start_ns; // RTO timer start, 0 when stopped
+
+    // Flow control: new data stays below the receiver's window edge
+    // (sb.wnd_end); with nothing in flight the persist timer probes it
+    uint32_t rwnd;           // last advertised window
+    uint32_t min_rwnd;
+    bool rwnd_limited;       // last pump stopped at the window with cwnd to spare
+    bool persist_armed;
+    uint32_t persist_backoff;
+    uint32_t rwnd_stalls;    // times the window (not cwnd) stopped sending
+    uint32_t wnd_probes;
+
+    // End-to-end digest: new data leaves in order, so it is hashed as it
+    // is first sent
+    bool use_digest;
+    uint32_t digest;         // CRC32C of [0, digest_pos)
+    uint64_t digest_pos;
+
+    // Forward error correction: a hole the receiver can rebuild from its
+    // block's parity is given until the parity is past before it counts
+    // as lost (sb_fec_grace); parity takes room in cwnd like data until its
+    // block is acked. A rebuilt segment still costs one window reduction per
+    // round trip, as any loss on the path would, unless fec_keep_cwnd says
+    // the path's losses are not congestion (radio links and the like)
+    bool use_fec;
+    bool fec_keep_cwnd;
+    fec_enc_t fec;
+    uint32_t fec_queued;     // parities in the unflushed TX batch
+    uint16_t fec_repaired;   // receiver's count as of the latest ACK
+    uint64_t fec_repaired_total;
+    uint64_t fec_cwr_point;  // no further reduction until snd_una passes it
+    uint32_t fec_reductions;
+
+    // RACK-TLP (RFC 8985): with SACK, a segment is lost once one sent after
+    // it has been delivered and its RTT plus a reordering window has passed
+    // (sb_rack_detect), in place of the DupThresh rules; a tail that goes
+    // quiet gets a probe after about two SRTTs instead of waiting out the RTO
+    bool use_rack;
+    uint8_t loss_timer;      // FLOW_LOSS_* the RTO slot is armed for
+    uint64_t loss_deadline_ns; // its deadline, 0 when disarmed
+    uint64_t rack_deadline_ns; // next reordering window to end, 0 when none
+    uint64_t tlp_base_ns;    // last new data sent or cumulative ACK
+    uint64_t tlp_end_seq;    // highest byte sent with the outstanding probe, 0 when none
+    bool tlp_retrans;        // ... and that probe was a retransmission
+    uint64_t tlp_sent_ns;
+    uint32_t tlp_probes;
+    uint32_t tlp_recoveries; // tail losses repaired by the probe alone
+    uint32_t rack_losses;    // segments RACK marked lost
+
+    uint32_t total_retransmits;
+    uint32_t timeout_count;
+    uint32_t dup_ack_retransmits;
+    uint64_t retransmitted_bytes;
+    bool done;               // every byte acked
+
+    // Teardown: the FIN goes out once done and again on each (backed-off)
+    // RTO until the receiver confirms it
+    uint32_t fin_sends;
+    bool fin_acked;
+    bool closed;             // FIN confirmed, or FLOW_FIN_TRIES sent unanswered
+} flow_t;
+
+// Trace defaults to text mode; replace f->trace after init to change it
+int flow_init(flow_t *f, const flow_config_t *cfg, const flow_io_t *io, const input_map_t *in);
+void flow_free(flow_t *f);
+
+// Send as much as cwnd, the receive window and pacing allow, then re-arm
+// the timers
+void flow_pump(flow_t *f);
+// One received ACK datagram (ACKs for other connections and handshake
+// ACKs are ignored; once done, only the FIN confirmation counts);
+// call flow_pump after a batch of them
+void flow_on_ack_packet(flow_t *f, const uint8_t *buf, size_t n);
+// Timer expiries (they pump on their own)
+void flow_on_rto(flow_t *f);
+void flow_on_pace(flow_t *f);
+void flow_on_persist(flow_t *f);
+// Transfer complete: tell the receiver. The RTO timer resends the FIN
+// until closed is set.
+void flow_send_fin(flow_t *f);
+// Retransmission, RTT and window lines of the final statistics
+void flow_print_stats(const flow_t *f, FILE *out);
+// Window state for the telemetry series; row->t_ns is left to the caller
+void flow_sample(const flow_t *f, telem_row_t *row);
+// Sender counters for the stats block (the receiver part is left alone)
+void flow_counters(const flow_t *f, telem_counters_t *c);
+
+#endif
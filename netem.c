@@ -0,0 +1,421 @@
+#include "netem.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void netem_config_default(netem_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->limit = NETEM_DEFAULT_LIMIT;
+    cfg->qdisc = NETEM_DROPTAIL;
+    cfg->ge_loss_bad = 1.0;
+    cfg->slots = NETEM_DEFAULT_SLOTS;
+}
+
+bool netem_config_active(const netem_config_t *cfg) {
+    return cfg->rate_bps > 0 || cfg->delay_ns > 0 || cfg->loss > 0.0 || cfg->ge_p > 0.0 ||
+           cfg->reorder > 0.0 || cfg->dup > 0.0 || cfg->corrupt > 0.0;
+}
+
+static double clamp_prob(double p) {
+    if (p < 0.0) return 0.0;
+    if (p > 1.0) return 1.0;
+    return p;
+}
+
+int netem_parse_opt(netem_config_t *cfg, int opt, const char *arg) {
+    char *end;
+    switch (opt) {
+    case 'r': {
+        double mbps = strtod(arg, &end);
+        if (end == arg || mbps < 0.0) return -1;
+        cfg->rate_bps = (uint64_t)(mbps * 1e6);
+        return 0;
+    }
+    case 'd': {
+        double ms = strtod(arg, &end);
+        if (end == arg || ms < 0.0) return -1;
+        cfg->delay_ns = (uint64_t)(ms * 1e6);
+        return 0;
+    }
+    case 'Q': {
+        long n = strtol(arg, &end, 10);
+        if (end == arg || n < 1) return -1;
+        cfg->limit = (uint32_t)n;
+        return 0;
+    }
+    case 'E':
+        if (strcmp(arg, "droptail") == 0) {
+            cfg->qdisc = NETEM_DROPTAIL;
+        } else if (strcmp(arg, "red") == 0) {
+            cfg->qdisc = NETEM_RED;
+        } else if (strcmp(arg, "codel") == 0) {
+            cfg->qdisc = NETEM_CODEL;
+        } else {
+            return -1;
+        }
+        return 0;
+    case 'G': {
+        // p,r[,h]: good->bad, bad->good, loss in bad
+        double v[3] = {0.0, 0.0, 1.0};
+        int n = sscanf(arg, "%lf,%lf,%lf", &v[0], &v[1], &v[2]);
+        if (n < 2) return -1;
+        cfg->ge_p = clamp_prob(v[0]);
+        cfg->ge_r = clamp_prob(v[1]);
+        cfg->ge_loss_bad = clamp_prob(v[2]);
+        return 0;
+    }
+    case 'O': {
+        // prob[,ms]
+        double p = 0.0, ms = 1.0;
+        if (sscanf(arg, "%lf,%lf", &p, &ms) < 1 || ms < 0.0) return -1;
+        cfg->reorder = clamp_prob(p);
+        cfg->reorder_ns = (uint64_t)(ms * 1e6);
+        return 0;
+    }
+    case 'D': {
+        double p = strtod(arg, &end);
+        if (end == arg) return -1;
+        cfg->dup = clamp_prob(p);
+        return 0;
+    }
+    case 'X': {
+        double p = strtod(arg, &end);
+        if (end == arg) return -1;
+        cfg->corrupt = clamp_prob(p);
+        return 0;
+    }
+    }
+    return -1;
+}
+
+void netem_usage(FILE *out) {
+    fprintf(out, "  링크 에뮬레이터:\n");
+    fprintf(out, "  -r N  병목 링크 속도 (Mbps, 소수 가능)\n");
+    fprintf(out, "  -d N  단방향 전파 지연 (밀리초, 소수 가능)\n");
+    fprintf(out, "  -Q N  병목 큐 길이 (패킷, 기본 %d)\n", NETEM_DEFAULT_LIMIT);
+    fprintf(out, "  -E 이름  큐 관리: droptail(기본), red, codel\n");
+    fprintf(out, "  -G p,r[,h]  Gilbert-Elliott 버스트 손실: 정상->버스트 p, 버스트->정상 r, 버스트 중 손실 h(기본 1)\n");
+    fprintf(out, "  -O p[,ms]   확률 p로 패킷을 ms(기본 1) 더 늦게 전달해 순서 뒤바꿈\n");
+    fprintf(out, "  -D p        확률 p로 패킷 복제\n");
+    fprintf(out, "  -X p        확률 p로 패킷의 비트 하나를 뒤집어 전달 (손상)\n");
+}
+
+static const char *qdisc_name(int qdisc) {
+    switch (qdisc) {
+    case NETEM_RED:
+        return "RED";
+    case NETEM_CODEL:
+        return "CoDel";
+    default:
+        return "drop-tail";
+    }
+}
+
+void netem_describe(const netem_config_t *cfg, FILE *out) {
+    if (cfg->rate_bps > 0) {
+        fprintf(out, "링크: %.1f Mbps, 단방향 지연 %.3f 밀리초, 큐 %u 패킷 (%s)\n", (double)cfg->rate_bps / 1e6,
+                (double)cfg->delay_ns / 1e6, cfg->limit, qdisc_name(cfg->qdisc));
+    } else {
+        fprintf(out, "링크: 속도 무제한, 단방향 지연 %.3f 밀리초\n", (double)cfg->delay_ns / 1e6);
+    }
+    if (cfg->ge_p > 0.0) {
+        fprintf(out, "버스트 손실 (Gilbert-Elliott): p=%.4f r=%.4f, 정상 %.2f%% / 버스트 %.2f%%\n", cfg->ge_p, cfg->ge_r,
+                cfg->loss * 100.0, cfg->ge_loss_bad * 100.0);
+    } else if (cfg->loss > 0.0) {
+        fprintf(out, "링크 손실: %.2f%%\n", cfg->loss * 100.0);
+    }
+    if (cfg->reorder > 0.0) {
+        fprintf(out, "순서 뒤바꿈: %.2f%% (%.3f 밀리초 지연)\n", cfg->reorder * 100.0, (double)cfg->reorder_ns / 1e6);
+    }
+    if (cfg->dup > 0.0) fprintf(out, "패킷 복제: %.2f%%\n", cfg->dup * 100.0);
+    if (cfg->corrupt > 0.0) fprintf(out, "패킷 손상 (비트 오류): %.2f%%\n", cfg->corrupt * 100.0);
+}
+
+int netem_init(netem_t *e, const netem_config_t *cfg, rng_t *rng) {
+    memset(e, 0, sizeof(*e));
+    e->cfg = *cfg;
+    e->rng = rng;
+    uint32_t n = cfg->slots;
+    if (n == 0 || cfg->slot_size == 0 || cfg->limit == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    // 64 KB datagrams would make the default arena 4 GB
+    if ((uint64_t)n * cfg->slot_size > NETEM_ARENA_MAX) n = NETEM_ARENA_MAX / cfg->slot_size;
+    if (n == 0) n = 1;
+    e->cfg.slots = n;
+    if (e->cfg.limit > n) e->cfg.limit = n;
+    e->pkts = calloc(n, sizeof(*e->pkts));
+    // Untouched slots stay unbacked zero pages; the LIFO free list keeps
+    // the working set to what is actually in flight
+    e->arena = calloc(n, cfg->slot_size);
+    e->free_list = malloc(n * sizeof(*e->free_list));
+    e->queue = malloc(e->cfg.limit * sizeof(*e->queue));
+    e->line = malloc(n * sizeof(*e->line));
+    if (!e->pkts || !e->arena || !e->free_list || !e->queue || !e->line) {
+        netem_free(e);
+        return -1;
+    }
+    for (uint32_t i = 0; i < n; i++) e->free_list[i] = n - 1 - i;
+    e->free_count = n;
+    return 0;
+}
+
+void netem_free(netem_t *e) {
+    free(e->pkts);
+    free(e->arena);
+    free(e->free_list);
+    free(e->queue);
+    free(e->line);
+    e->pkts = NULL;
+    e->arena = NULL;
+    e->free_list = NULL;
+    e->queue = NULL;
+    e->line = NULL;
+}
+
+static uint8_t *slot_data(const netem_t *e, uint32_t slot) {
+    return e->arena + (size_t)slot * e->cfg.slot_size;
+}
+
+static void slot_put(netem_t *e, uint32_t slot) {
+    e->free_list[e->free_count++] = slot;
+}
+
+static bool line_before(const netem_t *e, uint32_t a, uint32_t b) {
+    const netem_pkt_t *pa = &e->pkts[a], *pb = &e->pkts[b];
+    if (pa->release_ns != pb->release_ns) return pa->release_ns < pb->release_ns;
+    return pa->order < pb->order;
+}
+
+static void line_push(netem_t *e, uint32_t slot) {
+    e->pkts[slot].order = e->next_order++;
+    uint32_t i = e->line_count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!line_before(e, slot, e->line[parent])) break;
+        e->line[i] = e->line[parent];
+        i = parent;
+    }
+    e->line[i] = slot;
+}
+
+static uint32_t line_pop(netem_t *e) {
+    uint32_t top = e->line[0];
+    uint32_t last = e->line[--e->line_count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= e->line_count) break;
+        if (child + 1 < e->line_count && line_before(e, e->line[child + 1], e->line[child])) child++;
+        if (!line_before(e, e->line[child], last)) break;
+        e->line[i] = e->line[child];
+        i = child;
+    }
+    if (e->line_count > 0) e->line[i] = last;
+    return top;
+}
+
+// RED (Floyd & Jacobson): drop on arrival with a probability that grows
+// with the averaged queue length between min_th and max_th
+static bool red_drop(netem_t *e) {
+    double min_th = (double)e->cfg.limit / 4.0;
+    double max_th = 3.0 * (double)e->cfg.limit / 4.0;
+    e->red_avg += NETEM_RED_WEIGHT * ((double)e->q_count - e->red_avg);
+    if (e->red_avg < min_th) {
+        e->red_count = -1;
+        return false;
+    }
+    if (e->red_avg >= max_th) {
+        e->red_count = 0;
+        return true;
+    }
+    e->red_count++;
+    double pb = NETEM_RED_MAX_P * (e->red_avg - min_th) / (max_th - min_th);
+    double pa = (double)e->red_count * pb < 1.0 ? pb / (1.0 - (double)e->red_count * pb) : 1.0;
+    if (rng_chance(e->rng, pa)) {
+        e->red_count = 0;
+        return true;
+    }
+    return false;
+}
+
+static uint64_t codel_control_law(uint64_t t, uint32_t count) {
+    return t + (uint64_t)((double)NETEM_CODEL_INTERVAL_NS / sqrt((double)count));
+}
+
+// CoDel (RFC 8289), evaluated as each packet leaves the queue at now_ns
+static bool codel_drop(netem_t *e, uint64_t now_ns, uint64_t sojourn_ns) {
+    bool ok_to_drop = false;
+    if (sojourn_ns < NETEM_CODEL_TARGET_NS || e->q_bytes <= e->cfg.slot_size) {
+        e->codel_first_above_ns = 0;
+    } else if (e->codel_first_above_ns == 0) {
+        e->codel_first_above_ns = now_ns + NETEM_CODEL_INTERVAL_NS;
+    } else if (now_ns >= e->codel_first_above_ns) {
+        ok_to_drop = true;
+    }
+
+    if (e->codel_dropping) {
+        if (!ok_to_drop) {
+            e->codel_dropping = false;
+            return false;
+        }
+        if (now_ns < e->codel_drop_next_ns) return false;
+        e->codel_count++;
+        e->codel_drop_next_ns = codel_control_law(e->codel_drop_next_ns, e->codel_count);
+        return true;
+    }
+    if (!ok_to_drop) return false;
+    e->codel_dropping = true;
+    uint32_t delta = e->codel_count - e->codel_lastcount;
+    e->codel_count = (delta > 1 && now_ns - e->codel_drop_next_ns < 16 * NETEM_CODEL_INTERVAL_NS) ? delta : 1;
+    e->codel_lastcount = e->codel_count;
+    e->codel_drop_next_ns = codel_control_law(now_ns, e->codel_count);
+    return true;
+}
+
+static bool wire_lost(netem_t *e) {
+    if (e->cfg.ge_p > 0.0) {
+        if (e->ge_bad) {
+            if (rng_chance(e->rng, e->cfg.ge_r)) e->ge_bad = false;
+        } else if (rng_chance(e->rng, e->cfg.ge_p)) {
+            e->ge_bad = true;
+        }
+    }
+    return rng_chance(e->rng, e->ge_bad ? e->cfg.ge_loss_bad : e->cfg.loss);
+}
+
+// When the transmitter starts on the queue head
+static uint64_t head_start_ns(const netem_t *e) {
+    const netem_pkt_t *p = &e->pkts[e->queue[e->q_head]];
+    return e->busy_until_ns > p->enq_ns ? e->busy_until_ns : p->enq_ns;
+}
+
+// Move every packet the transmitter has started by now_ns from the queue
+// onto the delay line, applying AQM and wire loss on the way
+static void service(netem_t *e, uint64_t now_ns) {
+    while (e->q_count > 0) {
+        uint64_t start_ns = head_start_ns(e);
+        if (start_ns > now_ns) break;
+        uint32_t slot = e->queue[e->q_head];
+        netem_pkt_t *p = &e->pkts[slot];
+        e->q_head = e->q_head + 1 == e->cfg.limit ? 0 : e->q_head + 1;
+        e->q_count--;
+        e->q_bytes -= p->wire_len;
+
+        uint64_t sojourn_ns = start_ns - p->enq_ns;
+        if (sojourn_ns > e->max_sojourn_ns) e->max_sojourn_ns = sojourn_ns;
+        if (e->cfg.qdisc == NETEM_CODEL && codel_drop(e, start_ns, sojourn_ns)) {
+            e->aqm_drops++;
+            slot_put(e, slot);
+            continue;
+        }
+        uint64_t done_ns = start_ns;
+        if (e->cfg.rate_bps > 0) done_ns += (uint64_t)p->wire_len * 8 * 1000000000ull / e->cfg.rate_bps;
+        e->busy_until_ns = done_ns;
+        // Lost on the wire: it still used its transmission slot
+        if (wire_lost(e)) {
+            e->wire_drops++;
+            slot_put(e, slot);
+            continue;
+        }
+        p->release_ns = done_ns + e->cfg.delay_ns;
+        if (e->cfg.reorder > 0.0 && rng_chance(e->rng, e->cfg.reorder)) {
+            p->release_ns += e->cfg.reorder_ns;
+            e->reordered++;
+        }
+        line_push(e, slot);
+    }
+}
+
+static bool admit(netem_t *e, uint64_t now_ns, const void *meta, uint32_t meta_len, const uint8_t *data,
+                  uint32_t len, uint32_t wire_len) {
+    if (e->q_count >= e->cfg.limit) {
+        e->tail_drops++;
+        return false;
+    }
+    if (e->cfg.qdisc == NETEM_RED && red_drop(e)) {
+        e->aqm_drops++;
+        return false;
+    }
+    if (e->free_count == 0) {
+        e->overflows++;
+        return false;
+    }
+    uint32_t slot = e->free_list[--e->free_count];
+    netem_pkt_t *p = &e->pkts[slot];
+    p->enq_ns = now_ns;
+    p->len = len;
+    p->wire_len = wire_len;
+    p->meta_len = (uint8_t)meta_len;
+    if (meta_len > 0) memcpy(p->meta, meta, meta_len);
+    if (len > 0) memcpy(slot_data(e, slot), data, len);
+    uint32_t tail = e->q_head + e->q_count;
+    if (tail >= e->cfg.limit) tail -= e->cfg.limit;
+    e->queue[tail] = slot;
+    e->q_count++;
+    e->q_bytes += wire_len;
+    if (e->q_count > e->max_queue) e->max_queue = e->q_count;
+    return true;
+}
+
+bool netem_enqueue(netem_t *e, uint64_t now_ns, const void *meta, uint32_t meta_len,
+                   const uint8_t *data, uint32_t len, uint32_t wire_len) {
+    if (len > e->cfg.slot_size || meta_len > NETEM_META_MAX) {
+        e->overflows++;
+        return false;
+    }
+    // Bring the queue up to date first so admission sees its real length
+    service(e, now_ns);
+    e->enqueued++;
+    bool ok = admit(e, now_ns, meta, meta_len, data, len, wire_len);
+    if (ok && e->cfg.dup > 0.0 && rng_chance(e->rng, e->cfg.dup)) {
+        if (admit(e, now_ns, meta, meta_len, data, len, wire_len)) e->duplicated++;
+    }
+    return ok;
+}
+
+unsigned netem_poll(netem_t *e, uint64_t now_ns, netem_deliver_fn deliver, void *ctx) {
+    service(e, now_ns);
+    unsigned n = 0;
+    while (e->line_count > 0 && e->pkts[e->line[0]].release_ns <= now_ns) {
+        uint32_t slot = line_pop(e);
+        const netem_pkt_t *p = &e->pkts[slot];
+        uint8_t *data = slot_data(e, slot);
+        if (p->len > 0 && e->cfg.corrupt > 0.0 && rng_chance(e->rng, e->cfg.corrupt)) {
+            uint64_t r = rng_next(e->rng);
+            data[r % p->len] ^= (uint8_t)(1u << (r >> 61));
+            e->corrupted++;
+        }
+        deliver(ctx, p->meta, p->meta_len, data, p->len);
+        slot_put(e, slot);
+        e->delivered++;
+        n++;
+    }
+    return n;
+}
+
+uint64_t netem_next_ns(const netem_t *e) {
+    uint64_t next = 0;
+    if (e->q_count > 0) next = head_start_ns(e);
+    if (e->line_count > 0) {
+        uint64_t rel = e->pkts[e->line[0]].release_ns;
+        if (next == 0 || rel < next) next = rel;
+    }
+    return next;
+}
+
+void netem_print_stats(const netem_t *e, const char *name, FILE *out) {
+    fprintf(out, "%s: 입력 %" PRIu64 " / 전달 %" PRIu64 " 패킷, 큐 드롭 %" PRIu64 ", %s 드롭 %" PRIu64
+                 ", 링크 손실 %" PRIu64 "\n",
+            name, e->enqueued, e->delivered, e->tail_drops, qdisc_name(e->cfg.qdisc), e->aqm_drops, e->wire_drops);
+    fprintf(out, "  최대 큐 %u 패킷, 최대 큐 대기 %.3f 밀리초", e->max_queue, (double)e->max_sojourn_ns / 1e6);
+    if (e->duplicated > 0) fprintf(out, ", 복제 %" PRIu64, e->duplicated);
+    if (e->reordered > 0) fprintf(out, ", 순서 뒤바꿈 %" PRIu64, e->reordered);
+    if (e->corrupted > 0) fprintf(out, ", 손상 %" PRIu64, e->corrupted);
+    if (e->overflows > 0) fprintf(out, ", 버퍼 부족 드롭 %" PRIu64, e->overflows);
+    fprintf(out, "\n");
+}
@@ -0,0 +1,129 @@
+#ifndef NETEM_H
+#define NETEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "rng.h"
+
+// Link emulator: one direction of a path as a bottleneck transmitter of
+// rate_bps fed by a bounded queue (drop-tail, RED or CoDel), followed by
+// wire loss (Bernoulli or Gilbert-Elliott bursts), optional duplication,
+// reordering and bit errors, and a propagation delay line. Packets are copied into a
+// preallocated slot pool; the queue is a FIFO of slot indices and the
+// delay line a min-heap ordered by release time, so every step is O(1) or
+// O(log n) with no allocation. Time is passed in by the caller: the
+// receiver runs it on CLOCK_MONOTONIC behind a timerfd, the simulator on
+// its virtual clock.
+
+#define NETEM_WIRE_OVERHEAD 28              // IPv4 + UDP header bytes per packet
+#define NETEM_META_MAX 32                   // caller data kept with each packet (peer address)
+#define NETEM_DEFAULT_LIMIT 1000            // queue capacity in packets
+#define NETEM_DEFAULT_SLOTS 65536           // packets held in queue + delay line
+#define NETEM_ARENA_MAX (256u << 20)        // fewer slots when they are large
+#define NETEM_CODEL_TARGET_NS 5000000ull    // RFC 8289 defaults
+#define NETEM_CODEL_INTERVAL_NS 100000000ull
+#define NETEM_RED_WEIGHT 0.002
+#define NETEM_RED_MAX_P 0.1
+
+// getopt letters shared by every program that embeds the emulator
+#define NETEM_OPTSTRING "r:d:Q:E:G:O:D:X:"
+
+enum {
+    NETEM_DROPTAIL = 0,
+    NETEM_RED,
+    NETEM_CODEL,
+};
+
+typedef struct {
+    uint64_t rate_bps;      // 0: no bottleneck, packets never queue
+    uint64_t delay_ns;      // one-way propagation delay
+    uint32_t limit;         // queue capacity in packets
+    int qdisc;
+    double loss;            // wire loss (in the good state with Gilbert-Elliott)
+    double ge_p;            // Gilbert-Elliott: P(good -> bad) per packet, 0 disables
+    double ge_r;            // P(bad -> good)
+    double ge_loss_bad;     // loss probability in the bad state
+    double reorder;         // probability a packet is held back ...
+    uint64_t reorder_ns;    // ... this much longer than the rest
+    double dup;             // probability a packet is delivered twice
+    double corrupt;         // probability a packet arrives with one bit flipped
+    uint32_t slots;
+    uint32_t slot_size;     // largest packet accepted
+} netem_config_t;
+
+typedef struct {
+    uint64_t enq_ns;
+    uint64_t release_ns;
+    uint64_t order;         // delay-line tie-break: release order is stable
+    uint32_t len;
+    uint32_t wire_len;
+    uint8_t meta_len;
+    uint8_t meta[NETEM_META_MAX];
+} netem_pkt_t;
+
+typedef struct {
+    netem_config_t cfg;
+    rng_t *rng;
+    netem_pkt_t *pkts;
+    uint8_t *arena;         // slot i's data at arena + i * slot_size
+    uint32_t *free_list;    // LIFO, so recently used (cache-warm) slots go first
+    uint32_t free_count;
+    uint32_t *queue;        // FIFO ring of slots waiting for the transmitter
+    uint32_t q_head;
+    uint32_t q_count;
+    uint64_t q_bytes;
+    uint32_t *line;         // delay line heap, ordered by (release_ns, order)
+    uint32_t line_count;
+    uint64_t next_order;
+    uint64_t busy_until_ns; // transmitter free from this time
+
+    bool ge_bad;
+    double red_avg;
+    int red_count;
+    uint64_t codel_first_above_ns;
+    uint64_t codel_drop_next_ns;
+    uint32_t codel_count;
+    uint32_t codel_lastcount;
+    bool codel_dropping;
+
+    uint64_t enqueued;
+    uint64_t delivered;
+    uint64_t tail_drops;
+    uint64_t aqm_drops;     // RED or CoDel
+    uint64_t wire_drops;
+    uint64_t overflows;     // slot pool exhausted
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t corrupted;
+    uint32_t max_queue;
+    uint64_t max_sojourn_ns;
+} netem_t;
+
+typedef void (*netem_deliver_fn)(void *ctx, const void *meta, uint32_t meta_len, const uint8_t *data, uint32_t len);
+
+// Everything off: no rate limit, no delay, no loss
+void netem_config_default(netem_config_t *cfg);
+// Any impairment configured
+bool netem_config_active(const netem_config_t *cfg);
+// Handle one NETEM_OPTSTRING option: 0 handled, -1 bad argument
+int netem_parse_opt(netem_config_t *cfg, int opt, const char *arg);
+void netem_usage(FILE *out);
+void netem_describe(const netem_config_t *cfg, FILE *out);
+
+int netem_init(netem_t *e, const netem_config_t *cfg, rng_t *rng);
+void netem_free(netem_t *e);
+
+// Offer a packet at now_ns; wire_len is what it costs on the bottleneck.
+// Returns false when it was dropped on arrival (queue full, RED, no slot).
+bool netem_enqueue(netem_t *e, uint64_t now_ns, const void *meta, uint32_t meta_len,
+                   const uint8_t *data, uint32_t len, uint32_t wire_len);
+// Hand every packet due by now_ns to deliver; returns how many
+unsigned netem_poll(netem_t *e, uint64_t now_ns, netem_deliver_fn deliver, void *ctx);
+// When netem_poll next has work, 0 when the emulator is empty
+uint64_t netem_next_ns(const netem_t *e);
+
+void netem_print_stats(const netem_t *e, const char *name, FILE *out);
+
+#endif
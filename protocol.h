@@ -0,0 +1,149 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wire format shared by sender and receiver. Every packet and ACK carries
+// the connection ID the sender picked, so a receiver can tell concurrent
+// transfers (and stray packets) apart even behind the same address.
+//
+// A connection opens with a SYN offering the wire version, features and
+// the largest payload the sender wants; the SYN-ACK answers with what the
+// receiver accepts. The sender then probes the path (DPLPMTUD, RFC 8899)
+// with padded PROBE packets between PLPMTU_BASE and the agreed limit and
+// uses the largest size that got through as its MSS.
+//
+// Every ACK also advertises the receive window: how many bytes above the
+// cumulative ACK the receiver can take right now. The sender keeps new
+// data inside it and, while it is closed with nothing in flight, sends
+// header-only WND_PROBE packets on a backed-off persist timer.
+//
+// With FEAT_CHECKSUM every packet from the sender carries a CRC32C of
+// itself (crc32c.h); the receiver drops a packet that fails it like a lost
+// one, so the sender repairs it the usual way. With FEAT_DIGEST the FIN
+// carries the CRC32C of everything the flow sent, which the receiver
+// checks against what it took in.
+//
+// With FEAT_FEC the sender follows every block of data segments with a
+// parity packet (fec.h), and a receiver missing one segment of a block
+// rebuilds it on the spot. ACKs count the segments rebuilt so the sender
+// still sees the loss rate it is protecting against.
+//
+// The FIN takes no sequence space and is answered with its own ACK_F_FIN;
+// the sender resends it on its RTO timer until that arrives.
+
+#define PROTO_VERSION 5
+
+#define DEFAULT_PAYLOAD 1400        // MSS when none is given
+#define MAX_DATAGRAM 65507          // largest UDP payload over IPv4
+#define PLPMTU_BASE 1200            // datagram size assumed to fit any path
+
+#define FLAG_FIN 0x01
+#define FLAG_SYN 0x02
+#define FLAG_PROBE 0x04
+#define FLAG_WND_PROBE 0x08   // zero-window probe: no payload, asks for an ACK
+
+// The high nibble of flags carries the ACK frequency the sender asks for:
+// one ACK per that many full-sized in-order segments (0 means 1). Every
+// data packet repeats it, so the sender can change it mid-transfer and a
+// receiver caps it at its own limit. Anything out of the ordinary (a gap,
+// a hole filled, a duplicate, FIN) is still ACKed at once.
+#define ACK_FREQ_SHIFT 4
+#define ACK_FREQ_MAX 15
+
+// Features negotiated in the handshake: the SYN offers, the SYN-ACK keeps
+// those the receiver implements
+enum {
+    FEAT_SACK = 0x0001,
+    FEAT_TIMESTAMPS = 0x0002,
+    FEAT_CHECKSUM = 0x0004,   // per-packet CRC32C
+    FEAT_DIGEST = 0x0008,     // flow CRC32C in the FIN
+    FEAT_FEC = 0x0010,        // XOR parity per block of segments
+};
+
+// packet_header_t.fec with FEAT_FEC: a data packet says FEC_DATA and the
+// log2 of its block length in segments, a parity packet FEC_PARITY and the
+// number of segments it covers less one. 0: not protected.
+#define FEC_DATA 0x40
+#define FEC_PARITY 0x80
+#define FEC_ARG_MASK 0x3f
+
+typedef struct __attribute__((packed)) {
+    uint32_t conn_id; // chosen by the sender, echoed in every ACK
+    uint32_t seq;     // sequence number (byte offset)
+    uint32_t len;     // payload length (padding for a PROBE)
+    uint8_t flags;    // bits 0-3: FLAG_*, bits 4-7: ACK frequency
+    uint32_t csum;    // FEAT_CHECKSUM: CRC32C of header and payload, else 0
+    uint8_t fec;      // FEAT_FEC: FEC_DATA/FEC_PARITY and its argument, else 0
+} packet_header_t;
+
+#define MAX_PAYLOAD (MAX_DATAGRAM - (int)sizeof(packet_header_t))
+
+// Payload of a SYN (seq 0, no sequence space). A striped sender opens one
+// connection per byte range of the file and announces the range with it;
+// the receiver writes the flow's byte n at offset + n. A single flow is
+// stripe 0 of 1 at offset 0.
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t features;    // FEAT_* offered
+    uint32_t max_payload; // largest payload the sender would use
+    uint32_t xfer_id;     // shared by every flow of one file
+    uint16_t stripe;      // index of this flow
+    uint16_t stripes;     // flows in the transfer
+    uint64_t offset;      // file offset of this flow's first byte
+    uint64_t size;        // whole file size
+} syn_t;
+
+// Payload of a FIN with FEAT_DIGEST (no sequence space)
+typedef struct __attribute__((packed)) {
+    uint64_t bytes;       // flow length
+    uint32_t digest;      // CRC32C of those bytes
+} fin_t;
+
+#define MAX_SACK_BLOCKS 4
+
+// Byte range received above the cumulative ACK
+typedef struct __attribute__((packed)) {
+    uint32_t start;
+    uint32_t end;     // exclusive
+} sack_block_t;
+
+#define ACK_F_SYN 0x01      // SYN-ACK: ctl_ack_t
+#define ACK_F_PROBE 0x02    // probe confirmation: ctl_ack_t
+#define ACK_F_FIN 0x04      // FIN confirmation: ctl_ack_t, value 0
+
+// Only the first sack_count blocks are sent: ACK_BASE_LEN + 8 * sack_count bytes
+typedef struct __attribute__((packed)) {
+    uint32_t conn_id;
+    uint32_t ack;     // next expected byte (cumulative ACK)
+    uint8_t flags;    // ACK_F_*, 0 for a data ACK
+    uint8_t sack_count;
+    uint32_t wnd;     // receive window: bytes accepted above ack
+    uint16_t fec_repaired; // FEAT_FEC: segments rebuilt from parity so far (mod 2^16)
+    sack_block_t sack[MAX_SACK_BLOCKS]; // most recently changed range first
+} ack_packet_t;
+
+#define ACK_BASE_LEN offsetof(ack_packet_t, sack)
+
+// SYN-ACK and probe ACK: an ack_packet_t prefix without SACK blocks, then
+// the receiver's answer
+typedef struct __attribute__((packed)) {
+    uint32_t conn_id;
+    uint32_t ack;
+    uint8_t flags;
+    uint8_t sack_count; // always 0
+    uint32_t wnd;       // initial receive window
+    uint16_t fec_repaired; // always 0
+    uint8_t version;    // receiver's wire version
+    uint8_t reserved;
+    uint16_t features;  // FEAT_* accepted
+    uint32_t value;     // SYN-ACK: payload limit; probe: datagram size received
+} ctl_ack_t;
+
+static inline size_t ack_wire_len(const ack_packet_t *ack) {
+    return ACK_BASE_LEN + (size_t)ack->sack_count * sizeof(sack_block_t);
+}
+
+#endif
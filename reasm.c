@@ -0,0 +1,101 @@
+#include "reasm.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+int reasm_init(reasm_t *ra, uint32_t max_ranges, uint64_t window) {
+    memset(ra, 0, sizeof(*ra));
+    if (max_ranges == 0) max_ranges = 1;
+    ra->ranges = calloc(max_ranges, sizeof(*ra->ranges));
+    if (!ra->ranges) return -1;
+    ra->cap = max_ranges;
+    ra->window = window;
+    return 0;
+}
+
+void reasm_free(reasm_t *ra) {
+    free(ra->ranges);
+    ra->ranges = NULL;
+    ra->count = 0;
+}
+
+// First range whose end is >= off (ranges that could touch or follow off)
+static uint32_t lower_bound(const reasm_t *ra, uint64_t off) {
+    uint32_t lo = 0, hi = ra->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ra->ranges[mid].end < off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int reasm_insert(reasm_t *ra, uint64_t off, uint32_t len) {
+    uint64_t start = off;
+    uint64_t end = off + len;
+    if (start < ra->next) start = ra->next;
+    if (end <= start) return REASM_DUP;
+    if (end > ra->next + ra->window) return REASM_OUT_OF_WINDOW;
+
+    // Merge with every range that overlaps or touches [start, end)
+    uint32_t i = lower_bound(ra, start);
+    uint32_t j = i;
+    uint64_t covered = 0;
+    while (j < ra->count && ra->ranges[j].start <= end) {
+        uint64_t lo = ra->ranges[j].start > start ? ra->ranges[j].start : start;
+        uint64_t hi = ra->ranges[j].end < end ? ra->ranges[j].end : end;
+        if (hi > lo) covered += hi - lo;
+        j++;
+    }
+    if (covered == end - start) return REASM_DUP;
+
+    if (j > i) {
+        if (ra->ranges[i].start < start) start = ra->ranges[i].start;
+        if (ra->ranges[j - 1].end > end) end = ra->ranges[j - 1].end;
+        uint64_t merged = 0;
+        for (uint32_t k = i; k < j; k++) merged += ra->ranges[k].end - ra->ranges[k].start;
+        ra->buffered_bytes -= merged;
+        // Collapse [i, j) into slot i
+        memmove(&ra->ranges[i + 1], &ra->ranges[j], (ra->count - j) * sizeof(*ra->ranges));
+        ra->count -= j - i - 1;
+    } else {
+        if (start > ra->next && ra->count == ra->cap) return REASM_FULL;
+        if (start > ra->next) {
+            memmove(&ra->ranges[i + 1], &ra->ranges[i], (ra->count - i) * sizeof(*ra->ranges));
+            ra->count++;
+        }
+    }
+
+    if (start <= ra->next) {
+        // Fills the hole at the cumulative point; slot i (== 0) is consumed
+        ra->next = end;
+        if (j > i) {
+            memmove(&ra->ranges[0], &ra->ranges[1], (ra->count - 1) * sizeof(*ra->ranges));
+            ra->count--;
+        }
+    } else {
+        ra->ranges[i].start = start;
+        ra->ranges[i].end = end;
+        ra->buffered_bytes += end - start;
+    }
+    return REASM_NEW;
+}
+
+uint32_t reasm_sack_ranges(const reasm_t *ra, uint64_t recent_off, reasm_range_t *out, uint32_t max) {
+    uint32_t n = 0;
+    uint32_t recent = ra->count;
+    if (max == 0) return 0;
+    uint32_t i = lower_bound(ra, recent_off + 1);
+    if (i < ra->count && ra->ranges[i].start <= recent_off) {
+        recent = i;
+        out[n++] = ra->ranges[i];
+    }
+    for (uint32_t k = 0; k < ra->count && n < max; k++) {
+        if (k != recent) out[n++] = ra->ranges[k];
+    }
+    return n;
+}
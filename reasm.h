@@ -0,0 +1,61 @@
+#ifndef REASM_H
+#define REASM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Receiver reassembly state: the cumulative in-order point plus a sorted set
+// of byte ranges received beyond it. Payload bytes are never buffered here;
+// the caller writes each segment straight to its file offset, so memory is
+// bounded by the preallocated range table.
+
+#define REASM_DEFAULT_RANGES 4096
+#define REASM_DEFAULT_WINDOW (64ull * 1024 * 1024)
+
+enum {
+    REASM_NEW = 0,          // new bytes recorded (in order or not)
+    REASM_DUP,              // everything already received
+    REASM_OUT_OF_WINDOW,    // beyond next + window
+    REASM_FULL,             // range table exhausted
+};
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;           // exclusive
+} reasm_range_t;
+
+typedef struct {
+    reasm_range_t *ranges;  // sorted, disjoint, non-adjacent, all above next
+    uint32_t count;
+    uint32_t cap;
+    uint64_t next;          // every byte below this has been received
+    uint64_t window;
+    uint64_t buffered_bytes; // bytes held above next
+} reasm_t;
+
+int reasm_init(reasm_t *ra, uint32_t max_ranges, uint64_t window);
+void reasm_free(reasm_t *ra);
+
+// Record [off, off + len). On REASM_NEW, next may jump past any holes the
+// segment filled.
+int reasm_insert(reasm_t *ra, uint64_t off, uint32_t len);
+
+// Fill out[] with up to max ranges for SACK: the range containing
+// recent_off first (if any), then the remaining ranges from the lowest up.
+uint32_t reasm_sack_ranges(const reasm_t *ra, uint64_t recent_off, reasm_range_t *out, uint32_t max);
+
+// Bytes above next that reasm_insert can still take: the whole window,
+// or only up to the highest range once the range table is exhausted
+static inline uint64_t reasm_room(const reasm_t *ra) {
+    if (ra->count < ra->cap) return ra->window;
+    return ra->ranges[ra->count - 1].end - ra->next;
+}
+
+// Extend a 32-bit wire seq to a 64-bit offset near the cumulative point
+static inline uint64_t reasm_offset(const reasm_t *ra, uint32_t wire_seq) {
+    int32_t delta = (int32_t)(wire_seq - (uint32_t)ra->next);
+    if (delta < 0 && (uint64_t)(-(int64_t)delta) > ra->next) return 0;
+    return ra->next + (int64_t)delta;
+}
+
+#endif
@@ -1,228 +1,1155 @@
+#define _GNU_SOURCE
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 
-#define MAX_PAYLOAD 1400
+#include "batch_io.h"
+#include "conntab.h"
+#include "evloop.h"
+#include "netem.h"
+#include "protocol.h"
+#include "reasm.h"
+#include "rng.h"
+#include "rxconn.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "writer.h"
 
-typedef struct __attribute__((packed)) {
-    uint32_t seq;     // sequence number (byte offset)
-    uint32_t len;     // payload length
-    uint8_t flags;    // bit 0: FIN
-} packet_header_t;
+// One receive path per worker: a socket (SO_REUSEPORT in server mode, so
+// the kernel spreads senders across workers by 4-tuple), its batches, an
+// event loop and a table of the connections it has seen. A connection is
+// keyed by peer address and the sender's connection ID and owns its
+// reassembly state. Its data goes to a transfer (one output file): a plain
+// sender's single flow, or every flow of a striped (-j) sender, which may
+// land on different workers. Transfers are the only shared state.
+//
+// Each worker hands its file writes to a writer thread of its own (see
+// writer.h), so a slow disk shows up as a smaller receive window instead of
+// a stalled receive loop.
 
-typedef struct __attribute__((packed)) {
-    uint32_t ack;     // next expected byte (cumulative ACK)
-    uint8_t dup;      // duplicate counter hint (unused by receiver)
-} ack_packet_t;
+#define CONN_TABLE_INITIAL 1024
+#define CONN_IDLE_NS (30ull * 1000000000ull)     // unfinished transfer abandoned
+#define CONN_LINGER_NS (2ull * 1000000000ull)    // finished one kept to re-ACK a late FIN
+#define SWEEP_INTERVAL_NS 1000000000ull
+#define RX_SOCKBUF (4 * 1024 * 1024)             // asked for; the kernel caps it at rmem_max
 
-static uint32_t rand32(void) {
-    return ((uint32_t)rand() << 1) ^ (uint32_t)rand();
-}
+typedef struct {
+    int listen_port;
+    const char *output_path;        // file, or directory in server mode
+    bool save_to_file;
+    bool server;
+    int batch_size;
+    bool use_gro;
+    uint64_t reasm_window;
+    uint32_t ack_freq_max;
+    uint64_t ack_delay_ns;
+    uint32_t max_payload;           // offered to senders in the SYN-ACK
+    uint64_t rcv_wnd;               // cap on the advertised window, 0: socket buffer
+    bool sync_write;                // pwrite() from the receive loop, no writer thread
+    bool direct;                    // O_DIRECT for the writer thread
+    bool fsync;                     // fsync each file once its data is complete
+    uint64_t write_pool;            // writer buffer pool per worker, bytes
+    double loss_prob;
+    uint32_t force_drop_seq;
+    bool use_force_drop;
+    uint64_t seed;
+    netem_config_t link;
+} rx_config_t;
 
-static bool should_drop(double loss_probability) {
-    if (loss_probability <= 0.0) return false;
-    if (loss_probability >= 1.0) return true;
-    uint32_t r = rand32();
-    double u = (double)r / (double)UINT32_MAX;
-    return u < loss_probability;
-}
+typedef struct worker worker_t;
+
+// One output file. A striped transfer is found by (peer address, xfer_id)
+// on xfers; a single-flow one is private to its connection.
+typedef struct xfer {
+    struct xfer *next;
+    uint32_t addr;          // IPv4, network byte order
+    uint32_t id;            // syn_t.xfer_id, 0 for a single flow in server mode
+    int fd;                 // segments are pwrite()n at their file offset
+    uint16_t stripes;
+    uint16_t joined;
+    uint16_t finished;
+    int refs;               // connections pointing here
+    uint64_t bytes;
+    uint64_t start_ns;
+} xfer_t;
+
+static pthread_mutex_t xfers_lock = PTHREAD_MUTEX_INITIALIZER;
+static xfer_t *xfers;
+
+typedef struct {
+    rxconn_t rc;
+    worker_t *w;
+    conn_key_t key;
+    struct sockaddr_in peer;
+    xfer_t *x;
+    uint64_t base;          // file offset of the flow's byte 0
+    uint16_t stripe;
+    evloop_timer_t ack_timer;   // delayed ACK
+    uint64_t start_ns;
+    uint64_t last_ns;
+    uint64_t fin_ns;        // 0 until the transfer completed
+    writer_file_t wf;       // fd < 0 unless writing through the worker's writer
+    char name[48];          // a.b.c.d:port#conn_id
+} conn_t;
+
+struct worker {
+    int id;
+    const rx_config_t *cfg;
+    int sockfd;
+    uint64_t rcv_wnd;       // advertised window cap for its connections
+    batch_rx_t rx;
+    batch_tx_t tx;
+    evloop_t loop;
+    evloop_handler_t sock_ev;
+    evloop_handler_t stop_ev;
+    int stop_fd;            // eventfd: main thread asks the worker to exit
+    evloop_timer_t sweep_timer;
+    conntab_t conns;
+    pthread_t thread;
+
+    // Single-transfer mode: the first transfer wins, the rest is stray
+    int single_fd;          // output file opened up front
+    trace_t single_trace;   // handed to the first connection
+    xfer_t *single;
+    bool done;
+    telem_stats_t *stats;   // live counters (the file, or share), NULL when off
+    evloop_timer_t stats_timer;
+    uint64_t stats_ns;      // update interval
+    telem_stats_t share;    // server mode: summed into the file by the main thread
+    telem_counters_t retired;   // connections swept from the table
+
+    // Optional link emulation between the socket and the connections
+    bool use_em;
+    netem_t em;
+    rng_t em_rng;
+    evloop_timer_t em_timer;
+
+    bool use_writer;
+    writer_t wr;
+    evloop_handler_t wr_ev;     // writer event_fd: chunks completed
+
+    // Receive loop latency: one on_socket call, packets through ACKs
+    uint64_t batches;
+    uint64_t batch_ns_sum;
+    uint64_t batch_ns_max;
+
+    uint64_t conns_opened;
+    uint64_t conns_finished;
+    uint64_t conns_expired;
+    uint64_t bytes;
+    uint64_t stray_packets;
+    uint64_t digest_ok;
+    uint64_t digest_bad;
+};
 
 static void die(const char *msg) {
     perror(msg);
     exit(EXIT_FAILURE);
 }
 
-int main(int argc, char **argv) {
-    if (argc < 3 || argc > 5) {
-        fprintf(stderr, "사용법: %s <수신_포트> <출력파일|-> [손실확률 0.0-1.0] [강제드롭_seq]\n", argv[0]);
-        fprintf(stderr, "예시: %s 9000 output.bin 0.05\n", argv[0]);
-        fprintf(stderr, "예시: %s 9000 - 0.05  (파일 저장 안 함)\n", argv[0]);
-        fprintf(stderr, "예시: %s 9000 output.bin 0 7000  (seq 7000 패킷 강제 드롭)\n", argv[0]);
-        return EXIT_FAILURE;
+static void write_at(int fd, const uint8_t *data, size_t len, uint64_t off) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, data, len, (off_t)off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "오류: 파일 쓰기 실패\n");
+            exit(EXIT_FAILURE);
+        }
+        data += n;
+        len -= (size_t)n;
+        off += (uint64_t)n;
     }
+}
+
+static uint64_t io_now_ns(void *ctx) {
+    (void)ctx;
+    return evloop_now_ns();
+}
+
+// ACKs are queued and flushed once per received batch
+static void io_send_ack(void *ctx, const void *ack, size_t len) {
+    conn_t *c = ctx;
+    (void)batch_tx_add(&c->w->tx, ack, len, NULL, 0, (const struct sockaddr *)&c->peer, sizeof(c->peer));
+}
+
+static void io_deliver(void *ctx, const uint8_t *data, uint32_t len, uint64_t off) {
+    conn_t *c = ctx;
+    write_at(c->x->fd, data, len, c->base + off);
+}
+
+static void io_deliver_async(void *ctx, const uint8_t *data, uint32_t len, uint64_t off) {
+    conn_t *c = ctx;
+    writer_put(&c->w->wr, &c->wf, data, len, c->base + off);
+}
 
-    int listen_port = atoi(argv[1]);
-    const char *output_path = argv[2];
-    double loss_prob = 0.0;
-    uint32_t force_drop_seq = 0;
-    bool use_force_drop = false;
-    
-    if (argc >= 4) {
-        loss_prob = atof(argv[3]);
-        if (loss_prob < 0.0) loss_prob = 0.0;
-        if (loss_prob > 1.0) loss_prob = 1.0;
+// The pool, not the socket, holds what the disk has not taken yet: the
+// window shrinks only once less than rcv_buf of it is left. The pool is the
+// worker's, so every connection on it sees the same room.
+static uint64_t io_backlog(void *ctx) {
+    conn_t *c = ctx;
+    uint64_t room = writer_room(&c->w->wr);
+    return room < c->rc.rcv_buf ? c->rc.rcv_buf - room : 0;
+}
+
+// Lazy: an armed timer that fires earlier is left alone, rxconn re-checks
+static void io_ack_timer(void *ctx, uint64_t deadline_ns) {
+    conn_t *c = ctx;
+    if (evloop_timer_armed(&c->ack_timer) && c->ack_timer.deadline_ns <= deadline_ns) return;
+    if (evloop_timer_arm_at(&c->ack_timer, deadline_ns) < 0) die("timerfd_settime");
+}
+
+static void on_ack_timer(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    conn_t *c = arg;
+    rxconn_on_timer(&c->rc);
+    (void)batch_tx_flush(&c->w->tx);
+}
+
+static xfer_t *xfer_new(uint32_t addr, uint32_t id, uint16_t stripes, int fd, uint64_t now_ns) {
+    xfer_t *x = calloc(1, sizeof(*x));
+    if (!x) die("calloc");
+    x->addr = addr;
+    x->id = id;
+    x->fd = fd;
+    x->stripes = stripes;
+    x->start_ns = now_ns;
+    return x;
+}
+
+// The transfer a new connection writes to, NULL to ignore the connection.
+// Called with xfers_lock held.
+static xfer_t *xfer_attach(worker_t *w, const conn_key_t *key, const char *ip, const syn_t *syn, uint64_t now_ns) {
+    const rx_config_t *cfg = w->cfg;
+    uint32_t id = ntohl(syn->xfer_id);
+    uint16_t stripes = ntohs(syn->stripes);
+    if (stripes == 0) return NULL;
+    xfer_t *x = NULL;
+    if (!cfg->server) {
+        x = w->single;
+        if (x && (x->id != id || x->addr != key->addr)) return NULL;
+        if (!x) {
+            x = w->single = xfer_new(key->addr, id, stripes, w->single_fd, now_ns);
+            w->single_fd = -1;
+            if (x->fd >= 0 && ftruncate(x->fd, (off_t)be64toh(syn->size)) < 0) die("ftruncate");
+        }
+    } else if (stripes > 1) {
+        for (x = xfers; x && (x->addr != key->addr || x->id != id); x = x->next) {}
+        if (!x) {
+            int fd = -1;
+            if (cfg->save_to_file) {
+                // No O_TRUNC: a SYN arriving after the transfer was reaped
+                // must not wipe the file it wrote
+                char path[4096];
+                snprintf(path, sizeof(path), "%s/%s_%08x.bin", cfg->output_path, ip, id);
+                fd = open(path, O_WRONLY | O_CREAT, 0644);
+                if (fd < 0) fprintf(stderr, "오류: 출력 파일을 생성할 수 없습니다: %s\n", path);
+                if (fd >= 0 && ftruncate(fd, (off_t)be64toh(syn->size)) < 0) die("ftruncate");
+            }
+            x = xfer_new(key->addr, id, stripes, fd, now_ns);
+            x->next = xfers;
+            xfers = x;
+        }
+    } else {
+        int fd = -1;
+        if (cfg->save_to_file) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%s_%u_%08x.bin", cfg->output_path, ip, ntohs(key->port), key->conn_id);
+            fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) fprintf(stderr, "오류: 출력 파일을 생성할 수 없습니다: %s\n", path);
+        }
+        x = xfer_new(key->addr, 0, 1, fd, now_ns);
     }
-    if (argc == 5) {
-        force_drop_seq = (uint32_t)atoi(argv[4]);
-        use_force_drop = true;
+    x->joined++;
+    x->refs++;
+    return x;
+}
+
+static void xfer_detach(xfer_t *x) {
+    pthread_mutex_lock(&xfers_lock);
+    if (--x->refs == 0) {
+        if (x->fd >= 0) close(x->fd);
+        for (xfer_t **pp = &xfers; *pp; pp = &(*pp)->next) {
+            if (*pp == x) {
+                *pp = x->next;
+                break;
+            }
+        }
+        free(x);
     }
+    pthread_mutex_unlock(&xfers_lock);
+}
 
-    srand((unsigned)time(NULL));
+static conn_t *conn_open(worker_t *w, const conn_key_t *key, const struct sockaddr_in *peer,
+                         const syn_t *syn, uint64_t now_ns) {
+    const rx_config_t *cfg = w->cfg;
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &peer->sin_addr, ip, sizeof(ip));
+    pthread_mutex_lock(&xfers_lock);
+    xfer_t *x = xfer_attach(w, key, ip, syn, now_ns);
+    pthread_mutex_unlock(&xfers_lock);
+    if (!x) return NULL;
 
-    printf("=== 수신 프로그램 시작 ===\n");
-    printf("수신 포트: %d\n", listen_port);
-    bool save_to_file = (strcmp(output_path, "-") != 0);
-    if (save_to_file) {
-        printf("출력 파일: %s\n", output_path);
-    } else {
-        printf("출력 파일: 저장 안 함 (화면 출력만)\n");
+    conn_t *c = calloc(1, sizeof(*c));
+    if (!c) die("calloc");
+    c->w = w;
+    c->key = *key;
+    c->peer = *peer;
+    c->x = x;
+    c->base = be64toh(syn->offset);
+    c->stripe = ntohs(syn->stripe);
+    c->start_ns = now_ns;
+    c->last_ns = now_ns;
+    snprintf(c->name, sizeof(c->name), "%s:%u#%08x", ip, ntohs(peer->sin_port), key->conn_id);
+
+    rxconn_io_t io = {
+        .ctx = c,
+        .now_ns = io_now_ns,
+        .send_ack = io_send_ack,
+        .deliver = x->fd >= 0 ? io_deliver : NULL,
+        .timer = io_ack_timer,
+    };
+    c->wf.fd = -1;
+    if (x->fd >= 0 && w->use_writer) {
+        if (writer_file_open(&w->wr, &c->wf, x->fd, cfg->direct) < 0) {
+            if (c->wf.fd < 0) die("dup");
+            printf("경고: O_DIRECT로 열 수 없어 페이지 캐시를 거쳐 씁니다 (%s)\n", strerror(errno));
+        }
+        io.deliver = io_deliver_async;
+        io.backlog = io_backlog;
     }
-    if (use_force_drop) {
-        printf("강제 패킷 드롭: seq %u 패킷 드롭\n", force_drop_seq);
-    } else if (loss_prob > 0.0) {
-        printf("패킷 손실 시뮬레이션: %.1f%%\n", loss_prob * 100.0);
+    uint64_t conn_seed = cfg->seed ^ ((uint64_t)key->conn_id << 32 | key->port);
+    if (rxconn_init(&c->rc, &io, cfg->reasm_window, conn_seed) < 0) die("reasm_init");
+    c->rc.conn_id = key->conn_id;
+    c->rc.loss_prob = cfg->loss_prob;
+    c->rc.force_drop_seq = cfg->force_drop_seq;
+    c->rc.use_force_drop = cfg->use_force_drop;
+    c->rc.ack_freq_max = cfg->ack_freq_max;
+    c->rc.ack_delay_ns = cfg->ack_delay_ns;
+    c->rc.max_payload = cfg->max_payload;
+    c->rc.rcv_buf = w->rcv_wnd;
+    evloop_timer_init(&w->loop, &c->ack_timer, on_ack_timer, c);
+    if (cfg->server) {
+        trace_init(&c->rc.trace, TRACE_OFF);
+    } else if (w->single_trace.mode == TRACE_FILE) {
+        // The ring has one owner; later flows of a striped transfer log nothing
+        c->rc.trace = w->single_trace;
+        trace_init(&w->single_trace, TRACE_OFF);
     } else {
-        printf("패킷 손실 시뮬레이션: 없음\n");
+        trace_init(&c->rc.trace, w->single_trace.mode);
     }
-    printf("대기 중...\n");
+    if (conntab_put(&w->conns, key, c) < 0) die("conntab_put");
+    w->conns_opened++;
+    if (cfg->server && x->stripes > 1) {
+        printf("[워커 %d] 새 연결 %s (전송 %08x 흐름 %u/%u, 오프셋 %" PRIu64 ")\n",
+               w->id, c->name, x->id, c->stripe, x->stripes, c->base);
+    } else if (cfg->server) {
+        printf("[워커 %d] 새 연결 %s\n", w->id, c->name);
+    } else if (x->stripes > 1) {
+        printf("흐름 %u/%u 연결: %s, 오프셋 %" PRIu64 "\n", c->stripe, x->stripes, c->name, c->base);
+    }
+    return c;
+}
 
-    FILE *fout = NULL;
-    if (save_to_file) {
-        fout = fopen(output_path, "wb");
-        if (!fout) {
-            fprintf(stderr, "오류: 출력 파일을 생성할 수 없습니다: %s\n", output_path);
-            exit(EXIT_FAILURE);
+static void conn_close(conn_t *c) {
+    writer_file_close(&c->w->wr, &c->wf, false);
+    evloop_timer_close(&c->ack_timer);
+    xfer_detach(c->x);
+    rxconn_free(&c->rc);
+    free(c);
+}
+
+static const char *digest_note(uint8_t state) {
+    switch (state) {
+    case RX_DIGEST_OK:
+        return ", 다이제스트 일치";
+    case RX_DIGEST_BAD:
+        return ", 다이제스트 불일치!";
+    case RX_DIGEST_UNKNOWN:
+        return ", 다이제스트 확인 불가";
+    default:
+        return "";
+    }
+}
+
+static void conn_finished(worker_t *w, conn_t *c, uint64_t now_ns) {
+    c->fin_ns = now_ns;
+    w->conns_finished++;
+    w->bytes += c->rc.total_bytes;
+    // Data is complete; later packets of this flow are only re-ACKed
+    c->rc.io.deliver = NULL;
+    xfer_t *x = c->x;
+    if (c->wf.fd >= 0) {
+        writer_file_close(&w->wr, &c->wf, w->cfg->fsync);
+    } else if (w->cfg->fsync && x->fd >= 0 && fsync(x->fd) < 0) {
+        die("fsync");
+    }
+    pthread_mutex_lock(&xfers_lock);
+    x->bytes += c->rc.total_bytes;
+    bool all = ++x->finished >= x->stripes;
+    if (all && w->cfg->server && x->fd >= 0) {
+        close(x->fd);
+        x->fd = -1;
+    }
+    pthread_mutex_unlock(&xfers_lock);
+    if (c->rc.digest_state == RX_DIGEST_OK) w->digest_ok++;
+    if (c->rc.digest_state == RX_DIGEST_BAD) w->digest_bad++;
+    if (!w->cfg->server) {
+        w->done = all;
+        return;
+    }
+    double sec = (double)(now_ns - c->start_ns) / 1e9;
+    printf("[워커 %d] 연결 %s 완료: %" PRIu64 " 바이트, %.3f 초, %.2f MB/s, 패킷 %u (드롭 %u, 순서 외 %u, 중복 %u, 손상 %u)%s\n",
+           w->id, c->name, c->rc.total_bytes, sec, sec > 0.0 ? (double)c->rc.total_bytes / 1024.0 / 1024.0 / sec : 0.0,
+           c->rc.total_packets, c->rc.dropped_packets, c->rc.out_of_order_packets, c->rc.duplicate_packets,
+           c->rc.corrupt_packets, digest_note(c->rc.digest_state));
+    if (all && x->stripes > 1) {
+        sec = (double)(now_ns - x->start_ns) / 1e9;
+        printf("[워커 %d] 전송 %08x 완료: 흐름 %u개, %" PRIu64 " 바이트, %.3f 초, %.2f MB/s\n",
+               w->id, x->id, x->stripes, x->bytes, sec, sec > 0.0 ? (double)x->bytes / 1024.0 / 1024.0 / sec : 0.0);
+    }
+}
+
+// Demultiplex one wire packet to its connection
+static void worker_packet(worker_t *w, const struct sockaddr *addr, socklen_t addrlen, const uint8_t *buf, size_t n) {
+    if (n < sizeof(packet_header_t) || addrlen < sizeof(struct sockaddr_in) || addr->sa_family != AF_INET) return;
+    const struct sockaddr_in *peer = (const struct sockaddr_in *)addr;
+    packet_header_t hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    conn_key_t key = {
+        .addr = peer->sin_addr.s_addr,
+        .conn_id = ntohl(hdr.conn_id),
+        .port = peer->sin_port,
+    };
+    uint64_t now_ns = evloop_now_ns();
+    conn_t *c = conntab_get(&w->conns, &key);
+    if (!c) {
+        // A flow starts with its SYN; anything else belongs to a
+        // connection we never saw or already reaped
+        syn_t syn;
+        if (!(hdr.flags & FLAG_SYN) || n < sizeof(hdr) + sizeof(syn)) {
+            w->stray_packets++;
+            return;
+        }
+        memcpy(&syn, buf + sizeof(hdr), sizeof(syn));
+        c = conn_open(w, &key, peer, &syn, now_ns);
+        if (!c) {
+            w->stray_packets++;
+            return;
+        }
+    }
+    c->last_ns = now_ns;
+    rxconn_on_packet(&c->rc, buf, n);
+    if (c->rc.fin_received && c->fin_ns == 0) conn_finished(w, c, now_ns);
+}
+
+static void em_deliver(void *ctx, const void *meta, uint32_t meta_len, const uint8_t *data, uint32_t len) {
+    worker_packet(ctx, meta, meta_len, data, len);
+}
+
+// Hand over everything the emulated link has delivered by now and sleep
+// until its next departure or arrival
+static void em_run(worker_t *w) {
+    netem_poll(&w->em, evloop_now_ns(), em_deliver, w);
+    uint64_t next = netem_next_ns(&w->em);
+    if (next == 0) {
+        evloop_timer_disarm(&w->em_timer);
+    } else if (evloop_timer_arm_at(&w->em_timer, next) < 0) {
+        die("timerfd_settime");
+    }
+}
+
+static void on_em_timer(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    worker_t *w = arg;
+    em_run(w);
+    (void)batch_tx_flush(&w->tx);
+    if (w->done) evloop_stop(loop);
+}
+
+// The writer thread finished chunks: the pool has room again, so windows
+// that were shut for lack of it may reopen
+static void on_writer(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    worker_t *w = arg;
+    writer_reap(&w->wr);
+    writer_kick(&w->wr);
+    conntab_t *t = &w->conns;
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        conn_t *c = t->slots[i].val;
+        if (c && c->wf.fd >= 0) rxconn_on_drain(&c->rc);
+    }
+    (void)batch_tx_flush(&w->tx);
+}
+
+static void on_socket(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    worker_t *w = arg;
+    // Take whatever is already queued in one recvmmsg
+    int got = batch_rx_recv(&w->rx, MSG_DONTWAIT);
+    if (got < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+        die("recvmmsg");
+    }
+    uint64_t t0 = evloop_now_ns();
+
+    uint64_t now_ns = w->use_em ? evloop_now_ns() : 0;
+    for (unsigned i = 0; i < (unsigned)got && !w->done; i++) {
+        socklen_t peerlen;
+        const struct sockaddr *peer = batch_rx_addr(&w->rx, i, &peerlen);
+        const uint8_t *dgram = batch_rx_buf(&w->rx, i);
+        size_t dgram_len = batch_rx_len(&w->rx, i);
+        // With GRO one datagram carries several wire packets of seg_size
+        // bytes each (the last may be shorter); handle them one by one so
+        // loss simulation still applies per packet.
+        size_t seg_size = batch_rx_segsize(&w->rx, i);
+        for (size_t off = 0; off < dgram_len && !w->done; off += seg_size) {
+            size_t n = dgram_len - off < seg_size ? dgram_len - off : seg_size;
+            if (w->use_em) {
+                netem_enqueue(&w->em, now_ns, peer, peerlen, dgram + off, (uint32_t)n, (uint32_t)n + NETEM_WIRE_OVERHEAD);
+            } else {
+                worker_packet(w, peer, peerlen, dgram + off, n);
+            }
         }
     }
+    if (w->use_em) em_run(w);
+    if (w->use_writer) writer_kick(&w->wr);
+    (void)batch_tx_flush(&w->tx);
+    uint64_t dt = evloop_now_ns() - t0;
+    w->batches++;
+    w->batch_ns_sum += dt;
+    if (dt > w->batch_ns_max) w->batch_ns_max = dt;
+    if (w->done) evloop_stop(loop);
+}
+
+// Drop finished connections after the linger time and abandoned ones
+static void on_sweep(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    worker_t *w = arg;
+    uint64_t now_ns = evloop_now_ns();
+    conntab_t *t = &w->conns;
+    for (uint32_t i = 0; i <= t->mask;) {
+        conn_t *c = t->slots[i].val;
+        bool expired = c && (c->fin_ns ? now_ns - c->fin_ns > CONN_LINGER_NS : now_ns - c->last_ns > CONN_IDLE_NS);
+        if (!expired) {
+            i++;
+            continue;
+        }
+        if (!c->fin_ns) {
+            w->conns_expired++;
+            printf("[워커 %d] 연결 %s 시간 초과: %" PRIu64 " 바이트 수신 후 중단\n", w->id, c->name, c->rc.total_bytes);
+        }
+        // Its counts stay in the totals; deletion shifts the next entry
+        // into slot i, so look at it again
+        rxconn_add_counters(&c->rc, &w->retired);
+        conntab_del(t, &c->key);
+        conn_close(c);
+    }
+    if (evloop_timer_arm(&w->sweep_timer, SWEEP_INTERVAL_NS) < 0) die("timerfd_settime");
+}
+
+static void on_stop(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    worker_t *w = arg;
+    uint64_t v;
+    (void)read(w->stop_fd, &v, sizeof(v));
+    evloop_stop(loop);
+}
+
+static void worker_init(worker_t *w, int id, const rx_config_t *cfg) {
+    w->id = id;
+    w->cfg = cfg;
+    trace_init(&w->single_trace, TRACE_OFF);
+    if (conntab_init(&w->conns, CONN_TABLE_INITIAL) < 0) die("conntab_init");
 
+    // Blocking for ACK sends, like the sender's; receives pass MSG_DONTWAIT
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0) {
         fprintf(stderr, "오류: 소켓 생성 실패\n");
         exit(EXIT_FAILURE);
     }
-
+    w->sockfd = sockfd;
+    if (cfg->server) {
+        int one = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) die("SO_REUSEPORT");
+    }
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    addr.sin_port = htons((uint16_t)listen_port);
+    addr.sin_port = htons((uint16_t)cfg->listen_port);
     if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        fprintf(stderr, "오류: 포트 바인딩 실패 (포트 %d)\n", listen_port);
+        fprintf(stderr, "오류: 포트 바인딩 실패 (포트 %d)\n", cfg->listen_port);
         exit(EXIT_FAILURE);
     }
-    printf("포트 %d에서 수신 대기 중...\n", listen_port);
 
-    uint32_t expected_seq = 0; // cumulative in-order byte offset expected
-    bool fin_received = false;
-    uint32_t total_packets = 0;
-    uint32_t dropped_packets = 0;
-    uint32_t out_of_order_packets = 0;
-    uint32_t total_bytes = 0;
+    // Large datagrams need room in the socket too, or a burst of them overflows it
+    int sockbuf = RX_SOCKBUF;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &sockbuf, sizeof(sockbuf)) < 0) {
+        (void)setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &sockbuf, sizeof(sockbuf));
+    }
+    // Unacknowledged data sits in the socket until we get to it, so the
+    // window is what the buffer holds. The kernel reports twice the usable
+    // size (the other half covers its bookkeeping).
+    w->rcv_wnd = cfg->rcv_wnd;
+    if (w->rcv_wnd == 0) {
+        socklen_t optlen = sizeof(sockbuf);
+        if (getsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &sockbuf, &optlen) < 0) die("SO_RCVBUF");
+        w->rcv_wnd = (uint64_t)sockbuf / 2;
+    }
+    if (id == 0) printf("수신 윈도우: 최대 %" PRIu64 " 바이트%s\n", w->rcv_wnd, cfg->rcv_wnd ? "" : " (소켓 수신 버퍼)");
+    // Nothing longer than the payload we agree to can be a valid packet
+    size_t rx_buf = sizeof(packet_header_t) + cfg->max_payload;
+    if (batch_rx_init(&w->rx, sockfd, (unsigned)cfg->batch_size, rx_buf) < 0) die("batch_rx_init");
+    if (batch_tx_init(&w->tx, sockfd, (unsigned)cfg->batch_size) < 0) die("batch_tx_init");
+    if (cfg->use_gro && batch_rx_enable_gro(&w->rx) < 0 && id == 0) {
+        printf("경고: UDP GRO를 지원하지 않아 일반 수신을 사용합니다\n");
+    } else if (cfg->use_gro && id == 0) {
+        printf("UDP GRO 사용\n");
+    }
 
-    uint8_t buffer[sizeof(packet_header_t) + MAX_PAYLOAD];
+    if (evloop_init(&w->loop) < 0) die("epoll_create1");
+    if (evloop_add(&w->loop, &w->sock_ev, sockfd, EPOLLIN, on_socket, w) < 0) die("epoll_ctl");
+    if (cfg->save_to_file && !cfg->sync_write) {
+        if (writer_init(&w->wr, cfg->write_pool) < 0) die("writer_init");
+        if (evloop_add(&w->loop, &w->wr_ev, w->wr.event_fd, EPOLLIN, on_writer, w) < 0) die("epoll_ctl");
+        w->use_writer = true;
+    }
+    if (netem_config_active(&cfg->link)) {
+        rng_seed(&w->em_rng, cfg->seed ^ 0x6e6574656dull ^ (uint64_t)id);
+        if (netem_init(&w->em, &cfg->link, &w->em_rng) < 0) die("netem_init");
+        evloop_timer_init(&w->loop, &w->em_timer, on_em_timer, w);
+        w->use_em = true;
+    }
+    w->stop_fd = -1;
+    if (cfg->server) {
+        w->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (w->stop_fd < 0) die("eventfd");
+        if (evloop_add(&w->loop, &w->stop_ev, w->stop_fd, EPOLLIN, on_stop, w) < 0) die("epoll_ctl");
+        evloop_timer_init(&w->loop, &w->sweep_timer, on_sweep, w);
+        if (evloop_timer_arm(&w->sweep_timer, SWEEP_INTERVAL_NS) < 0) die("timerfd_settime");
+    }
+}
 
-    printf("----------------------------------------\n");
-    while (1) {
-        struct sockaddr_in peer = {0};
-        socklen_t peerlen = sizeof(peer);
-        ssize_t n = recvfrom(sockfd, buffer, sizeof(buffer), 0, (struct sockaddr *)&peer, &peerlen);
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            die("recvfrom");
-        }
-        if ((size_t)n < sizeof(packet_header_t)) {
-            // ignore malformed
-            continue;
-        }
+static void worker_free(worker_t *w) {
+    conntab_t *t = &w->conns;
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        if (t->slots[i].val) conn_close(t->slots[i].val);
+    }
+    conntab_free(t);
+    if (w->use_writer) writer_free(&w->wr);
+    if (w->single_fd >= 0) close(w->single_fd);
+    trace_close(&w->single_trace);
+    if (w->stats) {
+        evloop_timer_close(&w->stats_timer);
+        if (w->stats != &w->share) telem_stats_close(w->stats);
+    }
+    if (w->use_em) {
+        evloop_timer_close(&w->em_timer);
+        netem_free(&w->em);
+    }
+    if (w->cfg->server) {
+        evloop_timer_close(&w->sweep_timer);
+        close(w->stop_fd);
+    }
+    evloop_close(&w->loop);
+    batch_rx_free(&w->rx);
+    batch_tx_free(&w->tx);
+    close(w->sockfd);
+}
 
-        packet_header_t hdr;
-        memcpy(&hdr, buffer, sizeof(hdr));
-        uint32_t seq = ntohl(hdr.seq);
-        uint32_t len = ntohl(hdr.len);
-        uint8_t flags = hdr.flags;
+// Counters of every connection (the flows of a striped transfer sum) into
+// the stats block. Connections the sweep removed stay in the counts, so
+// they never run backwards; flows and adv_wnd are the ones still here.
+static void worker_publish(worker_t *w) {
+    telem_counters_t c = w->retired;
+    c.flows = 0;
+    c.adv_wnd = 0;
+    for (uint32_t i = 0; i <= w->conns.mask; i++) {
+        const conn_t *conn = w->conns.slots[i].val;
+        if (conn) rxconn_add_counters(&conn->rc, &c);
+    }
+    c.t_ns = evloop_now_ns() - w->stats->start_ns;
+    c.done = w->done;
+    telem_stats_publish(w->stats, &c);
+}
 
-        if (sizeof(hdr) + len != (size_t)n) {
-            // size mismatch, ignore
-            continue;
-        }
+static void on_stats(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    worker_t *w = arg;
+    worker_publish(w);
+    if (evloop_timer_arm(&w->stats_timer, w->stats_ns) < 0) die("timerfd_settime");
+}
 
-        total_packets++;
-
-        // 강제 드롭 (데모용)
-        bool should_drop_packet = false;
-        if (use_force_drop && seq == force_drop_seq) {
-            should_drop_packet = true;
-        } else if (!use_force_drop && should_drop(loss_prob)) {
-            should_drop_packet = true;
-        }
-        
-        // Potentially simulate loss
-        if (should_drop_packet) {
-            // drop silently
-            dropped_packets++;
-            printf("---→ 패킷 (seq:%u, size:%u) 손실\n", seq, len);
-            // Still send ACK for what we expect (cumulative ACK)
-            ack_packet_t ack = {0};
-            ack.ack = htonl(expected_seq);
-            ack.dup = 0;
-            (void)sendto(sockfd, &ack, sizeof(ack), 0, (struct sockaddr *)&peer, peerlen);
-            printf("<--- ACK %u 송신\n", expected_seq);
-            continue;
+// Publish to st every interval_ns from the worker's loop
+static void worker_start_stats(worker_t *w, telem_stats_t *st, uint64_t interval_ns) {
+    w->stats = st;
+    w->stats_ns = interval_ns;
+    evloop_timer_init(&w->loop, &w->stats_timer, on_stats, w);
+    if (evloop_timer_arm(&w->stats_timer, interval_ns) < 0) die("timerfd_settime");
+}
+
+// Server mode: every worker's share summed into the stats file
+static void server_publish(telem_stats_t *st, const worker_t *workers, int nworkers, bool done) {
+    telem_counters_t sum = {0};
+    for (int i = 0; i < nworkers; i++) {
+        telem_counters_t part;
+        if (telem_stats_read(&workers[i].share, &part)) telem_counters_add_rx(&sum, &part);
+    }
+    sum.t_ns = evloop_now_ns() - st->start_ns;
+    sum.done = done;
+    telem_stats_publish(st, &sum);
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    if (evloop_run(&w->loop) < 0) die("epoll_wait");
+    return NULL;
+}
+
+static void print_batch_stats(const worker_t *w) {
+    printf("수신 배치: %.2f 패킷/syscall (%" PRIu64 " 패킷, %" PRIu64 " recvmmsg)\n",
+           batch_ratio(w->rx.packets, w->rx.syscalls), w->rx.packets, w->rx.syscalls);
+    printf("ACK 배치: %.2f 패킷/syscall (%" PRIu64 " 패킷, %" PRIu64 " sendmmsg)\n",
+           batch_ratio(w->tx.packets, w->tx.syscalls), w->tx.packets, w->tx.syscalls);
+    printf("수신 배치 처리 시간: 평균 %.1f / 최대 %.1f 마이크로초 (%s)\n",
+           w->batches ? (double)w->batch_ns_sum / 1e3 / (double)w->batches : 0.0, (double)w->batch_ns_max / 1e3,
+           w->use_writer ? "쓰기 스레드" : "동기 쓰기");
+}
+
+// Syscalls of the worker's loop (batched socket I/O, epoll_wait wakeups,
+// timerfd reprogramming) per MB received; the writer thread's are not counted
+static void print_syscalls(const worker_t *w, uint64_t bytes) {
+    uint64_t syscalls = w->rx.syscalls + w->tx.syscalls + w->loop.wakeups + w->loop.timer_syscalls;
+    printf("시스템 콜: %" PRIu64 "회 (MB당 %.1f회)\n", syscalls,
+           bytes ? (double)syscalls * 1024.0 * 1024.0 / (double)bytes : 0.0);
+}
+
+// CPU time of every thread (writer included) and the peak RSS
+static void print_rusage(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) < 0) return;
+    printf("CPU 시간: 사용자 %.3f 초, 시스템 %.3f 초, 최대 RSS %ld KB\n",
+           (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6,
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6, ru.ru_maxrss);
+}
+
+// Keep serving until SIGINT/SIGTERM; the workers never see the signals.
+// With stats_path the main thread, otherwise idle, sums the workers'
+// counters into the stats block every sample_ns while it waits.
+static void run_server(const rx_config_t *cfg, int nworkers, const char *stats_path, uint64_t sample_ns) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) die("pthread_sigmask");
+
+    worker_t *workers = calloc((size_t)nworkers, sizeof(*workers));
+    if (!workers) die("calloc");
+    for (int i = 0; i < nworkers; i++) {
+        workers[i].single_fd = -1;
+        worker_init(&workers[i], i, cfg);
+    }
+    telem_stats_t *stats = NULL;
+    if (stats_path) {
+        stats = telem_stats_open(stats_path, TELEM_ROLE_RECEIVER, evloop_now_ns());
+        if (!stats) die("telemetry stats");
+        for (int i = 0; i < nworkers; i++) {
+            workers[i].share.start_ns = stats->start_ns;
+            worker_start_stats(&workers[i], &workers[i].share, sample_ns);
         }
+        printf("통계 엔드포인트: %s (워커 %d개 합계, %.1f 밀리초 간격)\n", stats_path, nworkers, (double)sample_ns / 1e6);
+    }
+    printf("포트 %d에서 수신 대기 중... (워커 %d개, 종료: Ctrl+C)\n", cfg->listen_port, nworkers);
+    printf("----------------------------------------\n");
+    fflush(stdout);
+    for (int i = 0; i < nworkers; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) die("pthread_create");
+    }
+
+    if (stats) {
+        struct timespec ivl = {
+            .tv_sec = (time_t)(sample_ns / 1000000000ull),
+            .tv_nsec = (long)(sample_ns % 1000000000ull),
+        };
+        while (sigtimedwait(&set, NULL, &ivl) < 0) server_publish(stats, workers, nworkers, false);
+    } else {
+        int sig;
+        sigwait(&set, &sig);
+    }
+    uint64_t one = 1;
+    for (int i = 0; i < nworkers; i++) (void)write(workers[i].stop_fd, &one, sizeof(one));
+    for (int i = 0; i < nworkers; i++) pthread_join(workers[i].thread, NULL);
+    // Final values, done set, for anyone still polling
+    if (stats) {
+        for (int i = 0; i < nworkers; i++) worker_publish(&workers[i]);
+        server_publish(stats, workers, nworkers, true);
+        telem_stats_close(stats);
+    }
+
+    printf("----------------------------------------\n");
+    printf("\n=== 서버 통계 ===\n");
+    uint64_t opened = 0, finished = 0, expired = 0, bytes = 0, packets = 0, digest_ok = 0, digest_bad = 0;
+    for (int i = 0; i < nworkers; i++) {
+        const worker_t *w = &workers[i];
+        printf("[워커 %d] 연결 %" PRIu64 "개 (완료 %" PRIu64 ", 시간 초과 %" PRIu64 "), %" PRIu64 " 바이트, 패킷 %" PRIu64
+               " (%.2f 패킷/recvmmsg)\n",
+               w->id, w->conns_opened, w->conns_finished, w->conns_expired, w->bytes, w->rx.packets,
+               batch_ratio(w->rx.packets, w->rx.syscalls));
+        if (w->use_em) netem_print_stats(&w->em, "  링크 에뮬레이터", stdout);
+        opened += w->conns_opened;
+        finished += w->conns_finished;
+        expired += w->conns_expired;
+        bytes += w->bytes;
+        packets += w->rx.packets;
+        digest_ok += w->digest_ok;
+        digest_bad += w->digest_bad;
+    }
+    printf("전체: 연결 %" PRIu64 "개 (완료 %" PRIu64 ", 시간 초과 %" PRIu64 "), 완료된 데이터 %" PRIu64 " 바이트 (%.2f MB), 패킷 %" PRIu64 "\n",
+           opened, finished, expired, bytes, (double)bytes / 1024.0 / 1024.0, packets);
+    if (digest_ok + digest_bad > 0) {
+        printf("파일 다이제스트: 일치 %" PRIu64 "개, 불일치 %" PRIu64 "개\n", digest_ok, digest_bad);
+    }
+    printf("==================\n");
+    for (int i = 0; i < nworkers; i++) worker_free(&workers[i]);
+    free(workers);
+}
+
+// Long-only options
+enum {
+    OPT_SYNC_WRITE = 256,
+    OPT_DIRECT,
+    OPT_FSYNC,
+    OPT_WRITE_POOL,
+    OPT_STATS,
+    OPT_SAMPLE_MS,
+};
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-b 배치크기] [-g] [-w 재조립윈도우] [-a 최대ACK빈도] [-A 지연us] [-M 최대페이로드] [-R 수신윈도우] [--write-pool MB] [--direct] [--fsync] [--sync-write] [-s 시드] [-S [-W 워커수]] [링크 옵션] [--stats 파일 [--sample-ms N]] [--quiet | --trace 파일] <수신_포트> <출력파일|출력디렉터리|-> [손실확률 0.0-1.0] [강제드롭_seq]\n", prog);
+    fprintf(stderr, "예시: %s 9000 output.bin 0.05\n", prog);
+    fprintf(stderr, "예시: %s 9000 - 0.05  (파일 저장 안 함)\n", prog);
+    fprintf(stderr, "예시: %s 9000 output.bin 0 7000  (seq 7000 패킷 강제 드롭)\n", prog);
+    fprintf(stderr, "예시: %s -S -W 4 9000 uploads/  (서버 모드, 워커 4개)\n", prog);
+    fprintf(stderr, "  -b N  recvmmsg/sendmmsg 한 번에 처리할 최대 패킷 수 (기본 %d, 최대 %d)\n", BATCH_DEFAULT, BATCH_MAX);
+    fprintf(stderr, "  -g    UDP GRO 사용: 커널이 합친 데이터그램을 패킷 단위로 분리해 처리 (Linux)\n");
+    fprintf(stderr, "  -w N  순서 외 패킷을 받아둘 재조립 윈도우 크기 (바이트, 기본 %llu)\n", (unsigned long long)REASM_DEFAULT_WINDOW);
+    fprintf(stderr, "  -a N  송신측이 요청한 ACK 빈도의 상한 (기본 %d, 1이면 지연 ACK 없이 매 패킷 ACK)\n", ACK_FREQ_MAX);
+    fprintf(stderr, "  -A us 지연 ACK 타이머 (기본 %llu 마이크로초)\n", RXCONN_ACK_DELAY_NS / 1000ull);
+    fprintf(stderr, "  -M N  핸드셰이크에서 허용할 최대 페이로드 (바이트, 기본 %d): 송신측 MSS의 상한\n", MAX_PAYLOAD);
+    fprintf(stderr, "  -R N  ACK에 광고할 수신 윈도우의 상한 (바이트, 기본: 실제 소켓 수신 버퍼 크기)\n");
+    fprintf(stderr, "  --write-pool MB   워커마다 디스크 쓰기 스레드에 둘 버퍼 풀 크기 (기본 %llu MB)\n", WRITER_DEFAULT_POOL >> 20);
+    fprintf(stderr, "  --direct          O_DIRECT로 써서 페이지 캐시를 거치지 않음 (파일 시스템이 허용할 때)\n");
+    fprintf(stderr, "  --fsync           파일마다 데이터를 모두 받으면 fsync\n");
+    fprintf(stderr, "  --sync-write      쓰기 스레드 없이 수신 루프에서 바로 pwrite\n");
+    fprintf(stderr, "  -q, --quiet       패킷별 로그를 출력하지 않음 (통계만)\n");
+    fprintf(stderr, "  -t, --trace 파일  패킷별 이벤트를 바이너리 트레이스 파일에 기록 (trace_dump로 해독)\n");
+    fprintf(stderr, "  --stats 파일      전송 중 다른 프로세스가 읽을 수 있는 공유 메모리 통계 (예: /dev/shm/udp_rx, telemetry_dump로 조회)\n");
+    fprintf(stderr, "                    서버 모드에서는 모든 워커·연결의 합계\n");
+    fprintf(stderr, "  --sample-ms N     통계 갱신 간격 (기본 %d 밀리초)\n", TELEM_INTERVAL_DEFAULT_MS);
+    fprintf(stderr, "  -s N  손실·링크 에뮬레이션 난수 시드 (기본: 현재 시각)\n");
+    fprintf(stderr, "  -S    서버 모드: 여러 송신자의 전송을 동시에 받고 종료 신호까지 계속 실행\n");
+    fprintf(stderr, "        연결(주소, 포트, 연결 ID)마다 출력디렉터리/<IP>_<포트>_<연결ID>.bin 에 저장\n");
+    fprintf(stderr, "  -W N  서버 모드 워커 스레드 수 (SO_REUSEPORT 소켓 하나씩, 기본: CPU 수)\n");
+    netem_usage(stderr);
+    fprintf(stderr, "  (링크 옵션은 송신자 -> 수신자 방향에만 적용, ACK는 바로 송신. 서버 모드에서는 워커마다 따로 적용)\n");
+}
 
-        // Accept only in-order data (simple cumulative ACK receiver)
-        if (seq == expected_seq && len > 0) {
-            printf("---→ 패킷 (seq:%u, size:%u) 수신\n", seq, len);
-            if (save_to_file && fout) {
-                size_t wrote = fwrite(buffer + sizeof(hdr), 1, len, fout);
-                if (wrote != len) {
-                    fprintf(stderr, "오류: 파일 쓰기 실패\n");
-                    exit(EXIT_FAILURE);
-                }
+int main(int argc, char **argv) {
+    static rx_config_t cfg;
+    cfg.batch_size = BATCH_DEFAULT;
+    cfg.reasm_window = REASM_DEFAULT_WINDOW;
+    cfg.ack_freq_max = ACK_FREQ_MAX;
+    cfg.ack_delay_ns = RXCONN_ACK_DELAY_NS;
+    cfg.max_payload = MAX_PAYLOAD;
+    cfg.write_pool = WRITER_DEFAULT_POOL;
+    cfg.seed = (uint64_t)time(NULL);
+    netem_config_default(&cfg.link);
+    int nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nworkers < 1) nworkers = 1;
+    int opt;
+    int trace_mode = TRACE_TEXT;
+    const char *trace_path = NULL;
+    const char *stats_path = NULL;
+    uint64_t sample_ns = TELEM_INTERVAL_DEFAULT_MS * 1000000ull;
+    static const struct option long_opts[] = {
+        {"quiet", no_argument, NULL, 'q'},
+        {"trace", required_argument, NULL, 't'},
+        {"sync-write", no_argument, NULL, OPT_SYNC_WRITE},
+        {"direct", no_argument, NULL, OPT_DIRECT},
+        {"fsync", no_argument, NULL, OPT_FSYNC},
+        {"write-pool", required_argument, NULL, OPT_WRITE_POOL},
+        {"stats", required_argument, NULL, OPT_STATS},
+        {"sample-ms", required_argument, NULL, OPT_SAMPLE_MS},
+        {NULL, 0, NULL, 0},
+    };
+    while ((opt = getopt_long(argc, argv, "b:gw:a:A:M:R:qt:s:SW:" NETEM_OPTSTRING, long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            cfg.batch_size = atoi(optarg);
+            if (cfg.batch_size < 1) cfg.batch_size = 1;
+            if (cfg.batch_size > BATCH_MAX) cfg.batch_size = BATCH_MAX;
+            break;
+        case 'g':
+            cfg.use_gro = true;
+            break;
+        case 'w':
+            cfg.reasm_window = strtoull(optarg, NULL, 10);
+            if (cfg.reasm_window == 0) cfg.reasm_window = REASM_DEFAULT_WINDOW;
+            break;
+        case 'a':
+            cfg.ack_freq_max = (uint32_t)atoi(optarg);
+            if (cfg.ack_freq_max < 1) cfg.ack_freq_max = 1;
+            break;
+        case 'A':
+            cfg.ack_delay_ns = strtoull(optarg, NULL, 10) * 1000ull;
+            break;
+        case 'M':
+            cfg.max_payload = (uint32_t)atoi(optarg);
+            if (cfg.max_payload < PLPMTU_BASE - sizeof(packet_header_t)) cfg.max_payload = PLPMTU_BASE - sizeof(packet_header_t);
+            if (cfg.max_payload > MAX_PAYLOAD) cfg.max_payload = MAX_PAYLOAD;
+            break;
+        case 'R':
+            cfg.rcv_wnd = strtoull(optarg, NULL, 10);
+            break;
+        case 'q':
+            trace_mode = TRACE_OFF;
+            break;
+        case 't':
+            trace_mode = TRACE_FILE;
+            trace_path = optarg;
+            break;
+        case 's':
+            cfg.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'S':
+            cfg.server = true;
+            break;
+        case 'W':
+            nworkers = atoi(optarg);
+            if (nworkers < 1) nworkers = 1;
+            break;
+        case OPT_SYNC_WRITE:
+            cfg.sync_write = true;
+            break;
+        case OPT_DIRECT:
+            cfg.direct = true;
+            break;
+        case OPT_FSYNC:
+            cfg.fsync = true;
+            break;
+        case OPT_WRITE_POOL:
+            cfg.write_pool = strtoull(optarg, NULL, 10) << 20;
+            if (cfg.write_pool == 0) cfg.write_pool = WRITER_DEFAULT_POOL;
+            break;
+        case OPT_STATS:
+            stats_path = optarg;
+            break;
+        case OPT_SAMPLE_MS:
+            sample_ns = strtoull(optarg, NULL, 10) * 1000000ull;
+            if (sample_ns == 0) sample_ns = 1000000ull;
+            break;
+        case 'r':
+        case 'd':
+        case 'Q':
+        case 'E':
+        case 'G':
+        case 'O':
+        case 'D':
+        case 'X':
+            if (netem_parse_opt(&cfg.link, opt, optarg) < 0) {
+                fprintf(stderr, "오류: 잘못된 링크 옵션: -%c %s\n", opt, optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
             }
-            expected_seq += len;
-            total_bytes += len;
-        } else if (seq != expected_seq && len > 0) {
-            out_of_order_packets++;
-            printf("---→ 패킷 (seq:%u, size:%u) 수신 오류\n", seq, len);
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
         }
+    }
+    int nargs = argc - optind;
+    if (nargs < 2 || nargs > 4) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    char **args = argv + optind;
 
-        if (flags & 0x01) { // FIN
-            printf("---→ 패킷 (seq:%u, FIN) 수신\n", seq);
-            fin_received = true;
-        }
+    cfg.listen_port = atoi(args[0]);
+    cfg.output_path = args[1];
+    if (nargs >= 3) {
+        cfg.loss_prob = atof(args[2]);
+        if (cfg.loss_prob < 0.0) cfg.loss_prob = 0.0;
+        if (cfg.loss_prob > 1.0) cfg.loss_prob = 1.0;
+    }
+    if (nargs == 4) {
+        cfg.force_drop_seq = (uint32_t)atoi(args[3]);
+        cfg.use_force_drop = true;
+    }
+    if (cfg.server && trace_mode == TRACE_FILE) {
+        fprintf(stderr, "오류: 서버 모드에서는 --trace를 지원하지 않습니다\n");
+        return EXIT_FAILURE;
+    }
+    cfg.link.slot_size = (uint32_t)sizeof(packet_header_t) + cfg.max_payload;
+    // A window that cannot hold one full segment would never let data through
+    if (cfg.rcv_wnd != 0 && cfg.rcv_wnd < cfg.max_payload) cfg.rcv_wnd = cfg.max_payload;
 
-        // Send cumulative ACK
-        ack_packet_t ack = {0};
-        ack.ack = htonl(expected_seq);
-        ack.dup = 0;
-        (void)sendto(sockfd, &ack, sizeof(ack), 0, (struct sockaddr *)&peer, peerlen);
-        printf("<--- ACK %u 송신\n", expected_seq);
+    printf("=== 수신 프로그램 시작 ===\n");
+    printf("수신 포트: %d\n", cfg.listen_port);
+    cfg.save_to_file = (strcmp(cfg.output_path, "-") != 0);
+    if (cfg.save_to_file) {
+        printf("%s: %s\n", cfg.server ? "출력 디렉터리" : "출력 파일", cfg.output_path);
+    } else {
+        printf("출력 파일: 저장 안 함 (화면 출력만)\n");
+    }
+    if (cfg.use_force_drop) {
+        printf("강제 패킷 드롭: seq %u 패킷 드롭\n", cfg.force_drop_seq);
+    } else if (cfg.loss_prob > 0.0) {
+        printf("패킷 손실 시뮬레이션: %.1f%%\n", cfg.loss_prob * 100.0);
+    } else {
+        printf("패킷 손실 시뮬레이션: 없음\n");
+    }
+    printf("최대 페이로드: %u 바이트\n", cfg.max_payload);
+    if (cfg.save_to_file && cfg.sync_write) {
+        printf("디스크 쓰기: 수신 루프에서 동기 pwrite%s\n", cfg.fsync ? ", 완료 시 fsync" : "");
+    } else if (cfg.save_to_file) {
+        printf("디스크 쓰기: 쓰기 스레드 (워커마다 버퍼 풀 %" PRIu64 " MB%s%s)\n", cfg.write_pool >> 20,
+               cfg.direct ? ", O_DIRECT" : "", cfg.fsync ? ", 완료 시 fsync" : "");
+    }
+    if (netem_config_active(&cfg.link)) netem_describe(&cfg.link, stdout);
 
-        if (fin_received) {
-            // Once FIN observed, after acknowledging, exit
-            printf("----------------------------------------\n");
-            printf("FIN 패킷 수신! 전송 완료 신호 확인\n");
-            break;
+    if (cfg.server) {
+        // Per-packet logs from many transfers would be unreadable
+        printf("서버 모드: 연결별 요약만 출력\n");
+        run_server(&cfg, nworkers, stats_path, sample_ns);
+        printf("수신 프로그램 종료\n");
+        return 0;
+    }
+    printf("대기 중...\n");
+
+    static worker_t worker;
+    worker_t *w = &worker;
+    w->single_fd = -1;
+    if (cfg.save_to_file) {
+        w->single_fd = open(cfg.output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (w->single_fd < 0) {
+            fprintf(stderr, "오류: 출력 파일을 생성할 수 없습니다: %s\n", cfg.output_path);
+            exit(EXIT_FAILURE);
         }
     }
+    worker_init(w, 0, &cfg);
+    printf("포트 %d에서 수신 대기 중...\n", cfg.listen_port);
+
+    if (trace_mode == TRACE_FILE) {
+        if (trace_open_file(&w->single_trace, trace_path, TRACE_DEFAULT_RECORDS) < 0) die("trace");
+        printf("트레이스 파일: %s\n", trace_path);
+    } else {
+        trace_init(&w->single_trace, trace_mode);
+    }
+    if (stats_path) {
+        telem_stats_t *st = telem_stats_open(stats_path, TELEM_ROLE_RECEIVER, evloop_now_ns());
+        if (!st) die("telemetry stats");
+        worker_start_stats(w, st, sample_ns);
+        printf("통계 엔드포인트: %s (%.1f 밀리초 간격)\n", stats_path, (double)sample_ns / 1e6);
+    }
+
+    printf("----------------------------------------\n");
+    if (evloop_run(&w->loop) < 0) die("epoll_wait");
+    if (w->stats) worker_publish(w);
+
+    // Once FIN observed, after acknowledging, exit
+    printf("----------------------------------------\n");
+    printf("FIN 패킷 수신! 전송 완료 신호 확인\n");
+    if (w->use_writer) writer_drain(&w->wr);
 
     printf("\n=== 수신 통계 ===\n");
-    printf("수신된 데이터: %u 바이트 (%.2f KB)\n", total_bytes, (double)total_bytes / 1024.0);
-    printf("총 수신 패킷: %u\n", total_packets);
-    printf("드롭된 패킷: %u\n", dropped_packets);
-    printf("순서 불일치 패킷: %u\n", out_of_order_packets);
-    if (save_to_file) {
-        printf("출력 파일: %s\n", output_path);
+    // A striped transfer: one line per flow, then the totals
+    static rxconn_t total;
+    total.min_wnd = UINT32_MAX;
+    uint64_t trace_events = 0;
+    bool traced = false;
+    for (uint32_t i = 0; i <= w->conns.mask; i++) {
+        const conn_t *c = w->conns.slots[i].val;
+        if (!c) continue;
+        const rxconn_t *rc = &c->rc;
+        total.total_bytes += rc->total_bytes;
+        total.total_packets += rc->total_packets;
+        total.dropped_packets += rc->dropped_packets;
+        total.out_of_order_packets += rc->out_of_order_packets;
+        total.duplicate_packets += rc->duplicate_packets;
+        total.acks_sent += rc->acks_sent;
+        total.acks_delayed += rc->acks_delayed;
+        total.ack_freq = rc->ack_freq;
+        total.corrupt_packets += rc->corrupt_packets;
+        total.zero_wnd_acks += rc->zero_wnd_acks;
+        total.wnd_updates += rc->wnd_updates;
+        total.wnd_probes += rc->wnd_probes;
+        total.fec.parity_packets += rc->fec.parity_packets;
+        total.fec.repaired += rc->fec.repaired;
+        total.fec.multi_loss += rc->fec.multi_loss;
+        if (rc->min_wnd < total.min_wnd) total.min_wnd = rc->min_wnd;
+        if (rc->trace.mode == TRACE_FILE) {
+            traced = true;
+            trace_events = rc->trace.head;
+        }
+    }
+    // The whole file's digest: stripes chained in file order
+    for (uint16_t k = 0; k < w->single->stripes; k++) {
+        for (uint32_t i = 0; i <= w->conns.mask; i++) {
+            const conn_t *c = w->conns.slots[i].val;
+            if (!c || c->stripe != k) continue;
+            const rxconn_t *rc = &c->rc;
+            if (rc->digest_state > total.digest_state) total.digest_state = rc->digest_state;
+            total.digest.crc = crc32c_combine(total.digest.crc, rc->digest.crc, rc->digest.pos);
+            total.peer_digest = crc32c_combine(total.peer_digest, rc->peer_digest, rc->digest.pos);
+            if (w->single->stripes == 1) continue;
+            printf("흐름 %u: 오프셋 %" PRIu64 ", %" PRIu64 " 바이트, 패킷 %u (드롭 %u, 순서 외 %u, 중복 %u, 손상 %u)%s\n",
+                   c->stripe, c->base, rc->total_bytes, rc->total_packets, rc->dropped_packets,
+                   rc->out_of_order_packets, rc->duplicate_packets, rc->corrupt_packets, digest_note(rc->digest_state));
+        }
+    }
+    rxconn_print_stats(&total, stdout);
+    if (w->single->stripes > 1) {
+        double sec = (double)(evloop_now_ns() - w->single->start_ns) / 1e9;
+        printf("흐름 %u개 전체 처리량: %.2f MB/s\n", w->single->stripes, (double)total.total_bytes / 1024.0 / 1024.0 / sec);
+    }
+    if (w->stray_packets > 0) printf("다른 연결의 패킷 (무시): %" PRIu64 "\n", w->stray_packets);
+    print_batch_stats(w);
+    if (w->use_writer) writer_print_stats(&w->wr, stdout);
+    print_syscalls(w, total.total_bytes);
+    print_rusage();
+    if (cfg.save_to_file) {
+        printf("출력 파일: %s\n", cfg.output_path);
     } else {
         printf("출력 파일: 저장 안 함\n");
     }
+    if (w->use_em) netem_print_stats(&w->em, "링크 에뮬레이터", stdout);
+    if (traced) printf("트레이스 이벤트: %" PRIu64 "개\n", trace_events);
     printf("==================\n");
 
-    if (fout) {
-        fclose(fout);
+    worker_free(w);
+    if (total.digest_state == RX_DIGEST_BAD) {
+        fprintf(stderr, "오류: 수신한 파일이 송신측 다이제스트와 다릅니다\n");
+        return EXIT_FAILURE;
     }
-    close(sockfd);
     printf("수신 프로그램 종료\n");
     return 0;
 }
-
-
@@ -0,0 +1,51 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// xoshiro256** seeded through splitmix64. Small, fast and fully determined
+// by the seed, so a simulated run or a loss pattern can be replayed exactly.
+
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline void rng_seed(rng_t *r, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        r->s[i] = z ^ (z >> 31);
+    }
+}
+
+static inline uint64_t rng_next(rng_t *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform in [0, 1)
+static inline double rng_uniform(rng_t *r) {
+    return (double)(rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+static inline bool rng_chance(rng_t *r, double p) {
+    if (p <= 0.0) return false;
+    if (p >= 1.0) return true;
+    return rng_uniform(r) < p;
+}
+
+#endif
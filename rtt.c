@@ -0,0 +1,84 @@
+#include "rtt.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#define RTT_CLOCK_G_NS 1000000ull   // timer granularity G: timerfd + loop latency, 1 ms
+
+static uint64_t clamp_rto(const rtt_est_t *rt, uint64_t rto) {
+    if (rto < rt->min_rto_ns) rto = rt->min_rto_ns;
+    if (rto > rt->max_rto_ns) rto = rt->max_rto_ns;
+    return rto;
+}
+
+void rtt_init(rtt_est_t *rt, uint64_t initial_rto_ns, uint64_t min_rto_ns) {
+    memset(rt, 0, sizeof(*rt));
+    rt->min_rto_ns = min_rto_ns;
+    rt->max_rto_ns = RTT_MAX_RTO_NS;
+    rt->rto_ns = clamp_rto(rt, initial_rto_ns);
+}
+
+void rtt_sample(rtt_est_t *rt, uint64_t rtt_ns, uint64_t sent_ns) {
+    if (rtt_ns == 0) return;
+    if (rt->srtt_ns == 0) {
+        // (2.2) first measurement
+        rt->srtt_ns = rtt_ns;
+        rt->rttvar_ns = rtt_ns / 2;
+    } else {
+        // (2.3) beta = 1/4, alpha = 1/8
+        uint64_t err = rt->srtt_ns > rtt_ns ? rt->srtt_ns - rtt_ns : rtt_ns - rt->srtt_ns;
+        rt->rttvar_ns = (3 * rt->rttvar_ns + err) / 4;
+        rt->srtt_ns = (7 * rt->srtt_ns + rtt_ns) / 8;
+    }
+    uint64_t var = 4 * rt->rttvar_ns;
+    if (var < RTT_CLOCK_G_NS) var = RTT_CLOCK_G_NS;
+    // At least 2 SRTT: steady delay drives RTTVAR toward zero, and an RTO
+    // just past SRTT would race RACK and the tail loss probe, which need
+    // about one more round trip to find a lost retransmission
+    if (var < rt->srtt_ns) var = rt->srtt_ns;
+    uint64_t rto = clamp_rto(rt, rt->srtt_ns + var);
+    if (rt->backoffs == 0 || sent_ns >= rt->backoff_ns) {
+        rt->rto_ns = rto;
+        rt->backoffs = 0;
+    } else if (rto > rt->rto_ns) {
+        rt->rto_ns = rto;   // never below the backed-off value meanwhile
+    }
+
+    rt->samples++;
+    rt->last_ns = rtt_ns;
+    rt->sum_ns += rtt_ns;
+    if (rt->min_ns == 0 || rtt_ns < rt->min_ns) rt->min_ns = rtt_ns;
+    if (rtt_ns > rt->max_ns) rt->max_ns = rtt_ns;
+    uint64_t us = rtt_ns / 1000;
+    unsigned b = 0;
+    while (us > 1 && b < RTT_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    rt->hist[b]++;
+}
+
+void rtt_backoff(rtt_est_t *rt, uint64_t now_ns) {
+    rt->backoffs++;
+    rt->backoff_ns = now_ns;
+    rt->rto_ns = clamp_rto(rt, rt->rto_ns * 2);
+}
+
+void rtt_print(const rtt_est_t *rt, FILE *out) {
+    if (rt->samples == 0) {
+        fprintf(out, "RTT 표본 없음\n");
+        return;
+    }
+    fprintf(out, "RTT: 최소 %.1f us / 평균 %.1f us / 최대 %.1f us (%" PRIu64 "개 표본)\n",
+            (double)rt->min_ns / 1e3, (double)rt->sum_ns / (double)rt->samples / 1e3,
+            (double)rt->max_ns / 1e3, rt->samples);
+    fprintf(out, "최종 SRTT: %.1f us, RTTVAR: %.1f us, RTO: %.1f ms\n",
+            (double)rt->srtt_ns / 1e3, (double)rt->rttvar_ns / 1e3, (double)rt->rto_ns / 1e6);
+    fprintf(out, "RTT 분포 (us):\n");
+    for (unsigned b = 0; b < RTT_HIST_BUCKETS; b++) {
+        if (rt->hist[b] == 0) continue;
+        uint64_t lo = b == 0 ? 0 : (uint64_t)1 << b;
+        fprintf(out, "  [%8" PRIu64 ", %8" PRIu64 ") %10" PRIu64 " (%5.1f%%)\n", lo, (uint64_t)2 << b,
+                rt->hist[b], 100.0 * (double)rt->hist[b] / (double)rt->samples);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Retransmission timer per RFC 6298: SRTT/RTTVAR smoothing of RTT samples
+// (taken by the caller under Karn's rule), RTO = SRTT + max(G, 4 * RTTVAR,
+// SRTT) clamped to [min, max], doubled on every expiry. The backed-off
+// value stays until a sample comes from a segment sent after the last
+// expiry (Karn): a late ACK for data sent before it shows the timer fired
+// too early, so it must not pull the RTO straight back down. Samples also feed a log2 histogram
+// with microsecond buckets for the statistics.
+
+#define RTT_MAX_RTO_NS 60000000000ull   // RFC 6298 (2.5): at least 60 s
+#define RTT_HIST_BUCKETS 25             // [2^i, 2^(i+1)) us, up to ~16 s
+#define RTT_MIN_RTO_MS_DEFAULT 5        // RTO floor: a few timer ticks, above loopback scheduling jitter
+
+typedef struct {
+    uint64_t srtt_ns;       // 0 until the first sample
+    uint64_t rttvar_ns;
+    uint64_t rto_ns;
+    uint64_t min_rto_ns;
+    uint64_t max_rto_ns;
+    uint32_t backoffs;      // consecutive expiries since the last sample
+    uint64_t backoff_ns;    // time of the last expiry
+
+    uint64_t samples;
+    uint64_t last_ns;       // latest sample
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t sum_ns;
+    uint64_t hist[RTT_HIST_BUCKETS];
+} rtt_est_t;
+
+void rtt_init(rtt_est_t *rt, uint64_t initial_rto_ns, uint64_t min_rto_ns);
+// One sample, from a segment first sent at sent_ns
+void rtt_sample(rtt_est_t *rt, uint64_t rtt_ns, uint64_t sent_ns);
+// Timer expired at now_ns: back off exponentially (RFC 6298 5.5)
+void rtt_backoff(rtt_est_t *rt, uint64_t now_ns);
+// Summary and non-empty histogram buckets
+void rtt_print(const rtt_est_t *rt, FILE *out);
+
+#endif
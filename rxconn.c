@@ -0,0 +1,384 @@
+#define _GNU_SOURCE
+#include "rxconn.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "protocol.h"
+
+static void rx_trace(rxconn_t *rc, uint8_t type, uint64_t seq, uint32_t len, uint64_t arg, int32_t aux) {
+    if (rc->trace.mode == TRACE_OFF) return;
+    trace_rec_t rec = {0};
+    rec.ts_ns = rc->io.now_ns(rc->io.ctx);
+    rec.type = type;
+    rec.seq = seq;
+    rec.len = len;
+    rec.arg = arg;
+    rec.aux = aux;
+    trace_write(&rc->trace, &rec);
+}
+
+// Receive window to advertise: room left in the reassembly window capped
+// at rcv_buf, less the write backlog. Anything below min(rcv_buf / 2,
+// largest segment) is advertised as zero, so the sender waits for a
+// useful opening instead of dribbling out small segments (RFC 1122
+// 4.2.3.3).
+static uint32_t rx_window(const rxconn_t *rc) {
+    uint64_t room = reasm_room(&rc->reasm);
+    if (room > rc->rcv_buf) room = rc->rcv_buf;
+    uint64_t backlog = rc->io.backlog ? rc->io.backlog(rc->io.ctx) : 0;
+    room = room > backlog ? room - backlog : 0;
+    uint64_t sws = rc->rcv_buf / 2 < rc->max_seg ? rc->rcv_buf / 2 : rc->max_seg;
+    if (room < sws) room = 0;
+    return room > UINT32_MAX ? UINT32_MAX : (uint32_t)room;
+}
+
+// Send a cumulative ACK with SACK blocks for the ranges held above it;
+// the block containing recent_off (the segment just received) goes first.
+static void send_ack(rxconn_t *rc, uint64_t recent_off) {
+    ack_packet_t ack = {0};
+    ack.conn_id = htonl(rc->conn_id);
+    ack.ack = htonl((uint32_t)rc->reasm.next);
+    ack.flags = 0;
+    uint32_t wnd = rx_window(rc);
+    ack.wnd = htonl(wnd);
+    ack.fec_repaired = htons((uint16_t)rc->fec.repaired);
+    reasm_range_t ranges[MAX_SACK_BLOCKS];
+    uint32_t max_blocks = (rc->features & FEAT_SACK) ? MAX_SACK_BLOCKS : 0;
+    ack.sack_count = (uint8_t)reasm_sack_ranges(&rc->reasm, recent_off, ranges, max_blocks);
+    for (uint8_t i = 0; i < ack.sack_count; i++) {
+        ack.sack[i].start = htonl((uint32_t)ranges[i].start);
+        ack.sack[i].end = htonl((uint32_t)ranges[i].end);
+    }
+    rc->io.send_ack(rc->io.ctx, &ack, ack_wire_len(&ack));
+    rc->acks_sent++;
+    rc->adv_wnd = wnd;
+    rc->adv_edge = rc->reasm.next + wnd;
+    if (wnd < rc->min_wnd) rc->min_wnd = wnd;
+    if (wnd == 0) rc->zero_wnd_acks++;
+    rc->ack_pending = 0;
+    rc->ack_deadline_ns = 0;   // a timer already armed finds nothing to do
+    if (ack.sack_count > 0) {
+        rx_trace(rc, TR_ACK_SENT, rc->reasm.next, (uint32_t)(ranges[0].end - ranges[0].start), ranges[0].start, ack.sack_count);
+    } else {
+        rx_trace(rc, TR_ACK_SENT, rc->reasm.next, 0, 0, 0);
+    }
+}
+
+// SYN-ACK or probe confirmation
+static void send_ctl_ack(rxconn_t *rc, uint8_t flags, uint32_t value) {
+    ctl_ack_t ack = {0};
+    ack.conn_id = htonl(rc->conn_id);
+    ack.ack = htonl((uint32_t)rc->reasm.next);
+    ack.flags = flags;
+    ack.wnd = htonl(rx_window(rc));
+    ack.version = PROTO_VERSION;
+    ack.features = htons(rc->features);
+    ack.value = htonl(value);
+    rc->io.send_ack(rc->io.ctx, &ack, sizeof(ack));
+}
+
+// Keep the features we implement and cap the payload at our buffers. A
+// sender speaking another version gets our version back and gives up.
+static void on_syn(rxconn_t *rc, const uint8_t *payload, uint32_t len) {
+    syn_t syn;
+    if (!payload || len < sizeof(syn)) return;
+    memcpy(&syn, payload, sizeof(syn));
+    uint32_t limit = ntohl(syn.max_payload);
+    if (limit > rc->max_payload) limit = rc->max_payload;
+    rc->features = syn.version == PROTO_VERSION ? (uint16_t)(ntohs(syn.features) & RXCONN_FEATURES) : 0;
+    send_ctl_ack(rc, ACK_F_SYN, limit);
+}
+
+// Compare the sender's digest with ours; a FIN sent again decides the same
+static void on_fin_digest(rxconn_t *rc, const uint8_t *payload, uint32_t len) {
+    fin_t fin;
+    if (!(rc->features & FEAT_DIGEST) || !payload || len < sizeof(fin) || rc->digest_state != RX_DIGEST_NONE) return;
+    memcpy(&fin, payload, sizeof(fin));
+    rc->peer_digest = ntohl(fin.digest);
+    const crc_stream_t *cs = &rc->digest;
+    if (cs->broken) {
+        rc->digest_state = RX_DIGEST_UNKNOWN;
+    } else if (cs->pos == be64toh(fin.bytes) && cs->count == 0 && cs->crc == rc->peer_digest) {
+        rc->digest_state = RX_DIGEST_OK;
+    } else {
+        rc->digest_state = RX_DIGEST_BAD;
+    }
+    rx_trace(rc, TR_RX_DIGEST, cs->pos, 0, cs->crc, rc->digest_state);
+}
+
+int rxconn_init(rxconn_t *rc, const rxconn_io_t *io, uint64_t reasm_window, uint64_t seed) {
+    memset(rc, 0, sizeof(*rc));
+    rc->io = *io;
+    trace_init(&rc->trace, TRACE_TEXT);
+    rng_seed(&rc->rng, seed);
+    rc->ack_freq_max = ACK_FREQ_MAX;
+    rc->ack_delay_ns = RXCONN_ACK_DELAY_NS;
+    rc->ack_freq = 1;
+    rc->max_payload = MAX_PAYLOAD;
+    rc->features = RXCONN_FEATURES;
+    rc->rcv_buf = RXCONN_RCV_BUF_DEFAULT;
+    rc->min_wnd = UINT32_MAX;
+    crc_stream_init(&rc->digest);
+    return reasm_init(&rc->reasm, REASM_DEFAULT_RANGES, reasm_window);
+}
+
+void rxconn_free(rxconn_t *rc) {
+    fec_dec_free(&rc->fec);
+    crc_stream_free(&rc->digest);
+    trace_close(&rc->trace);
+    reasm_free(&rc->reasm);
+}
+
+void rxconn_on_packet(rxconn_t *rc, const uint8_t *buf, size_t n) {
+    if (n < sizeof(packet_header_t)) {
+        // ignore malformed
+        return;
+    }
+
+    packet_header_t hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    uint32_t seq = ntohl(hdr.seq);
+    uint32_t len = ntohl(hdr.len);
+
+    // A SYN is checked if it came with a checksum; the SYN settles
+    // whether everything after it must have one
+    bool check = (hdr.flags & FLAG_SYN) ? hdr.csum != 0 : (rc->features & FEAT_CHECKSUM) != 0;
+    if (check && !packet_csum_ok(buf, n)) {
+        rc->corrupt_packets++;
+        rx_trace(rc, TR_RX_CORRUPT, seq, (uint32_t)(n - sizeof(hdr)), 0, 0);
+        return;
+    }
+
+    if (sizeof(hdr) + len != n) {
+        // size mismatch, ignore
+        return;
+    }
+    rxconn_on_segment(rc, seq, len, hdr.flags, hdr.fec, buf + sizeof(hdr));
+}
+
+// FEC state is only set up for a connection that uses it
+static bool fec_ready(rxconn_t *rc) {
+    if (!(rc->features & FEAT_FEC)) return false;
+    return rc->fec.slots || fec_dec_init(&rc->fec, FEC_DEC_SLOTS) == 0;
+}
+
+// New bytes at off, arrived or rebuilt: hand them on
+static void take_in(rxconn_t *rc, const uint8_t *payload, uint32_t len, uint64_t off) {
+    if (rc->io.deliver) rc->io.deliver(rc->io.ctx, payload, len, off);
+    if ((rc->features & FEAT_DIGEST) && payload) crc_stream_add(&rc->digest, off, payload, len);
+    rc->total_bytes += len;
+}
+
+// A segment rebuilt from parity counts as received. Returns whether it
+// brought new bytes (it may have been retransmitted meanwhile).
+static bool take_repair(rxconn_t *rc, const fec_repair_t *rep) {
+    if (reasm_insert(&rc->reasm, rep->off, rep->len) != REASM_NEW) return false;
+    rc->fec.repaired++;
+    rx_trace(rc, TR_RX_FEC_REPAIR, rep->off, rep->len, 0, 0);
+    take_in(rc, rep->data, rep->len, rep->off);
+    return true;
+}
+
+// Parity takes no sequence space; only a repair is worth an ACK
+static void on_parity(rxconn_t *rc, uint32_t seq, uint32_t len, uint8_t fec, const uint8_t *payload) {
+    if (!fec_ready(rc)) return;
+    uint64_t start = reasm_offset(&rc->reasm, seq);
+    rx_trace(rc, TR_RX_FEC_PARITY, start, len, (fec & FEC_ARG_MASK) + 1u, 0);
+    // A block wholly below the cumulative point has nothing to repair
+    if (start + (uint64_t)((fec & FEC_ARG_MASK) + 1u) * len <= rc->reasm.next) {
+        rc->fec.parity_packets++;
+        return;
+    }
+    fec_repair_t rep;
+    if (fec_dec_parity(&rc->fec, start, len, fec, payload, &rep) && take_repair(rc, &rep)) send_ack(rc, rep.off);
+}
+
+// In-order data that may wait: ACK once ack_freq full-sized segments are
+// pending, otherwise make sure the timer sends it
+static void delay_ack(rxconn_t *rc, uint64_t recent_off, uint32_t len) {
+    rc->ack_pending += len;
+    if (rc->ack_freq <= 1 || !rc->io.timer || rc->ack_pending >= (uint64_t)rc->ack_freq * rc->max_seg) {
+        send_ack(rc, recent_off);
+        return;
+    }
+    if (rc->ack_deadline_ns == 0) {
+        rc->ack_deadline_ns = rc->io.now_ns(rc->io.ctx) + rc->ack_delay_ns;
+        rc->io.timer(rc->io.ctx, rc->ack_deadline_ns);
+    }
+}
+
+void rxconn_on_timer(rxconn_t *rc) {
+    if (rc->ack_deadline_ns == 0) return;
+    if (rc->io.now_ns(rc->io.ctx) < rc->ack_deadline_ns) {
+        rc->io.timer(rc->io.ctx, rc->ack_deadline_ns);
+        return;
+    }
+    rc->acks_delayed++;
+    send_ack(rc, rc->reasm.next);
+}
+
+void rxconn_on_drain(rxconn_t *rc) {
+    // Worth an update once the edge moved by min(half the buffer, one
+    // segment) (RFC 1122 4.2.3.3); smaller steps ride on the next data ACK.
+    // After a full window the sender was never held back: nothing to do.
+    uint64_t full = rc->rcv_buf < rc->reasm.window ? rc->rcv_buf : rc->reasm.window;
+    if (rc->adv_wnd >= (full < UINT32_MAX ? full : UINT32_MAX)) return;
+    uint64_t step = full / 2 < rc->max_seg ? full / 2 : rc->max_seg;
+    uint32_t wnd = rx_window(rc);
+    if (rc->reasm.next + wnd < rc->adv_edge + (step > 0 ? step : 1)) return;
+    rc->wnd_updates++;
+    rx_trace(rc, TR_WND_UPDATE, rc->reasm.next, 0, wnd, 0);
+    send_ack(rc, rc->reasm.next);
+}
+
+void rxconn_on_segment(rxconn_t *rc, uint32_t seq, uint32_t len, uint8_t flags, uint8_t fec, const uint8_t *payload) {
+    rc->total_packets++;
+
+    // 강제 드롭 (데모용)
+    bool should_drop_packet = false;
+    if (rc->use_force_drop && seq == rc->force_drop_seq && !(flags & (FLAG_SYN | FLAG_PROBE | FLAG_WND_PROBE))) {
+        should_drop_packet = true;
+    } else if (!rc->use_force_drop && rng_chance(&rc->rng, rc->loss_prob)) {
+        should_drop_packet = true;
+    }
+
+    // Potentially simulate loss: the packet never arrived, so nothing is
+    // ACKed for it; the next arrivals report the gap
+    if (should_drop_packet) {
+        rc->dropped_packets++;
+        rx_trace(rc, TR_RX_DROP, seq, len, 0, 0);
+        return;
+    }
+
+    // Handshake and PLPMTU probes take no sequence space
+    if (flags & FLAG_SYN) {
+        on_syn(rc, payload, len);
+        return;
+    }
+    if (flags & FLAG_PROBE) {
+        send_ctl_ack(rc, ACK_F_PROBE, (uint32_t)sizeof(packet_header_t) + len);
+        return;
+    }
+    // Zero-window probe: the answer is the current window
+    if (flags & FLAG_WND_PROBE) {
+        rc->wnd_probes++;
+        rx_trace(rc, TR_RX_WND_PROBE, seq, 0, 0, 0);
+        send_ack(rc, rc->reasm.next);
+        return;
+    }
+    if (fec & FEC_PARITY) {
+        on_parity(rc, seq, len, fec, payload);
+        return;
+    }
+
+    // A FIN's payload is its digest, not data
+    if (flags & FLAG_FIN) {
+        on_fin_digest(rc, payload, len);
+        len = 0;
+    }
+
+    // Data packets carry the sender's ACK frequency; a FIN does not
+    if (len > 0) {
+        uint32_t freq = flags >> ACK_FREQ_SHIFT;
+        if (freq == 0) freq = 1;
+        rc->ack_freq = freq < rc->ack_freq_max ? freq : rc->ack_freq_max;
+        if (len > rc->max_seg) rc->max_seg = len;
+    }
+
+    // Keep in-order and out-of-order data alike; each segment goes straight
+    // to its file offset and the cumulative ACK jumps over filled holes.
+    // Only plain in-order data with no gaps above it may be ACKed late.
+    bool may_delay = false;
+    uint64_t off = rc->reasm.next;
+    if (len > 0) {
+        off = reasm_offset(&rc->reasm, seq);
+        bool in_order = off == rc->reasm.next;
+        bool had_gaps = rc->reasm.count > 0;
+        int res = reasm_insert(&rc->reasm, off, len);
+        if (res == REASM_NEW) {
+            if (in_order) {
+                rx_trace(rc, TR_RX, seq, len, 0, 0);
+                may_delay = !had_gaps;
+            } else {
+                rc->out_of_order_packets++;
+                rx_trace(rc, TR_RX_OOO, seq, len, 0, 0);
+            }
+            take_in(rc, payload, len, off);
+            // The block's parity may already be waiting for this one
+            fec_repair_t rep;
+            if ((fec & FEC_DATA) && fec_ready(rc) && fec_dec_data(&rc->fec, off, len, fec, payload, &rep) &&
+                take_repair(rc, &rep)) {
+                may_delay = false;
+            }
+        } else if (res == REASM_DUP) {
+            rc->duplicate_packets++;
+            rx_trace(rc, TR_RX_DUP, seq, len, 0, 0);
+        } else {
+            rc->out_of_order_packets++;
+            rx_trace(rc, TR_RX_WINDOW, seq, len, 0, 0);
+        }
+    }
+
+    // Every copy of the FIN is confirmed, so a lost confirmation only
+    // costs the sender one more RTO
+    if (flags & FLAG_FIN) {
+        rx_trace(rc, TR_RX_FIN, seq, 0, 0, 0);
+        rc->fin_received = true;
+        send_ctl_ack(rc, ACK_F_FIN, 0);
+        return;
+    }
+
+    // Send cumulative ACK
+    if (may_delay) {
+        delay_ack(rc, off, len);
+    } else {
+        send_ack(rc, off);
+    }
+}
+
+void rxconn_print_stats(const rxconn_t *rc, FILE *out) {
+    fprintf(out, "수신된 데이터: %" PRIu64 " 바이트 (%.2f KB)\n", rc->total_bytes, (double)rc->total_bytes / 1024.0);
+    fprintf(out, "총 수신 패킷: %u\n", rc->total_packets);
+    fprintf(out, "드롭된 패킷: %u\n", rc->dropped_packets);
+    fprintf(out, "순서 불일치 패킷: %u\n", rc->out_of_order_packets);
+    fprintf(out, "중복 패킷: %u\n", rc->duplicate_packets);
+    fprintf(out, "보낸 ACK: %u (데이터 패킷 %.2f개당 1개, 타이머 %u, ACK 빈도 %u)\n", rc->acks_sent,
+            rc->acks_sent ? (double)(rc->total_packets - rc->dropped_packets) / (double)rc->acks_sent : 0.0,
+            rc->acks_delayed, rc->ack_freq);
+    if (rc->corrupt_packets > 0) fprintf(out, "체크섬 오류로 버린 패킷: %u\n", rc->corrupt_packets);
+    if (rc->fec.parity_packets > 0) {
+        fprintf(out, "FEC: 패리티 수신 %" PRIu64 "개, 패리티로 복구한 세그먼트 %" PRIu64 "개, 두 개 이상 잃은 블록 %" PRIu64 "개\n",
+                rc->fec.parity_packets, rc->fec.repaired, rc->fec.multi_loss);
+    }
+    switch (rc->digest_state) {
+    case RX_DIGEST_OK:
+        fprintf(out, "파일 다이제스트 (CRC32C): %08x 일치\n", rc->digest.crc);
+        break;
+    case RX_DIGEST_BAD:
+        fprintf(out, "파일 다이제스트 (CRC32C): 불일치! 수신 %08x, 송신 %08x\n", rc->digest.crc, rc->peer_digest);
+        break;
+    case RX_DIGEST_UNKNOWN:
+        fprintf(out, "파일 다이제스트 (CRC32C): 확인 불가 (겹치는 재전송)\n");
+        break;
+    }
+    if (rc->zero_wnd_acks > 0 || rc->wnd_probes > 0 || rc->wnd_updates > 0) {
+        fprintf(out, "수신 윈도우: 최소 %u 바이트, 제로 윈도우 ACK %u개, 윈도우 갱신 %u개, 윈도우 프로브 %u개\n",
+                rc->min_wnd, rc->zero_wnd_acks, rc->wnd_updates, rc->wnd_probes);
+    }
+}
+
+void rxconn_add_counters(const rxconn_t *rc, telem_counters_t *c) {
+    c->bytes += rc->reasm.next;
+    c->flows++;
+    c->total_packets += rc->total_packets;
+    c->dropped_packets += rc->dropped_packets;
+    c->out_of_order_packets += rc->out_of_order_packets;
+    c->duplicate_packets += rc->duplicate_packets;
+    c->corrupt_packets += rc->corrupt_packets;
+    c->fec_repaired += (uint32_t)rc->fec.repaired;
+    c->acks_sent += rc->acks_sent;
+    c->adv_wnd += rc->adv_wnd;
+}
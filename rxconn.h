@@ -0,0 +1,126 @@
+#ifndef RXCONN_H
+#define RXCONN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "crc32c.h"
+#include "fec.h"
+#include "reasm.h"
+#include "rng.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// Receiver side of one transfer without I/O: segments come in, ACKs and
+// in-order-or-not payload go out through rxconn_io_t. The UDP receiver
+// feeds it datagrams; the simulator feeds it headers from a modelled link.
+// SYNs and path MTU probes are answered here too; the caller reads the
+// stripe fields of the SYN itself.
+//
+// Every ACK advertises a receive window: the room left in the reassembly
+// window, capped at rcv_buf, less whatever the caller has been handed but
+// not yet written out. A slow disk thus closes the window instead of
+// letting the socket buffer overflow and look like congestion.
+//
+// Packets that fail their checksum (FEAT_CHECKSUM) are dropped before
+// anything else looks at them. With FEAT_DIGEST the payload handed to
+// deliver is also run through a CRC32C and the result compared with the
+// digest in the sender's FIN.
+//
+// With FEAT_FEC a segment missing from a block whose parity has arrived is
+// rebuilt and taken in as if it had arrived, before the ACK goes out.
+
+typedef struct {
+    void *ctx;
+    uint64_t (*now_ns)(void *ctx);
+    void (*send_ack)(void *ctx, const void *ack, size_t len);
+    // New payload at its file offset; NULL when nothing is stored
+    void (*deliver)(void *ctx, const uint8_t *data, uint32_t len, uint64_t off);
+    // Wake rxconn_on_timer by deadline_ns (earlier or spurious wakeups are
+    // fine, it re-checks); NULL turns delayed ACKs off
+    void (*timer)(void *ctx, uint64_t deadline_ns);
+    // Delivered bytes not yet written out; NULL when deliver is synchronous
+    uint64_t (*backlog)(void *ctx);
+} rxconn_io_t;
+
+#define RXCONN_ACK_DELAY_NS 1000000ull  // well below the sender's minimum RTO
+#define RXCONN_FEATURES (FEAT_SACK | FEAT_CHECKSUM | FEAT_DIGEST | FEAT_FEC)  // what the handshake can accept
+#define RXCONN_RCV_BUF_DEFAULT UINT32_MAX  // no cap beyond the reassembly window
+
+// Ordered from good to bad so several flows merge with max()
+enum {
+    RX_DIGEST_NONE = 0,     // not negotiated, or no FIN yet
+    RX_DIGEST_OK,
+    RX_DIGEST_UNKNOWN,      // overlapping retransmissions: can't tell
+    RX_DIGEST_BAD,
+};
+
+typedef struct {
+    rxconn_io_t io;
+    uint32_t conn_id;       // echoed in every ACK
+    uint32_t max_payload;   // largest payload accepted (buffer size)
+    uint16_t features;      // FEAT_* in use; set by the SYN
+    trace_t trace;
+    rng_t rng;              // simulated loss
+    double loss_prob;
+    uint32_t force_drop_seq;
+    bool use_force_drop;
+
+    // Delayed ACK: in-order data is acknowledged once ack_freq full-sized
+    // segments are pending or ack_delay_ns after the first of them
+    uint32_t ack_freq_max;  // cap on what the sender may ask for
+    uint64_t ack_delay_ns;
+    uint32_t ack_freq;      // current, from the latest data packet
+    uint32_t max_seg;       // largest payload seen ("full-sized")
+    uint64_t ack_pending;   // in-order bytes not yet acknowledged
+    uint64_t ack_deadline_ns; // 0: nothing pending
+    uint32_t acks_sent;
+    uint32_t acks_delayed;  // sent by the timer
+
+    // Flow control
+    uint64_t rcv_buf;       // largest window ever advertised
+    uint32_t adv_wnd;       // last advertised window
+    uint64_t adv_edge;      // ... and its right edge (next + adv_wnd)
+    uint32_t min_wnd;       // smallest advertised on a data ACK
+    uint32_t zero_wnd_acks;
+    uint32_t wnd_updates;   // ACKs sent only to reopen the window
+    uint32_t wnd_probes;
+
+    reasm_t reasm;          // cumulative point (next expected byte) + out-of-order ranges
+    crc_stream_t digest;    // FEAT_DIGEST: CRC32C of the payload taken in
+    uint8_t digest_state;   // RX_DIGEST_*, settled by the FIN
+    uint32_t peer_digest;   // what the FIN said
+    fec_dec_t fec;          // FEAT_FEC: set up by the first protected packet
+    bool fin_received;
+    uint32_t total_packets;
+    uint32_t dropped_packets;
+    uint32_t out_of_order_packets;
+    uint32_t duplicate_packets;
+    uint32_t corrupt_packets; // failed the checksum, dropped
+    uint64_t total_bytes;
+} rxconn_t;
+
+// Trace defaults to text mode; replace rc->trace after init to change it
+int rxconn_init(rxconn_t *rc, const rxconn_io_t *io, uint64_t reasm_window, uint64_t seed);
+void rxconn_free(rxconn_t *rc);
+
+// One wire packet (header + payload); malformed packets are ignored.
+// Demultiplexing by connection ID is the caller's job.
+void rxconn_on_packet(rxconn_t *rc, const uint8_t *buf, size_t n);
+// One already parsed segment (fec: the header's fec byte); payload may be NULL
+void rxconn_on_segment(rxconn_t *rc, uint32_t seq, uint32_t len, uint8_t flags, uint8_t fec, const uint8_t *payload);
+// Delayed ACK timer
+void rxconn_on_timer(rxconn_t *rc);
+// The backlog shrank: send a window update if the window opened enough
+// to matter to the sender
+void rxconn_on_drain(rxconn_t *rc);
+
+// Packet counters of the final statistics
+void rxconn_print_stats(const rxconn_t *rc, FILE *out);
+// Add this connection's counters to the receiver part of c (the flows of a
+// striped transfer sum into one stats block)
+void rxconn_add_counters(const rxconn_t *rc, telem_counters_t *c);
+
+#endif
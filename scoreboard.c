@@ -0,0 +1,441 @@
+#include "scoreboard.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+
+int sb_init(scoreboard_t *sb, uint32_t cap, uint64_t end_seq, uint32_t mss) {
+    memset(sb, 0, sizeof(*sb));
+    if (cap == 0 || (cap & (cap - 1)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    sb->slots = calloc(cap, sizeof(*sb->slots));
+    if (!sb->slots) return -1;
+    sb->mask = cap - 1;
+    sb->end_seq = end_seq;
+    sb->mss = mss;
+    sb->rtx_head = SB_NONE;
+    sb->rtx_tail = SB_NONE;
+    sb->ts_head = SB_NONE;
+    sb->ts_tail = SB_NONE;
+    sb->wnd_end = UINT64_MAX;
+    return 0;
+}
+
+void sb_free(scoreboard_t *sb) {
+    free(sb->slots);
+    sb->slots = NULL;
+}
+
+static bool in_gbn_range(const scoreboard_t *sb, uint64_t idx) {
+    return idx >= sb->gbn_cursor && idx < sb->gbn_end;
+}
+
+static void rtx_unlink(scoreboard_t *sb, segment_t *seg);
+
+// The segment's block is settled at the receiver: its parity leaves the pipe
+static void parity_release(scoreboard_t *sb, uint64_t idx, segment_t *seg) {
+    if (seg->parity_len == 0) return;
+    if (idx >= sb->parity_floor) sb->bytes_parity -= seg->parity_len;
+    seg->parity_len = 0;
+}
+
+// Move a transmitted segment out of whichever byte counter holds it
+static void sb_unaccount(scoreboard_t *sb, uint64_t idx, const segment_t *seg) {
+    switch (seg->state) {
+    case SEG_INFLIGHT:
+        if (in_gbn_range(sb, idx)) {
+            sb->bytes_lost -= seg->len;
+        } else {
+            sb->bytes_in_flight -= seg->len;
+        }
+        break;
+    case SEG_LOST:
+        sb->bytes_lost -= seg->len;
+        break;
+    case SEG_SACKED:
+        sb->bytes_sacked -= seg->len;
+        break;
+    default:
+        break;
+    }
+}
+
+static void rtx_unlink(scoreboard_t *sb, segment_t *seg) {
+    if (seg->rtx_prev == SB_NONE) {
+        sb->rtx_head = seg->rtx_next;
+    } else {
+        sb_seg(sb, seg->rtx_prev)->rtx_next = seg->rtx_next;
+    }
+    if (seg->rtx_next == SB_NONE) {
+        sb->rtx_tail = seg->rtx_prev;
+    } else {
+        sb_seg(sb, seg->rtx_next)->rtx_prev = seg->rtx_prev;
+    }
+    seg->queued = false;
+}
+
+static void rtx_push(scoreboard_t *sb, uint64_t idx, segment_t *seg) {
+    seg->rtx_prev = sb->rtx_tail;
+    seg->rtx_next = SB_NONE;
+    if (sb->rtx_tail == SB_NONE) {
+        sb->rtx_head = idx;
+    } else {
+        sb_seg(sb, sb->rtx_tail)->rtx_next = idx;
+    }
+    sb->rtx_tail = idx;
+    seg->queued = true;
+}
+
+static void ts_unlink(scoreboard_t *sb, segment_t *seg) {
+    if (!seg->timed) return;
+    if (seg->ts_prev == SB_NONE) {
+        sb->ts_head = seg->ts_next;
+    } else {
+        sb_seg(sb, seg->ts_prev)->ts_next = seg->ts_next;
+    }
+    if (seg->ts_next == SB_NONE) {
+        sb->ts_tail = seg->ts_prev;
+    } else {
+        sb_seg(sb, seg->ts_next)->ts_prev = seg->ts_prev;
+    }
+    seg->timed = false;
+}
+
+static void ts_push(scoreboard_t *sb, uint64_t idx, segment_t *seg) {
+    ts_unlink(sb, seg);
+    seg->ts_prev = sb->ts_tail;
+    seg->ts_next = SB_NONE;
+    if (sb->ts_tail == SB_NONE) {
+        sb->ts_head = idx;
+    } else {
+        sb_seg(sb, sb->ts_tail)->ts_next = idx;
+    }
+    sb->ts_tail = idx;
+    seg->timed = true;
+}
+
+// A segment reached the receiver: fold it into the pending rate sample.
+// The sample follows the most recently sent delivered segment.
+static void sb_delivered(scoreboard_t *sb, const segment_t *seg) {
+    sb_rate_t *rs = &sb->rs;
+    sb->delivered += seg->len;
+    uint64_t end = seg->seq + seg->len;
+    // Sent once and delivered below what earlier ACKs had already reached:
+    // the path reorders. (Against fack as of the previous ACK, since this
+    // ACK's SACK blocks may name segments sent after the ones it acks.)
+    if (!rs->pending) rs->prior_fack = sb->fack;
+    if (seg->xmits == 1 && end < rs->prior_fack) sb->reordering_seen = true;
+    if (end > sb->fack) sb->fack = end;
+    if (seg->sent_ns > rs->rack_sent_ns || (seg->sent_ns == rs->rack_sent_ns && end > rs->rack_end_seq)) {
+        rs->rack_sent_ns = seg->sent_ns;
+        rs->rack_end_seq = end;
+        rs->rack_xmits = seg->xmits;
+    }
+    if (!rs->pending || seg->tx_delivered > rs->prior_delivered ||
+        (seg->tx_delivered == rs->prior_delivered && seg->sent_ns > rs->send_ns)) {
+        rs->prior_delivered = seg->tx_delivered;
+        rs->prior_ns = seg->tx_delivered_ns;
+        rs->send_ns = seg->sent_ns;
+    }
+    if (seg->xmits == 1 && seg->sent_ns > rs->rtt_sent_ns) rs->rtt_sent_ns = seg->sent_ns;
+    rs->pending = true;
+}
+
+void sb_stamp(scoreboard_t *sb, segment_t *seg, uint64_t now_ns) {
+    // Nothing else outstanding: the rate interval starts now, not at the
+    // last delivery before the idle period
+    if (sb->delivered_ns == 0 || sb->bytes_in_flight + sb->bytes_lost + sb->bytes_sacked == seg->len) {
+        sb->delivered_ns = now_ns;
+    }
+    seg->sent_ns = now_ns;
+    seg->tx_delivered = sb->delivered;
+    seg->tx_delivered_ns = sb->delivered_ns;
+    ts_push(sb, seg->seq / sb->mss, seg);
+}
+
+bool sb_rate_sample(scoreboard_t *sb, uint64_t now_ns, sb_rate_t *out) {
+    sb_rate_t *rs = &sb->rs;
+    if (!rs->pending) return false;
+    sb->delivered_ns = now_ns;
+    *out = *rs;
+    out->delivered = sb->delivered - rs->prior_delivered;
+    out->interval_ns = now_ns > rs->prior_ns ? now_ns - rs->prior_ns : 0;
+    out->rtt_ns = (rs->rtt_sent_ns != 0 && now_ns > rs->rtt_sent_ns) ? now_ns - rs->rtt_sent_ns : 0;
+    memset(rs, 0, sizeof(*rs));
+    return true;
+}
+
+segment_t *sb_take_next(scoreboard_t *sb, bool *retransmit) {
+    uint64_t idx;
+    segment_t *seg = NULL;
+    if (sb->rtx_head != SB_NONE) {
+        idx = sb->rtx_head;
+        seg = sb_seg(sb, idx);
+        rtx_unlink(sb, seg);
+        sb->bytes_lost -= seg->len;
+        *retransmit = true;
+    } else {
+        while (sb->gbn_cursor < sb->gbn_end) {
+            idx = sb->gbn_cursor++;
+            seg = sb_seg(sb, idx);
+            if (seg->state == SEG_INFLIGHT || seg->state == SEG_LOST) {
+                sb->bytes_lost -= seg->len;
+                *retransmit = true;
+                break;
+            }
+            seg = NULL;   // sacked while waiting
+        }
+    }
+    if (!seg) {
+        if (sb->fill_seq >= sb->end_seq || sb->next_idx - sb->base_idx > sb->mask || sb_wnd_blocked(sb)) return NULL;
+        idx = sb->next_idx++;
+        seg = sb_seg(sb, idx);
+        seg->seq = sb->fill_seq;
+        seg->len = sb_next_len(sb);
+        seg->xmits = 0;
+        seg->queued = false;
+        seg->timed = false;
+        seg->fec = 0;
+        seg->parity_len = 0;
+        sb->fill_seq += seg->len;
+        *retransmit = false;
+    }
+    seg->state = SEG_INFLIGHT;
+    if (seg->xmits < UINT8_MAX) seg->xmits++;
+    sb->bytes_in_flight += seg->len;
+    return seg;
+}
+
+uint64_t sb_ack(scoreboard_t *sb, uint64_t ack_seq, uint32_t *segs) {
+    uint64_t acked = 0;
+    uint32_t count = 0;
+    if (ack_seq > sb->end_seq) ack_seq = sb->end_seq;
+    while (sb->base_idx < sb->next_idx) {
+        segment_t *seg = sb_seg(sb, sb->base_idx);
+        if (seg->seq + seg->len > ack_seq) break;
+        sb_unaccount(sb, sb->base_idx, seg);
+        if (seg->queued) rtx_unlink(sb, seg);
+        ts_unlink(sb, seg);
+        parity_release(sb, sb->base_idx, seg);
+        if (seg->state == SEG_SACKED) {
+            if (sb->base_idx < sb->loss_scan) sb->sacked_below_scan -= seg->len;
+        } else {
+            sb_delivered(sb, seg);
+        }
+        seg->state = SEG_UNSENT;
+        acked += seg->len;
+        count++;
+        sb->base_idx++;
+    }
+    if (sb->loss_scan < sb->base_idx) sb->loss_scan = sb->base_idx;
+    if (sb->gbn_cursor < sb->base_idx) sb->gbn_cursor = sb->base_idx;
+    if (sb->gbn_end < sb->gbn_cursor) sb->gbn_end = sb->gbn_cursor;
+    if (ack_seq > sb->snd_una) sb->snd_una = ack_seq;
+    if (segs) *segs = count;
+    return acked;
+}
+
+void sb_mark_lost(scoreboard_t *sb, uint64_t idx) {
+    if (idx < sb->base_idx || idx >= sb->next_idx) return;
+    segment_t *seg = sb_seg(sb, idx);
+    if (seg->state != SEG_INFLIGHT || in_gbn_range(sb, idx)) return;
+    sb->bytes_in_flight -= seg->len;
+    sb->bytes_lost += seg->len;
+    seg->state = SEG_LOST;
+    ts_unlink(sb, seg);
+    rtx_push(sb, idx, seg);
+}
+
+void sb_timeout(scoreboard_t *sb) {
+    // In-flight segments outside the old range join the lost bytes; LOST
+    // ones are already counted there and get resent by the cursor instead of
+    // the queue. Emptying the queue is amortized against the mark_lost calls.
+    while (sb->rtx_head != SB_NONE) {
+        rtx_unlink(sb, sb_seg(sb, sb->rtx_head));
+    }
+    while (sb->ts_head != SB_NONE) {
+        ts_unlink(sb, sb_seg(sb, sb->ts_head));
+    }
+    sb->bytes_lost += sb->bytes_in_flight;
+    sb->bytes_in_flight = 0;
+    sb->gbn_cursor = sb->base_idx;
+    sb->gbn_end = sb->next_idx;
+    sb->bytes_parity = 0;
+    sb->parity_floor = sb->next_idx;
+    // Everything up to here is being resent anyway; judge only newer data
+    sb->loss_scan = sb->next_idx;
+    sb->sacked_below_scan = sb->bytes_sacked;
+}
+
+// First index in [base, next) whose segment ends after seq
+static uint64_t sb_find(const scoreboard_t *sb, uint64_t seq) {
+    uint64_t lo = sb->base_idx, hi = sb->next_idx;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        const segment_t *seg = sb_seg(sb, mid);
+        if (seg->seq + seg->len <= seq) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// End of the sacked run starting at idx, with path compression so repeated
+// SACK blocks covering the same segments cost amortized O(1)
+static uint64_t sack_run_end(scoreboard_t *sb, uint64_t idx) {
+    uint64_t r = idx;
+    while (r < sb->next_idx && sb_seg(sb, r)->state == SEG_SACKED) r = sb_seg(sb, r)->skip;
+    while (idx < r) {
+        segment_t *seg = sb_seg(sb, idx);
+        uint64_t nxt = seg->skip;
+        seg->skip = r;
+        idx = nxt;
+    }
+    return r;
+}
+
+uint64_t sb_sack(scoreboard_t *sb, uint64_t start, uint64_t end) {
+    uint64_t newly = 0;
+    if (start < sb->snd_una) start = sb->snd_una;
+    if (end <= start) return 0;
+    uint64_t idx = sb_find(sb, start);
+    while (idx < sb->next_idx) {
+        segment_t *seg = sb_seg(sb, idx);
+        if (seg->seq < start || seg->seq + seg->len > end) {
+            if (seg->seq >= end) break;
+            idx++;   // only partly covered
+            continue;
+        }
+        if (seg->state == SEG_SACKED) {
+            idx = sack_run_end(sb, idx);
+            continue;
+        }
+        if (seg->state == SEG_INFLIGHT || seg->state == SEG_LOST) {
+            sb_unaccount(sb, idx, seg);
+            if (seg->queued) rtx_unlink(sb, seg);
+            ts_unlink(sb, seg);
+            parity_release(sb, idx, seg);
+            seg->state = SEG_SACKED;
+            seg->skip = idx + 1;
+            sb_delivered(sb, seg);
+            sb->bytes_sacked += seg->len;
+            if (idx < sb->loss_scan) sb->sacked_below_scan += seg->len;
+            newly += seg->len;
+        }
+        idx++;
+    }
+    return newly;
+}
+
+uint32_t sb_detect_losses(scoreboard_t *sb, uint64_t thresh_bytes) {
+    uint32_t marked = 0;
+    while (sb->loss_scan < sb->next_idx) {
+        segment_t *seg = sb_seg(sb, sb->loss_scan);
+        if (seg->state == SEG_SACKED) {
+            sb->sacked_below_scan += seg->len;
+        } else {
+            uint64_t thresh = thresh_bytes + (uint64_t)sb_fec_grace(sb, sb->loss_scan) * sb->mss;
+            if (sb->bytes_sacked - sb->sacked_below_scan <= thresh) break;
+            if (seg->state == SEG_INFLIGHT && !in_gbn_range(sb, sb->loss_scan)) {
+                sb_mark_lost(sb, sb->loss_scan);
+                marked++;
+            }
+        }
+        sb->loss_scan++;
+    }
+    return marked;
+}
+
+void sb_rack_update(scoreboard_t *sb, uint64_t now_ns, uint64_t min_rtt_ns) {
+    const sb_rate_t *rs = &sb->rs;
+    if (!rs->pending || rs->rack_sent_ns == 0 || now_ns < rs->rack_sent_ns) return;
+    uint64_t rtt = now_ns - rs->rack_sent_ns;
+    if (rs->rack_xmits > 1 && rtt < min_rtt_ns) return;
+    sb->rack_rtt_ns = rtt;
+    if (rs->rack_sent_ns > sb->rack_xmit_ns ||
+        (rs->rack_sent_ns == sb->rack_xmit_ns && rs->rack_end_seq > sb->rack_end_seq)) {
+        sb->rack_xmit_ns = rs->rack_sent_ns;
+        sb->rack_end_seq = rs->rack_end_seq;
+    }
+}
+
+uint32_t sb_rack_detect(scoreboard_t *sb, uint64_t now_ns, uint64_t reo_wnd_ns, uint64_t *deadline_ns) {
+    uint32_t marked = 0;
+    *deadline_ns = 0;
+    // Oldest send first: the first segment not yet due ends the walk, as
+    // every later one was sent later still
+    while (sb->ts_head != SB_NONE) {
+        uint64_t idx = sb->ts_head;
+        segment_t *seg = sb_seg(sb, idx);
+        if (seg->sent_ns > sb->rack_xmit_ns ||
+            (seg->sent_ns == sb->rack_xmit_ns && seg->seq + seg->len >= sb->rack_end_seq)) {
+            break;   // not sent before anything delivered
+        }
+        uint64_t from = seg->sent_ns;
+        uint32_t grace = sb_fec_grace(sb, idx);
+        if (grace > 0) {
+            if (idx + grace >= sb->next_idx) break;   // its parity is not out yet
+            const segment_t *last = sb_seg(sb, idx + grace);
+            if (last->sent_ns > from) from = last->sent_ns;
+        }
+        uint64_t due = from + sb->rack_rtt_ns + reo_wnd_ns;
+        if (due > now_ns) {
+            *deadline_ns = due;
+            break;
+        }
+        ts_unlink(sb, seg);
+        if (seg->state == SEG_INFLIGHT && !in_gbn_range(sb, idx)) {
+            sb_mark_lost(sb, idx);
+            marked++;
+        }
+    }
+    return marked;
+}
+
+uint64_t sb_last_unsacked(const scoreboard_t *sb) {
+    for (uint64_t idx = sb->next_idx; idx > sb->base_idx; idx--) {
+        const segment_t *seg = sb_seg(sb, idx - 1);
+        if (seg->state == SEG_INFLIGHT && !in_gbn_range(sb, idx - 1)) return idx - 1;
+    }
+    return SB_NONE;
+}
+
+void sb_parity_sent(scoreboard_t *sb, uint64_t idx, uint32_t len) {
+    if (idx < sb->base_idx || idx >= sb->next_idx) return;
+    segment_t *seg = sb_seg(sb, idx);
+    if (seg->state != SEG_INFLIGHT && seg->state != SEG_LOST) return;   // settled already
+    seg->parity_len += len;
+    sb->bytes_parity += len;
+}
+
+uint32_t sb_fec_grace(const scoreboard_t *sb, uint64_t idx) {
+    const segment_t *seg = sb_seg(sb, idx);
+    if (!(seg->fec & FEC_DATA) || seg->xmits > 1) return 0;
+    uint64_t k = 1ull << (seg->fec & FEC_ARG_MASK);
+    if (k == 1) return 0;
+    // Segments are MSS-aligned, so the block is the k-aligned index range
+    uint64_t first = idx & ~(k - 1);
+    uint64_t last = first + k - 1;
+    if (first < sb->base_idx) first = sb->base_idx;
+    // Below the hole the block must be in; above it, an unsacked segment
+    // under a sacked one is a second hole
+    for (uint64_t j = first; j < idx; j++) {
+        if (sb_seg(sb, j)->state != SEG_SACKED) return 0;
+    }
+    bool sacked_above = false;
+    for (uint64_t j = last < sb->next_idx ? last : sb->next_idx - 1; j > idx; j--) {
+        const segment_t *o = sb_seg(sb, j);
+        if (o->state == SEG_SACKED) {
+            sacked_above = true;
+        } else if (sacked_above || o->state == SEG_LOST || o->xmits > 1) {
+            return 0;
+        }
+    }
+    return (uint32_t)(last - idx);
+}
@@ -0,0 +1,194 @@
+#ifndef SCOREBOARD_H
+#define SCOREBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sender-side scoreboard: metadata for the in-flight window kept in a ring
+// indexed by segment number, with bytes in flight / lost / sacked and the
+// retransmit queue maintained incrementally so ACK and timeout processing
+// never rescan the window.
+
+#define SB_DEFAULT_CAP 65536   // ring size in segments, power of two
+#define SB_NONE UINT64_MAX
+
+enum {
+    SEG_UNSENT = 0,
+    SEG_INFLIGHT,   // transmitted, no feedback yet
+    SEG_LOST,       // declared lost, waiting in the retransmit queue
+    SEG_SACKED,     // selectively acknowledged
+};
+
+typedef struct {
+    uint64_t seq;       // byte offset in the file (wire seq is the low 32 bits)
+    uint32_t len;
+    uint8_t state;
+    uint8_t xmits;      // transmissions so far
+    bool queued;        // linked into the retransmit queue
+    uint8_t fec;        // FEC block of the first transmission (header fec byte, 0: none)
+    uint32_t parity_len; // parity sent right after it, counted until it is acked or sacked
+    uint64_t rtx_prev;  // retransmit queue links (segment indices)
+    uint64_t rtx_next;
+    uint64_t skip;      // SACKED: index at or before the end of this sacked run
+    bool timed;         // linked into the send-time list
+    uint64_t ts_prev;   // send-time list links (segment indices)
+    uint64_t ts_next;
+    uint64_t sent_ns;           // last transmission time
+    uint64_t tx_delivered;      // sb->delivered when it was sent
+    uint64_t tx_delivered_ns;   // sb->delivered_ns when it was sent
+} segment_t;
+
+// Delivery rate sample for one ACK: how much got delivered between the
+// newest newly delivered segment's send time and now, and an RTT sample from
+// a segment transmitted only once (Karn's rule).
+typedef struct {
+    bool pending;
+    uint64_t prior_delivered;   // delivered count when that segment was sent
+    uint64_t prior_ns;
+    uint64_t send_ns;
+    uint64_t rtt_sent_ns;       // newest sent_ns among delivered xmits == 1 segments
+    uint64_t rack_sent_ns;      // newest sent_ns among all delivered segments
+    uint64_t rack_end_seq;      // ... and that segment's end
+    uint8_t rack_xmits;
+    uint64_t prior_fack;        // sb->fack before this ACK
+    uint64_t delivered;         // bytes delivered over the interval
+    uint64_t interval_ns;
+    uint64_t rtt_ns;            // 0 when no RTT sample
+} sb_rate_t;
+
+typedef struct {
+    segment_t *slots;
+    uint64_t mask;
+    uint64_t end_seq;     // one past the last byte to send
+    uint32_t mss;
+    uint64_t wnd_end;     // receive window edge: new segments must end at or below it
+
+    uint64_t snd_una;     // cumulatively acked byte
+    uint64_t base_idx;    // oldest unacked segment
+    uint64_t next_idx;    // first segment never transmitted
+    uint64_t fill_seq;    // byte offset of segment next_idx
+
+    // After an RTO every outstanding segment in [gbn_cursor, gbn_end) counts
+    // as lost and is resent in order as cwnd allows (go-back-N without
+    // touching each segment up front).
+    uint64_t gbn_cursor;
+    uint64_t gbn_end;
+
+    uint64_t rtx_head;    // individually lost segments, FIFO (doubly linked
+    uint64_t rtx_tail;    // so a cumulative ACK can unlink in O(1))
+
+    // SACK loss detection (RFC 6675 IsLost) walks forward once: segments
+    // below loss_scan have been judged, sacked_below_scan is the sacked
+    // bytes among them, so sacked bytes above the cursor are O(1) to get.
+    uint64_t loss_scan;
+    uint64_t sacked_below_scan;
+
+    uint64_t bytes_in_flight;
+    uint64_t bytes_lost;
+    uint64_t bytes_sacked;
+
+    // FEC parity is never acked itself; it stays in the pipe until the
+    // last segment of its block is. An RTO writes it all off: segments
+    // below parity_floor no longer hold any.
+    uint64_t bytes_parity;
+    uint64_t parity_floor;
+
+    // RACK (RFC 8985): transmitted segments still in flight, oldest send
+    // first (every transmission moves a segment to the tail), and the most
+    // recently sent segment known to be delivered. A segment sent before
+    // that one and still missing a reordering window after its RTT is lost,
+    // whether it is a first transmission or a retransmission.
+    uint64_t ts_head;
+    uint64_t ts_tail;
+    uint64_t rack_xmit_ns;    // send time of the newest delivered segment
+    uint64_t rack_end_seq;
+    uint64_t rack_rtt_ns;     // RTT of that segment
+    uint64_t fack;            // highest byte delivered
+    bool reordering_seen;     // a segment sent once arrived below fack
+
+    uint64_t delivered;       // bytes acked or sacked so far, each counted once
+    uint64_t delivered_ns;    // when delivered last advanced
+    sb_rate_t rs;             // sample being built from the current ACK
+} scoreboard_t;
+
+int sb_init(scoreboard_t *sb, uint32_t cap, uint64_t end_seq, uint32_t mss);
+void sb_free(scoreboard_t *sb);
+
+static inline segment_t *sb_seg(const scoreboard_t *sb, uint64_t idx) {
+    return &sb->slots[idx & sb->mask];
+}
+
+static inline bool sb_all_acked(const scoreboard_t *sb) {
+    return sb->snd_una >= sb->end_seq;
+}
+
+static inline bool sb_idle(const scoreboard_t *sb) {
+    return sb->base_idx == sb->next_idx;
+}
+
+// Length of the next new segment
+static inline uint32_t sb_next_len(const scoreboard_t *sb) {
+    uint64_t remain = sb->end_seq - sb->fill_seq;
+    return remain < sb->mss ? (uint32_t)remain : sb->mss;
+}
+
+// New data is waiting but its next segment lies beyond the receive window
+static inline bool sb_wnd_blocked(const scoreboard_t *sb) {
+    return sb->fill_seq < sb->end_seq && sb->fill_seq + sb_next_len(sb) > sb->wnd_end;
+}
+
+// Next segment to put on the wire: queued retransmissions first, then the
+// go-back-N range, then new data while the ring and the receive window
+// have room. The segment is accounted as in flight; the caller must
+// transmit it. NULL if nothing to send.
+segment_t *sb_take_next(scoreboard_t *sb, bool *retransmit);
+
+// Record that seg goes on the wire at now_ns (delivery rate bookkeeping)
+void sb_stamp(scoreboard_t *sb, segment_t *seg, uint64_t now_ns);
+
+// Close the sample accumulated by sb_ack/sb_sack since the last call.
+// Returns false when this ACK delivered nothing.
+bool sb_rate_sample(scoreboard_t *sb, uint64_t now_ns, sb_rate_t *out);
+
+// Cumulative ACK. Returns newly acked bytes; *segs gets the segment count.
+uint64_t sb_ack(scoreboard_t *sb, uint64_t ack_seq, uint32_t *segs);
+
+// Declare segment idx lost and queue it for retransmission
+void sb_mark_lost(scoreboard_t *sb, uint64_t idx);
+
+// Retransmission timeout: everything outstanding is lost
+void sb_timeout(scoreboard_t *sb);
+
+// Selective ACK of [start, end). Returns newly sacked bytes.
+uint64_t sb_sack(scoreboard_t *sb, uint64_t start, uint64_t end);
+
+// Fold this ACK's newest delivered segment into the RACK state; call before
+// sb_rate_sample. A retransmission acked sooner than min_rtt_ns after it
+// was sent proves nothing: the ACK was likely for the original.
+void sb_rack_update(scoreboard_t *sb, uint64_t now_ns, uint64_t min_rtt_ns);
+
+// RACK loss detection: mark every in-flight segment sent before the newest
+// delivered one whose RTT plus reo_wnd_ns has passed. A hole its FEC block
+// may still rebuild counts from when the block's last segment (and parity)
+// went out. *deadline_ns gets when the next segment would expire, 0 when
+// none is waiting. Returns the number of segments newly marked.
+uint32_t sb_rack_detect(scoreboard_t *sb, uint64_t now_ns, uint64_t reo_wnd_ns, uint64_t *deadline_ns);
+
+// Highest in-flight segment that has not been sacked (tail loss probe),
+// SB_NONE when there is none
+uint64_t sb_last_unsacked(const scoreboard_t *sb);
+
+// Mark every unsacked segment with more than thresh_bytes sacked above it
+// (plus its FEC grace) as lost. Returns the number of segments newly marked.
+uint32_t sb_detect_losses(scoreboard_t *sb, uint64_t thresh_bytes);
+
+// A parity packet of len bytes went out right after segment idx
+void sb_parity_sent(scoreboard_t *sb, uint64_t idx, uint32_t len);
+
+// Segments more than usual to wait before the hole at idx counts as lost:
+// the rest of its FEC block, after which the parity has had its chance.
+// 0 when the block cannot be repaired (another segment of it is missing,
+// or the hole was retransmitted) or has no parity.
+uint32_t sb_fec_grace(const scoreboard_t *sb, uint64_t idx);
+
+#endif
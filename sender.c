@@ -1,39 +1,108 @@
+#define _GNU_SOURCE
 #include <arpa/inet.h>
+#include <endian.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/select.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
-#include <sys/time.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 
-#define MAX_PAYLOAD 1400
-#define MAX_WINDOW_PACKETS 1024
+#include "batch_io.h"
+#include "cc.h"
+#include "crc32c.h"
+#include "evloop.h"
+#include "flow.h"
+#include "protocol.h"
+#include "telemetry.h"
+#include "trace.h"
 
-typedef struct __attribute__((packed)) {
-    uint32_t seq;     // byte offset
-    uint32_t len;     // payload length
-    uint8_t flags;    // bit0: FIN
-} packet_header_t;
+#define MAX_STRIPES 64
+#define SYN_RETRIES 6                 // SYN retransmissions (backed off) before giving up
+#define PROBE_TRIES 3                 // unanswered probes before a size counts as too big
+#define PROBE_RESOLUTION 32           // stop the PLPMTU search once it is this narrow (bytes)
 
-typedef struct __attribute__((packed)) {
-    uint32_t ack;     // next expected byte
-    uint8_t dup;
-} ack_packet_t;
+enum {
+    PHASE_SYN = 0,                    // waiting for the SYN-ACK
+    PHASE_PROBE,                      // searching the path MTU
+    PHASE_DATA,                       // flow running
+};
 
+// Settings shared by every flow of a transfer
 typedef struct {
-    uint32_t seq;
-    uint32_t len;
-    uint8_t data[MAX_PAYLOAD];
-    bool sent;
-    bool acked;
-} segment_t;
+    struct sockaddr_in peer;
+    int batch_size;
+    bool use_gso;
+    flow_config_t flow;           // conn_id is filled in per flow
+    bool probe_mtu;               // DPLPMTUD after the handshake
+    bool checksum;                // offer per-packet CRC32C
+    int trace_mode;
+    const char *trace_path;
+    const char *series_path;      // time series (-j: one per flow, .N appended)
+    const char *stats_path;       // live stats block, likewise
+    uint64_t sample_ns;           // interval of both
+} tx_config_t;
+
+// The UDP side of a flow: socket, batches and the timers behind flow_io_t.
+// With -j each one runs on its own thread with its own event loop.
+typedef struct {
+    flow_t flow;
+    const tx_config_t *cfg;
+    int sockfd;
+    struct sockaddr_in peer;
+    batch_tx_t tx;
+    batch_rx_t rx;
+    evloop_t loop;
+    evloop_handler_t sock_ev;
+    evloop_timer_t rto_timer;
+    evloop_timer_t pace_timer;
+    evloop_timer_t persist_timer;
+    pthread_t thread;
+
+    // Every flow opens with a SYN (carrying its stripe) and may probe the
+    // path before the flow itself is set up with the resulting MSS
+    int phase;
+    bool striped;
+    uint32_t conn_id;
+    input_map_t in;
+    trace_t trace;                // handed to the flow when it starts
+    syn_t syn;
+    evloop_timer_t ctl_timer;     // SYN and probe retransmission
+    uint64_t ctl_rto_ns;
+    int ctl_retries;
+    uint64_t syn_sent_ns;
+    uint64_t syn_rtt_ns;
+    uint32_t payload_limit;       // agreed in the handshake
+    uint32_t peer_wnd;            // receive window in the SYN-ACK
+    uint16_t features;
+    bool csum;                    // packets carry a CRC32C (offered, then agreed)
+    uint32_t plpmtu;              // largest datagram known to get through
+    uint32_t probe_hi;            // largest datagram not ruled out yet
+    uint32_t probe_size;          // datagram size being probed, 0 before the first
+    uint32_t probes;
+    uint8_t *probe_buf;
+    int saved_pmtudisc;
+    double elapsed;               // seconds from first send to FIN
+
+    // Telemetry: sampled on a timer while the flow runs
+    bool sampling;
+    telem_series_t series;        // file is NULL when not recording
+    telem_stats_t *stats;
+    evloop_timer_t sample_timer;
+} sender_t;
 
 static void die(const char *msg) {
     perror(msg);
@@ -46,326 +115,803 @@ static double now_ms(void) {
     return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
 }
 
-static void send_segment(uint32_t idx, segment_t *segments, int sockfd, struct sockaddr_in *peer, bool is_retransmit, bool has_timer) {
-    packet_header_t hdr;
-    hdr.seq = htonl(segments[idx].seq);
-    hdr.len = htonl(segments[idx].len);
-    hdr.flags = 0;
-    uint8_t buffer[sizeof(hdr) + MAX_PAYLOAD];
-    memcpy(buffer, &hdr, sizeof(hdr));
-    memcpy(buffer + sizeof(hdr), segments[idx].data, segments[idx].len);
-    ssize_t n = sendto(sockfd, buffer, sizeof(hdr) + segments[idx].len, 0, (struct sockaddr *)peer, sizeof(*peer));
-    if (n < 0) {
-        perror("sendto");
-        exit(EXIT_FAILURE);
+// Random so that concurrent and consecutive transfers never share an ID
+static uint32_t new_conn_id(void) {
+    uint32_t id;
+    if (getrandom(&id, sizeof(id), 0) != (ssize_t)sizeof(id)) {
+        id = (uint32_t)evloop_now_ns() ^ ((uint32_t)getpid() << 16);
     }
-    segments[idx].sent = true;
-    
-    if (is_retransmit) {
-        printf("---→ 패킷 (seq:%u, size:%u) 재전송\n", segments[idx].seq, segments[idx].len);
-    } else {
-        printf("→ 패킷 (seq:%u, size:%u) 송신", segments[idx].seq, segments[idx].len);
-        if (has_timer) {
-            printf(" (타이머)");
+    return id;
+}
+
+static uint64_t io_now_ns(void *ctx) {
+    (void)ctx;
+    return evloop_now_ns();
+}
+
+// Queue a packet on the TX batch; it goes out with the next flush. Every
+// packet passes here, so this is where the checksum goes in.
+static void io_send(void *ctx, const void *hdr, size_t hlen, const uint8_t *payload, size_t plen) {
+    sender_t *s = ctx;
+    packet_header_t h;
+    if (s->csum && hlen == sizeof(h)) {
+        memcpy(&h, hdr, sizeof(h));
+        h.csum = htonl(packet_csum(&h, payload, plen));
+        hdr = &h;
+    }
+    if (batch_tx_add(&s->tx, hdr, hlen, payload, plen, (struct sockaddr *)&s->peer, sizeof(s->peer)) < 0) {
+        die("sendmmsg");
+    }
+}
+
+static void io_flush(void *ctx) {
+    sender_t *s = ctx;
+    if (batch_tx_flush(&s->tx) < 0) die("sendmmsg");
+}
+
+static void io_timer(void *ctx, int which, uint64_t deadline_ns) {
+    sender_t *s = ctx;
+    evloop_timer_t *t = which == FLOW_TIMER_RTO    ? &s->rto_timer
+                        : which == FLOW_TIMER_PACE ? &s->pace_timer
+                                                   : &s->persist_timer;
+    if (deadline_ns == 0) {
+        evloop_timer_disarm(t);
+    } else if (evloop_timer_arm_at(t, deadline_ns) < 0) {
+        die("timerfd_settime");
+    }
+}
+
+// Offer version, features and payload size and announce this flow's
+// range; repeated with backoff until the SYN-ACK arrives
+static void send_syn(sender_t *s) {
+    packet_header_t hdr = {0};
+    hdr.conn_id = htonl(s->conn_id);
+    hdr.len = htonl((uint32_t)sizeof(s->syn));
+    hdr.flags = FLAG_SYN;
+    if (s->ctl_retries == 0) s->syn_sent_ns = evloop_now_ns();
+    io_send(s, &hdr, sizeof(hdr), (const uint8_t *)&s->syn, sizeof(s->syn));
+    io_flush(s);
+    if (evloop_timer_arm(&s->ctl_timer, s->ctl_rto_ns) < 0) die("timerfd_settime");
+}
+
+// One time series row and one stats update from the flow's current state
+static void sender_sample(sender_t *s) {
+    if (s->phase != PHASE_DATA) return;
+    uint64_t now = evloop_now_ns();
+    if (s->series.file) {
+        telem_row_t row;
+        flow_sample(&s->flow, &row);
+        row.t_ns = now - s->series.start_ns;
+        telem_series_push(&s->series, &row);
+    }
+    if (s->stats) {
+        telem_counters_t c = {0};
+        flow_counters(&s->flow, &c);
+        c.t_ns = now - s->stats->start_ns;
+        telem_stats_publish(s->stats, &c);
+    }
+}
+
+static void on_sample(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    sender_t *s = arg;
+    sender_sample(s);
+    if (evloop_timer_arm(&s->sample_timer, s->cfg->sample_ns) < 0) die("timerfd_settime");
+}
+
+// Handshake and search are over: set up the flow with what they found
+static void start_data(sender_t *s) {
+    evloop_timer_disarm(&s->ctl_timer);
+    if (s->probe_buf) {
+        (void)setsockopt(s->sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &s->saved_pmtudisc, sizeof(s->saved_pmtudisc));
+        free(s->probe_buf);
+        s->probe_buf = NULL;
+    }
+    flow_config_t fcfg = s->cfg->flow;
+    fcfg.conn_id = s->conn_id;
+    fcfg.mss = s->plpmtu - (uint32_t)sizeof(packet_header_t);
+    fcfg.sack = fcfg.sack && (s->features & FEAT_SACK);
+    fcfg.rwnd = s->peer_wnd;
+    fcfg.digest = fcfg.digest && (s->features & FEAT_DIGEST);
+    fcfg.fec = fcfg.fec && (s->features & FEAT_FEC);
+    flow_io_t io = {
+        .ctx = s,
+        .now_ns = io_now_ns,
+        .send = io_send,
+        .flush = io_flush,
+        .timer = io_timer,
+    };
+    if (flow_init(&s->flow, &fcfg, &io, &s->in) < 0) die("flow_init");
+    s->flow.trace = s->trace;
+    s->phase = PHASE_DATA;
+    if (s->sampling) {
+        sender_sample(s);
+        if (evloop_timer_arm(&s->sample_timer, s->cfg->sample_ns) < 0) die("timerfd_settime");
+    }
+    if (!s->striped || s->syn.stripe == 0) {
+        printf("연결 수립: RTT %.3f 밀리초, 수신측 한도 %u 바이트, 수신 윈도우 %u 바이트, SACK %s, 경로 MTU 프로브 %u개 -> MSS %u 바이트\n",
+               (double)s->syn_rtt_ns / 1e6, s->payload_limit, s->peer_wnd, fcfg.sack ? "사용" : "사용 안 함", s->probes, fcfg.mss);
+        printf("무결성 검사: 패킷 체크섬 %s, 파일 다이제스트 %s\n", s->csum ? "사용" : "사용 안 함", fcfg.digest ? "사용" : "사용 안 함");
+        if (fcfg.fec && fcfg.fec_k) {
+            printf("FEC: 고정 블록 (데이터 세그먼트 %u개마다 패리티 1개)%s\n", s->flow.fec.fixed_k,
+                   fcfg.fec_keep_cwnd ? ", 복구된 손실에 윈도우 유지" : "");
+        } else if (fcfg.fec) {
+            printf("FEC: 손실률에 따라 블록 크기 조정 (%d ~ %d 세그먼트)%s\n", FEC_K_MIN, FEC_K_MAX,
+                   fcfg.fec_keep_cwnd ? ", 복구된 손실에 윈도우 유지" : "");
+        } else if (s->cfg->flow.fec) {
+            printf("FEC: 수신측이 지원하지 않아 사용 안 함\n");
         }
-        printf("\n");
+        fflush(stdout);
     }
+    flow_pump(&s->flow);
 }
 
-static void send_fin_packet(uint32_t seq_cursor, int sockfd, struct sockaddr_in *peer) {
-    packet_header_t hdr;
-    hdr.seq = htonl(seq_cursor);
-    hdr.len = htonl(0);
-    hdr.flags = 0x01; // FIN
-    (void)sendto(sockfd, &hdr, sizeof(hdr), 0, (struct sockaddr *)peer, sizeof(*peer));
+// One PROBE datagram of probe_size bytes, padded with zeros. False when
+// the local interface already refuses that size.
+static bool send_probe(sender_t *s) {
+    packet_header_t hdr = {0};
+    hdr.conn_id = htonl(s->conn_id);
+    hdr.len = htonl(s->probe_size - (uint32_t)sizeof(hdr));
+    hdr.flags = FLAG_PROBE;
+    if (s->csum) hdr.csum = htonl(packet_csum(&hdr, s->probe_buf + sizeof(hdr), s->probe_size - sizeof(hdr)));
+    memcpy(s->probe_buf, &hdr, sizeof(hdr));
+    s->probes++;
+    if (sendto(s->sockfd, s->probe_buf, s->probe_size, 0, (struct sockaddr *)&s->peer, sizeof(s->peer)) < 0) {
+        if (errno == EMSGSIZE) return false;
+        die("sendto");
+    }
+    // A few RTTs: the probe is as big as it gets and may queue behind nothing else
+    uint64_t timeout = 4 * s->syn_rtt_ns;
+    if (timeout < s->cfg->flow.min_rto_ns) timeout = s->cfg->flow.min_rto_ns;
+    if (evloop_timer_arm(&s->ctl_timer, timeout) < 0) die("timerfd_settime");
+    return true;
 }
 
-int main(int argc, char **argv) {
-    if (argc < 5 || argc > 6) {
-        fprintf(stderr, "사용법: %s <수신자_IP> <수신자_포트> <입력파일> <MSS_바이트> [RTO_밀리초]\n", argv[0]);
-        fprintf(stderr, "예시: %s 127.0.0.1 9000 input.bin 1000 200\n", argv[0]);
-        return EXIT_FAILURE;
+// DPLPMTUD search (RFC 8899): try the agreed size first, since it usually
+// fits, then bisect between the confirmed size and the smallest failure
+static void probe_next(sender_t *s) {
+    while (s->probe_hi > s->plpmtu) {
+        if (s->probe_size == 0) {
+            s->probe_size = s->probe_hi;
+        } else if (s->probe_hi - s->plpmtu < PROBE_RESOLUTION) {
+            break;
+        } else {
+            s->probe_size = (s->plpmtu + s->probe_hi + 1) / 2;
+        }
+        s->ctl_retries = 0;
+        if (send_probe(s)) return;
+        s->probe_hi = s->probe_size - 1;
     }
+    start_data(s);
+}
 
-    const char *receiver_ip = argv[1];
-    int receiver_port = atoi(argv[2]);
-    const char *input_path = argv[3];
-    int mss = atoi(argv[4]);
-    if (mss <= 0 || mss > MAX_PAYLOAD) mss = MAX_PAYLOAD;
-    int rto_ms = (argc == 6) ? atoi(argv[5]) : 200; // default 200ms retransmission timeout
-    if (rto_ms < 50) rto_ms = 50;
+static void on_probe_ack(sender_t *s, uint32_t size) {
+    if (size > s->plpmtu) s->plpmtu = size;
+    if (size > s->probe_hi) s->probe_hi = size;
+    if (size >= s->probe_size) probe_next(s);
+}
 
-    printf("=== 송신 프로그램 시작 ===\n");
-    printf("수신자: %s:%d\n", receiver_ip, receiver_port);
-    printf("입력 파일: %s\n", input_path);
-    printf("MSS: %d 바이트\n", mss);
-    printf("RTO: %d 밀리초\n", rto_ms);
-    printf("파일 읽는 중...\n");
+static void on_syn_ack(sender_t *s, const ctl_ack_t *ack) {
+    if (ack->version != PROTO_VERSION) {
+        fprintf(stderr, "오류: 수신자 프로토콜 버전 %u, 송신자 버전 %u\n", ack->version, PROTO_VERSION);
+        exit(EXIT_FAILURE);
+    }
+    uint32_t limit = ntohl(ack->value);
+    if (limit > s->cfg->flow.mss) limit = s->cfg->flow.mss;
+    if (limit == 0) {
+        fprintf(stderr, "오류: 수신자가 페이로드 크기 0을 제시했습니다\n");
+        exit(EXIT_FAILURE);
+    }
+    s->payload_limit = limit;
+    s->peer_wnd = ntohl(ack->wnd);
+    s->features = ntohs(ack->features) & ntohs(s->syn.features);
+    s->csum = (s->features & FEAT_CHECKSUM) != 0;
+    // Karn: a retransmitted SYN gives no RTT sample
+    s->syn_rtt_ns = s->ctl_retries == 0 ? evloop_now_ns() - s->syn_sent_ns : s->cfg->flow.initial_rto_ns;
 
-    FILE *fin = fopen(input_path, "rb");
-    if (!fin) {
-        fprintf(stderr, "오류: 입력 파일을 열 수 없습니다: %s\n", input_path);
+    uint32_t agreed = (uint32_t)sizeof(packet_header_t) + limit;
+    s->plpmtu = agreed;
+    if (!s->cfg->probe_mtu || agreed <= PLPMTU_BASE) {
+        start_data(s);
+        return;
+    }
+    // Probes must not be fragmented or held to the kernel's PMTU guess
+    socklen_t optlen = sizeof(s->saved_pmtudisc);
+    int mode = IP_PMTUDISC_PROBE;
+    if (getsockopt(s->sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &s->saved_pmtudisc, &optlen) < 0 ||
+        setsockopt(s->sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &mode, sizeof(mode)) < 0) {
+        start_data(s);
+        return;
+    }
+    s->probe_buf = calloc(1, agreed);
+    if (!s->probe_buf) die("calloc");
+    s->phase = PHASE_PROBE;
+    s->plpmtu = PLPMTU_BASE;
+    s->probe_hi = agreed;
+    probe_next(s);
+}
+
+// SYN-ACKs and probe confirmations before the flow starts
+static void on_ctl_ack(sender_t *s, const uint8_t *buf, size_t n) {
+    ctl_ack_t ack;
+    if (n < sizeof(ack)) return;
+    memcpy(&ack, buf, sizeof(ack));
+    if (ntohl(ack.conn_id) != s->conn_id) return;
+    if (s->phase == PHASE_SYN && (ack.flags & ACK_F_SYN)) {
+        on_syn_ack(s, &ack);
+    } else if (s->phase == PHASE_PROBE && (ack.flags & ACK_F_PROBE)) {
+        on_probe_ack(s, ntohl(ack.value));
+    }
+}
+
+static void on_ctl_timer(evloop_t *loop, uint32_t events, void *arg) {
+    (void)loop;
+    (void)events;
+    sender_t *s = arg;
+    if (s->phase == PHASE_PROBE) {
+        if (++s->ctl_retries < PROBE_TRIES) {
+            if (send_probe(s)) return;
+        }
+        s->probe_hi = s->probe_size - 1;
+        probe_next(s);
+        return;
+    }
+    if (++s->ctl_retries > SYN_RETRIES) {
+        fprintf(stderr, "오류: 흐름 %u: 수신자가 SYN에 응답하지 않습니다\n", ntohs(s->syn.stripe));
         exit(EXIT_FAILURE);
     }
+    s->ctl_rto_ns *= 2;
+    send_syn(s);
+}
 
-    // Read file into segments
-    segment_t *segments = NULL;
-    size_t seg_cap = 0, seg_cnt = 0;
-    uint32_t seq_cursor = 0;
-    while (1) {
-        if (seg_cnt == seg_cap) {
-            seg_cap = seg_cap ? seg_cap * 2 : 1024;
-            segments = (segment_t *)realloc(segments, seg_cap * sizeof(segment_t));
-            if (!segments) die("realloc");
+static void on_socket(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    sender_t *s = arg;
+    // Drain every ACK that is already queued in one recvmmsg
+    int got = batch_rx_recv(&s->rx, MSG_DONTWAIT);
+    if (got < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+        die("recvmmsg");
+    }
+    for (unsigned i = 0; i < (unsigned)got; i++) {
+        if (s->phase != PHASE_DATA) {
+            on_ctl_ack(s, batch_rx_buf(&s->rx, i), batch_rx_len(&s->rx, i));
+        } else {
+            flow_on_ack_packet(&s->flow, batch_rx_buf(&s->rx, i), batch_rx_len(&s->rx, i));
         }
-        segment_t *seg = &segments[seg_cnt];
-        seg->seq = seq_cursor;
-        seg->len = (uint32_t)fread(seg->data, 1, (size_t)mss, fin);
-        seg->sent = false;
-        seg->acked = false;
-        if (seg->len == 0) break;
-        seq_cursor += seg->len;
-        seg_cnt++;
-    }
-    fclose(fin);
-    printf("파일 읽기 완료: 총 %zu 세그먼트 (%u 바이트)\n", seg_cnt, seq_cursor);
-    printf("소켓 설정 중...\n");
+    }
+    if (s->phase != PHASE_DATA) return;
+    flow_pump(&s->flow);
+    if (s->flow.done) evloop_stop(loop);
+}
+
+static void on_rto(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    sender_t *s = arg;
+    flow_on_rto(&s->flow);
+    if (s->flow.done) evloop_stop(loop);
+}
+
+static void on_pace(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    sender_t *s = arg;
+    flow_on_pace(&s->flow);
+    if (s->flow.done) evloop_stop(loop);
+}
+
+static void on_persist(evloop_t *loop, uint32_t events, void *arg) {
+    (void)events;
+    sender_t *s = arg;
+    flow_on_persist(&s->flow);
+    if (s->flow.done) evloop_stop(loop);
+}
 
-    // Socket setup
+// Socket, batches and timers for the byte range in, announced by syn
+// (stripe fields set); the flow itself starts after the handshake
+static void sender_init(sender_t *s, const tx_config_t *cfg, const input_map_t *in, const syn_t *syn) {
+    s->cfg = cfg;
+    s->in = *in;
+    s->conn_id = new_conn_id();
+    s->striped = ntohs(syn->stripes) > 1;
+    s->syn = *syn;
+    s->syn.version = PROTO_VERSION;
+    s->syn.features = htons((cfg->flow.sack ? FEAT_SACK : 0) | (cfg->checksum ? FEAT_CHECKSUM : 0) |
+                            (cfg->flow.digest ? FEAT_DIGEST : 0) | (cfg->flow.fec ? FEAT_FEC : 0));
+    s->csum = cfg->checksum;
+    s->syn.max_payload = htonl(cfg->flow.mss);
+    trace_init(&s->trace, TRACE_OFF);
+    // Blocking, so a full send buffer holds the flow back instead of
+    // failing the send; every receive passes MSG_DONTWAIT
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0) {
         fprintf(stderr, "오류: 소켓 생성 실패\n");
         exit(EXIT_FAILURE);
     }
-    struct sockaddr_in peer = {0};
-    peer.sin_family = AF_INET;
-    peer.sin_port = htons((uint16_t)receiver_port);
-    if (inet_pton(AF_INET, receiver_ip, &peer.sin_addr) != 1) {
-        fprintf(stderr, "오류: 잘못된 IP 주소: %s\n", receiver_ip);
-        exit(EXIT_FAILURE);
+    s->sockfd = sockfd;
+    s->peer = cfg->peer;
+    if (batch_tx_init(&s->tx, sockfd, (unsigned)cfg->batch_size) < 0) die("batch_tx_init");
+    if (batch_rx_init(&s->rx, sockfd, (unsigned)cfg->batch_size, sizeof(ack_packet_t)) < 0) die("batch_rx_init");
+    if (cfg->use_gso && batch_tx_enable_gso(&s->tx) < 0 && syn->stripe == 0) {
+        printf("경고: UDP GSO를 지원하지 않아 일반 송신을 사용합니다\n");
+    } else if (cfg->use_gso && syn->stripe == 0) {
+        printf("UDP GSO 사용\n");
     }
+
+    if (evloop_init(&s->loop) < 0) die("epoll_create1");
+    if (evloop_add(&s->loop, &s->sock_ev, sockfd, EPOLLIN, on_socket, s) < 0) die("epoll_ctl");
+    evloop_timer_init(&s->loop, &s->rto_timer, on_rto, s);
+    evloop_timer_init(&s->loop, &s->pace_timer, on_pace, s);
+    evloop_timer_init(&s->loop, &s->persist_timer, on_persist, s);
+    evloop_timer_init(&s->loop, &s->ctl_timer, on_ctl_timer, s);
+    evloop_timer_init(&s->loop, &s->sample_timer, on_sample, s);
+    s->phase = PHASE_SYN;
+    s->ctl_rto_ns = cfg->flow.initial_rto_ns;
+}
+
+// Time series and stats block for this flow; suffix tells the flows of a
+// striped transfer apart (-1: none)
+static void sender_open_telemetry(sender_t *s, int suffix) {
+    const tx_config_t *cfg = s->cfg;
+    char path[4096];
+    uint64_t now = evloop_now_ns();
+    if (cfg->series_path) {
+        snprintf(path, sizeof(path), suffix < 0 ? "%s" : "%s.%d", cfg->series_path, suffix);
+        if (telem_series_open(&s->series, path, telem_series_format(cfg->series_path), cfg->sample_ns, now) < 0) die("telemetry series");
+    }
+    if (cfg->stats_path) {
+        snprintf(path, sizeof(path), suffix < 0 ? "%s" : "%s.%d", cfg->stats_path, suffix);
+        s->stats = telem_stats_open(path, TELEM_ROLE_SENDER, now);
+        if (!s->stats) die("telemetry stats");
+    }
+    s->sampling = cfg->series_path || cfg->stats_path;
+}
+
+static void sender_free(sender_t *s) {
+    if (s->phase == PHASE_DATA) {
+        flow_free(&s->flow);
+    } else {
+        trace_close(&s->trace);
+    }
+    if (s->series.file && telem_series_close(&s->series) < 0) {
+        fprintf(stderr, "경고: 시계열 파일을 끝까지 쓰지 못했습니다\n");
+    }
+    telem_stats_close(s->stats);
+    free(s->probe_buf);
+    evloop_timer_close(&s->sample_timer);
+    evloop_timer_close(&s->ctl_timer);
+    evloop_timer_close(&s->persist_timer);
+    evloop_timer_close(&s->pace_timer);
+    evloop_timer_close(&s->rto_timer);
+    evloop_close(&s->loop);
+    batch_tx_free(&s->tx);
+    batch_rx_free(&s->rx);
+    close(s->sockfd);
+}
+
+// Event loop: ACK arrivals and RTO expiry drive the flow until every
+// segment is acked, then until the FIN is confirmed (or given up on)
+static void sender_run(sender_t *s) {
+    double start_time = now_ms();
+    send_syn(s);
+    if (!s->flow.done && evloop_run(&s->loop) < 0) die("epoll_wait");
+    if (!s->striped) {
+        printf("----------------------------------------\n");
+        printf("전송 완료! FIN 패킷 전송 중...\n");
+    }
+    s->elapsed = (now_ms() - start_time) / 1000.0;
+    flow_send_fin(&s->flow);
+    // Every handler stops the loop once the flow is done
+    while (!s->flow.closed) {
+        if (evloop_run(&s->loop) < 0) die("epoll_wait");
+    }
+    // Final values, done set, for the series and anyone still polling
+    if (s->sampling) {
+        sender_sample(s);
+        evloop_timer_disarm(&s->sample_timer);
+    }
+}
+
+static void *sender_thread(void *arg) {
+    sender_run(arg);
+    return NULL;
+}
+
+static void print_batch_stats(uint64_t tx_packets, uint64_t tx_syscalls, uint64_t rx_packets, uint64_t rx_syscalls) {
+    printf("송신 배치: %.2f 패킷/syscall (%" PRIu64 " 패킷, %" PRIu64 " sendmmsg)\n",
+           batch_ratio(tx_packets, tx_syscalls), tx_packets, tx_syscalls);
+    printf("ACK 배치: %.2f 패킷/syscall (%" PRIu64 " 패킷, %" PRIu64 " recvmmsg)\n",
+           batch_ratio(rx_packets, rx_syscalls), rx_packets, rx_syscalls);
+}
+
+// Syscalls on the transfer path (batched socket I/O, epoll_wait wakeups,
+// timerfd reprogramming) per MB of file
+static void print_syscalls(uint64_t syscalls, uint64_t bytes) {
+    printf("시스템 콜: %" PRIu64 "회 (MB당 %.1f회)\n", syscalls,
+           bytes ? (double)syscalls * 1024.0 * 1024.0 / (double)bytes : 0.0);
+}
+
+// CPU time of every thread and the peak RSS, as getrusage sees them
+static void print_rusage(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) < 0) return;
+    printf("CPU 시간: 사용자 %.3f 초, 시스템 %.3f 초, 최대 RSS %ld KB\n",
+           (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6,
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6, ru.ru_maxrss);
+}
+
+// Split the mapping into page-aligned ranges (so each flow can release
+// acked pages on its own) and run one flow per range on its own thread
+static void run_striped(const tx_config_t *cfg, const input_map_t *in, int nflows) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t stripe = (in->size + (uint64_t)nflows - 1) / (uint64_t)nflows;
+    stripe = (stripe + page - 1) & ~(page - 1);
+    if (stripe == 0) stripe = page;
+    int n = (int)((in->size + stripe - 1) / stripe);
+    if (n < 1) n = 1;
+
+    uint32_t xfer_id = new_conn_id();
+    printf("병렬 전송: 흐름 %d개, 흐름당 최대 %" PRIu64 " 바이트, 전송 ID %08x\n", n, stripe, xfer_id);
+    sender_t *senders = calloc((size_t)n, sizeof(*senders));
+    if (!senders) die("calloc");
+    for (int i = 0; i < n; i++) {
+        uint64_t off = (uint64_t)i * stripe;
+        input_map_t part = *in;
+        part.data = in->data ? in->data + off : NULL;
+        part.size = in->size - off < stripe ? in->size - off : stripe;
+        part.released = 0;
+        syn_t syn = {
+            .xfer_id = htonl(xfer_id),
+            .stripe = htons((uint16_t)i),
+            .stripes = htons((uint16_t)n),
+            .offset = htobe64(off),
+            .size = htobe64(in->size),
+        };
+        sender_t *s = &senders[i];
+        sender_init(s, cfg, &part, &syn);
+        if (cfg->trace_mode == TRACE_FILE) {
+            // One ring per flow: the trace writer is single-threaded
+            char path[4096];
+            snprintf(path, sizeof(path), "%s.%d", cfg->trace_path, i);
+            if (trace_open_file(&s->trace, path, TRACE_DEFAULT_RECORDS) < 0) die("trace");
+        } else {
+            trace_init(&s->trace, cfg->trace_mode);
+        }
+        sender_open_telemetry(s, i);
+        printf("흐름 %d: 오프셋 %" PRIu64 ", %" PRIu64 " 바이트, 연결 ID %08x\n", i, off, part.size, s->conn_id);
+    }
+    if (cfg->trace_mode == TRACE_FILE) printf("트레이스 파일: %s.0 ~ %s.%d\n", cfg->trace_path, cfg->trace_path, n - 1);
+    if (cfg->series_path) printf("시계열 파일: %s.0 ~ %s.%d\n", cfg->series_path, cfg->series_path, n - 1);
+    if (cfg->stats_path) printf("통계 엔드포인트: %s.0 ~ %s.%d\n", cfg->stats_path, cfg->stats_path, n - 1);
     printf("전송 시작!\n");
     printf("----------------------------------------\n");
+    fflush(stdout);
 
-    // Congestion control state (TCP Reno) - 바이트 단위
-    double cwnd = (double)mss;    // 초기값: 1 MSS (바이트 단위)
-    double ssthresh = 65536.0;    // 초기 임계값: 65536 바이트 (임의 설정)
-    uint32_t base_idx = 0;       // oldest unacked segment index
-    uint32_t next_idx = 0;       // next segment index to send
-    uint32_t last_acked_seq = 0; // last cumulatively acked byte
-    uint32_t dup_ack_count = 0;
-    bool in_fast_recovery = false; // Fast Recovery 상태 추적
-    double timer_start_ms = -1.0;
-    uint32_t total_retransmits = 0;
-    uint32_t timeout_count = 0;
-    uint32_t dup_ack_retransmits = 0;
     double start_time = now_ms();
+    for (int i = 0; i < n; i++) {
+        if (pthread_create(&senders[i].thread, NULL, sender_thread, &senders[i]) != 0) die("pthread_create");
+    }
+    for (int i = 0; i < n; i++) pthread_join(senders[i].thread, NULL);
+    double elapsed = (now_ms() - start_time) / 1000.0;
 
-    // Main loop
-    while (base_idx < seg_cnt) {
-        // Send as much as allowed by cwnd (바이트 단위)
-        uint32_t outstanding_bytes = 0;
-        for (uint32_t i = base_idx; i < next_idx && i < seg_cnt; i++) {
-            outstanding_bytes += segments[i].len;
-        }
-        while (outstanding_bytes < (uint32_t)cwnd && next_idx < seg_cnt) {
-            if (!segments[next_idx].sent) {
-                // normal send
-                send_segment(next_idx, segments, sockfd, &peer, false, timer_start_ms >= 0.0);
-            }
-            if (timer_start_ms < 0.0) timer_start_ms = now_ms();
-            outstanding_bytes += segments[next_idx].len;
-            next_idx++;
-        }
+    printf("----------------------------------------\n");
+    printf("전송 완료! 모든 흐름에 FIN 전송\n");
+    printf("\n=== 전송 통계 ===\n");
+    uint64_t tx_packets = 0, tx_syscalls = 0, rx_packets = 0, rx_syscalls = 0, retx_bytes = 0, loop_syscalls = 0;
+    uint32_t retransmits = 0, timeouts = 0, fins_unacked = 0;
+    uint32_t digest = 0;
+    bool digested = true;
+    for (int i = 0; i < n; i++) {
+        const sender_t *s = &senders[i];
+        const flow_t *f = &s->flow;
+        printf("흐름 %d: %" PRIu64 " 바이트, MSS %d, %.2f 초, %.2f MB/s, 재전송 %u회 (타임아웃 %u), srtt %.3f ms, 최종 cwnd %.0f\n",
+               i, f->in.size, f->mss, s->elapsed, s->elapsed > 0.0 ? (double)f->in.size / s->elapsed / 1024.0 / 1024.0 : 0.0,
+               f->total_retransmits, f->timeout_count, (double)f->rtt.srtt_ns / 1e6, f->cc.cwnd);
+        tx_packets += s->tx.packets;
+        tx_syscalls += s->tx.syscalls;
+        rx_packets += s->rx.packets;
+        rx_syscalls += s->rx.syscalls;
+        loop_syscalls += s->loop.wakeups + s->loop.timer_syscalls;
+        retx_bytes += f->retransmitted_bytes;
+        retransmits += f->total_retransmits;
+        timeouts += f->timeout_count;
+        if (!f->fin_acked) fins_unacked++;
+        // Stripes are consecutive, so their CRCs chain into the file's
+        digested = digested && f->use_digest && f->digest_pos == f->in.size;
+        digest = crc32c_combine(digest, f->digest, f->in.size);
+    }
+    printf("전송된 데이터: %" PRIu64 " 바이트 (%.2f KB)\n", in->size, (double)in->size / 1024.0);
+    printf("전송 시간: %.3f 초\n", elapsed);
+    printf("전체 처리량: %.2f MB/s (흐름 %d개)\n", (double)in->size / elapsed / 1024.0 / 1024.0, n);
+    printf("총 재전송 횟수: %u (타임아웃 %u), 재전송 바이트 %" PRIu64 "\n", retransmits, timeouts, retx_bytes);
+    if (digested) printf("파일 다이제스트 (CRC32C): %08x\n", digest);
+    if (fins_unacked > 0) printf("경고: 흐름 %u개의 FIN이 확인되지 않았습니다\n", fins_unacked);
+    print_batch_stats(tx_packets, tx_syscalls, rx_packets, rx_syscalls);
+    print_syscalls(tx_syscalls + rx_syscalls + loop_syscalls, in->size);
+    print_rusage();
+    printf("==================\n");
+    for (int i = 0; i < n; i++) sender_free(&senders[i]);
+    free(senders);
+}
 
-        // Wait for ACKs or timeout
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(sockfd, &rfds);
-
-        struct timeval tv;
-        int wait_ms = rto_ms;
-        if (timer_start_ms >= 0.0) {
-            double elapsed = now_ms() - timer_start_ms;
-            if (elapsed >= (double)rto_ms) {
-                wait_ms = 0; // trigger timeout immediately
-            } else {
-                wait_ms = (int)((double)rto_ms - elapsed);
-            }
-        }
-        tv.tv_sec = wait_ms / 1000;
-        tv.tv_usec = (wait_ms % 1000) * 1000;
-
-        int ready = select(sockfd + 1, &rfds, NULL, NULL, &tv);
-        if (ready < 0) {
-            if (errno == EINTR) continue;
-            die("select");
-        } else if (ready == 0) {
-            // timeout -> loss detected
-            timeout_count++;
-            total_retransmits++;
-            printf("<<<타임아웃 사건 발생>>>\n");
-            // 현재 cwnd의 절반을 ssthresh로 설정
-            ssthresh = cwnd / 2.0;
-            if (ssthresh < (double)mss) ssthresh = (double)mss;
-            cwnd = (double)mss; // 1 MSS로 초기화
-            // Slow Start로 시작하기 위해 ssthresh가 cwnd보다 크도록 보장
-            if (ssthresh <= (double)mss) ssthresh = (double)mss * 2.0;
-            in_fast_recovery = false;
-            printf("- cwin: %.0f 바이트 (1 MSS)로 조정\n", cwnd);
-            printf("- 임계값: %.0f 바이트로 설정\n", ssthresh);
-            // retransmit the oldest unacked segment
-            if (base_idx < seg_cnt) {
-                segments[base_idx].sent = false; // mark for resend
-                send_segment(base_idx, segments, sockfd, &peer, true, false);
-            }
-            next_idx = base_idx + 1;
-            // cwnd 크기만큼만 재전송 표시
-            uint32_t resend_bytes = 0;
-            for (uint32_t i = base_idx + 1; i < seg_cnt && resend_bytes < (uint32_t)cwnd; ++i) {
-                segments[i].sent = false; // mark for resend
-                resend_bytes += segments[i].len;
-            }
-            timer_start_ms = now_ms();
-            dup_ack_count = 0;
-            continue;
-        }
+// Long-only options
+enum {
+    OPT_NO_DIGEST = 256,
+    OPT_FEC_K,
+    OPT_FEC_KEEP_CWND,
+    OPT_NO_RACK,
+    OPT_SERIES,
+    OPT_STATS,
+    OPT_SAMPLE_MS,
+};
 
-        if (FD_ISSET(sockfd, &rfds)) {
-            ack_packet_t ack;
-            ssize_t n = recv(sockfd, &ack, sizeof(ack), 0);
-            if (n < 0) die("recv ack");
-            if ((size_t)n < sizeof(ack)) continue;
-            uint32_t ack_seq = ntohl(ack.ack);
-
-            if (ack_seq > last_acked_seq) {
-                // New ACK
-                uint32_t old_acked_seq = last_acked_seq;
-                last_acked_seq = ack_seq;
-                
-                // Mark segments acked
-                uint32_t old_base = base_idx;
-                while (base_idx < seg_cnt) {
-                    uint32_t seg_end = segments[base_idx].seq + segments[base_idx].len;
-                    if (seg_end <= ack_seq) {
-                        segments[base_idx].acked = true;
-                        base_idx++;
-                    } else {
-                        break;
-                    }
-                }
-
-                // Advance congestion window (바이트 단위)
-                double old_cwnd = cwnd;
-                uint32_t acked_packets = base_idx - old_base;
-                
-                if (in_fast_recovery) {
-                    // Fast Recovery 종료: 새로운 ACK를 받으면 inflight를 고려하여 cwnd 조정
-                    // inflight를 계산하여 cwnd를 적절히 조정 (안 채워진 부분을 채워서 비슷한 단위로 유지)
-                    uint32_t inflight_bytes = 0;
-                    for (uint32_t i = base_idx; i < next_idx && i < seg_cnt; i++) {
-                        if (!segments[i].acked) {
-                            inflight_bytes += segments[i].len;
-                        }
-                    }
-                    // Fast Recovery 종료 시: cwnd = max(ssthresh, inflight + 3*MSS)
-                    // inflight를 고려하여 cwnd를 조정 (다음 데이터 전송 시 자연스럽게 MSS 단위로 맞춰짐)
-                    double new_cwnd = (inflight_bytes > 0) ? (double)inflight_bytes + 3.0 * (double)mss : ssthresh;
-                    if (new_cwnd < ssthresh) {
-                        new_cwnd = ssthresh;
-                    }
-                    cwnd = new_cwnd;
-                    in_fast_recovery = false;
-                    dup_ack_count = 0;
-                    // Fast Recovery 종료 후 바로 Congestion Avoidance 적용
-                    // cwnd >= ssthresh이므로 Congestion Avoidance
-                    double before_ca = cwnd;
-                    cwnd += (double)mss * ((double)mss / cwnd) * (double)acked_packets;
-                    double cwnd_increase = cwnd - before_ca; // Congestion Avoidance로 인한 증가량만 표시
-                    printf("<--- ACK %u 수신 (Fast Recovery 종료) => cwin %.0f 바이트 증가(%.0f 바이트, Congestion Avoidance)\n", ack_seq, cwnd_increase, cwnd);
-                } else {
-                    // Normal congestion control
-                    if (cwnd < ssthresh) {
-                        // Slow Start: ACK당 +MSS (지수적 증가)
-                        // 각 ACK에 대해 cwnd = cwnd + MSS
-                        cwnd += (double)mss * (double)acked_packets;
-                    } else {
-                        // Congestion Avoidance: ACK당 +MSS × (MSS / cwnd) (선형 증가)
-                        // 각 ACK에 대해 cwnd = cwnd + MSS × (MSS / cwnd)
-                        cwnd += (double)mss * ((double)mss / cwnd) * (double)acked_packets;
-                    }
-                    double cwnd_increase = cwnd - old_cwnd;
-                    printf("<--- ACK %u 수신 => cwin %.0f 바이트 증가(%.0f 바이트)\n", ack_seq, cwnd_increase, cwnd);
-                }
-
-                // If all outstanding acked, stop timer
-                if (base_idx == next_idx) {
-                    timer_start_ms = -1.0;
-                } else {
-                    timer_start_ms = now_ms();
-                }
-            } else if (ack_seq == last_acked_seq) {
-                // Duplicate ACK
-                dup_ack_count++;
-                printf("<--- ACK %u 수신 (중복 #%u)\n", ack_seq, dup_ack_count);
-                
-                if (in_fast_recovery) {
-                    // Fast Recovery 중: 중복 ACK를 받을 때마다 cwnd += MSS (새 세그먼트 전송 허용)
-                    cwnd += (double)mss;
-                    printf("  => Fast Recovery: cwin %.0f 바이트로 증가\n", cwnd);
-                } else if (dup_ack_count >= 3 && base_idx < seg_cnt) {
-                    // Fast Retransmit: 3중복 ACK를 받으면
-                    dup_ack_retransmits++;
-                    total_retransmits++;
-                    printf("<<< 3-Dup ACK 사건 발생>>>\n");
-                    // 현재 cwnd의 절반을 ssthresh로 설정
-                    ssthresh = cwnd / 2.0;
-                    if (ssthresh < (double)mss) ssthresh = (double)mss;
-                    // Fast Recovery: cwnd = ssthresh + 3 * MSS (이미 받은 중복 ACK 3개)
-                    cwnd = ssthresh + 3.0 * (double)mss;
-                    // ssthresh가 cwnd보다 작도록 보장 (Fast Recovery 후 Congestion Avoidance로 전환)
-                    if (ssthresh >= cwnd) ssthresh = cwnd - (double)mss;
-                    in_fast_recovery = true;
-                    printf("- cwin: ½ + 3×MSS = %.0f 바이트\n", cwnd);
-                    printf("- 임계값: %.0f 바이트로 설정\n", ssthresh);
-                    // Retransmit oldest unacked
-                    segments[base_idx].sent = false;
-                    send_segment(base_idx, segments, sockfd, &peer, true, false);
-                    next_idx = base_idx + 1;
-                    timer_start_ms = now_ms();
-                    dup_ack_count = 0; // Fast Recovery 시작 후 리셋
-                }
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-b 배치크기] [-g] [-N] [--no-rack] [-c 알고리즘] [-p] [-R ms] [-a ACK빈도] [-j 흐름수] [-P] [-C] [--no-digest] [-F] [--fec-k N] [--fec-keep-cwnd] [--series 파일] [--stats 파일] [--sample-ms N] [--quiet | --trace 파일] <수신자_IP> <수신자_포트> <입력파일> <MSS_바이트> [초기_RTO_밀리초]\n", prog);
+    fprintf(stderr, "예시: %s 127.0.0.1 9000 input.bin 1000 200\n", prog);
+    fprintf(stderr, "  -b N  sendmmsg/recvmmsg 한 번에 처리할 최대 패킷 수 (기본 %d, 최대 %d)\n", BATCH_DEFAULT, BATCH_MAX);
+    fprintf(stderr, "  -g    UDP GSO(UDP_SEGMENT) 사용: 같은 크기 세그먼트를 한 번에 커널에 전달 (Linux)\n");
+    fprintf(stderr, "  -N    SACK 기반 복구를 끄고 누적 ACK만 사용 (기존 Reno go-back-N 동작)\n");
+    fprintf(stderr, "  --no-rack         RACK-TLP 대신 3-Dup ACK/SACK 개수 규칙으로 손실 판정, 꼬리 손실 프로브 없음\n");
+    fprintf(stderr, "  -c 이름  혼잡 제어 알고리즘 선택:\n");
+    for (const cc_ops_t *const *ops = cc_algorithms; *ops; ops++) {
+        fprintf(stderr, "           %-8s %s\n", (*ops)->name, (*ops)->desc);
+    }
+    fprintf(stderr, "  -R ms 최소 RTO (기본 %d 밀리초). RTO는 RFC 6298에 따라 측정한 RTT로 계산\n", RTT_MIN_RTO_MS_DEFAULT);
+    fprintf(stderr, "  -p    윈도우 기반 알고리즘도 cwnd/srtt 속도로 페이싱\n");
+    fprintf(stderr, "  -a N  수신측에 요청할 ACK 빈도: 전체 크기 세그먼트 N개마다 ACK (기본 %d, 최대 %d, 1이면 매 패킷)\n",
+            FLOW_ACK_FREQ_DEFAULT, ACK_FREQ_MAX);
+    fprintf(stderr, "  -P    경로 MTU 탐색(DPLPMTUD)을 하지 않고 협상한 MSS를 그대로 사용\n");
+    fprintf(stderr, "  -j N  파일을 N개 구간으로 나눠 흐름(소켓, 혼잡 제어, 스레드)마다 따로 전송 (최대 %d)\n", MAX_STRIPES);
+    fprintf(stderr, "  -C, --checksum    패킷마다 CRC32C 체크섬을 붙임: 손상된 패킷은 수신측이 손실로 처리 (%s)\n", crc32c_impl());
+    fprintf(stderr, "  --no-digest       FIN에 파일 다이제스트(CRC32C)를 싣지 않음 (수신측 파일 검증 안 함)\n");
+    fprintf(stderr, "  -F, --fec         XOR 패리티 FEC: 블록마다 패리티 1개를 보내 수신측이 블록당 손실 1개를 재전송 없이 복구\n");
+    fprintf(stderr, "                    블록 크기는 측정한 손실률에 맞춰 %d ~ %d 세그먼트 사이에서 조정\n", FEC_K_MIN, FEC_K_MAX);
+    fprintf(stderr, "  --fec-k N         FEC 블록 크기를 N 세그먼트로 고정 (2의 거듭제곱으로 내림, -F 포함)\n");
+    fprintf(stderr, "  --fec-keep-cwnd   패리티로 복구된 손실에는 윈도우를 줄이지 않음 (혼잡이 아닌 무작위 손실 경로용, -F 포함)\n");
+    fprintf(stderr, "  -q, --quiet       패킷별 로그를 출력하지 않음 (통계만)\n");
+    fprintf(stderr, "  -t, --trace 파일  패킷별 이벤트를 바이너리 트레이스 파일에 기록 (trace_dump로 해독, -j면 파일.0 ~ 파일.N-1)\n");
+    fprintf(stderr, "  --series 파일     cwnd, ssthresh, 전송 중 바이트, RTT, 복구 상태를 일정 간격으로 기록 (.csv면 CSV, 아니면 바이너리)\n");
+    fprintf(stderr, "  --stats 파일      전송 중 다른 프로세스가 읽을 수 있는 공유 메모리 통계 (예: /dev/shm/udp_tx, telemetry_dump로 조회)\n");
+    fprintf(stderr, "  --sample-ms N     시계열·통계 갱신 간격 (기본 %d 밀리초)\n", TELEM_INTERVAL_DEFAULT_MS);
+}
+
+int main(int argc, char **argv) {
+    static tx_config_t cfg;
+    cfg.batch_size = BATCH_DEFAULT;
+    cfg.trace_mode = TRACE_TEXT;
+    cfg.sample_ns = TELEM_INTERVAL_DEFAULT_MS * 1000000ull;
+    bool use_sack = true;
+    bool use_rack = true;
+    bool use_pacing = false;
+    const cc_ops_t *cc_ops = &cc_reno;
+    int min_rto_ms = RTT_MIN_RTO_MS_DEFAULT;
+    int nflows = 1;
+    int ack_freq = FLOW_ACK_FREQ_DEFAULT;
+    cfg.probe_mtu = true;
+    bool use_digest = true;
+    static const struct option long_opts[] = {
+        {"quiet", no_argument, NULL, 'q'},
+        {"trace", required_argument, NULL, 't'},
+        {"checksum", no_argument, NULL, 'C'},
+        {"no-digest", no_argument, NULL, OPT_NO_DIGEST},
+        {"fec", no_argument, NULL, 'F'},
+        {"fec-k", required_argument, NULL, OPT_FEC_K},
+        {"fec-keep-cwnd", no_argument, NULL, OPT_FEC_KEEP_CWND},
+        {"no-rack", no_argument, NULL, OPT_NO_RACK},
+        {"series", required_argument, NULL, OPT_SERIES},
+        {"stats", required_argument, NULL, OPT_STATS},
+        {"sample-ms", required_argument, NULL, OPT_SAMPLE_MS},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:gNc:pR:a:j:PCFqt:", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            cfg.batch_size = atoi(optarg);
+            if (cfg.batch_size < 1) cfg.batch_size = 1;
+            if (cfg.batch_size > BATCH_MAX) cfg.batch_size = BATCH_MAX;
+            break;
+        case 'g':
+            cfg.use_gso = true;
+            break;
+        case 'N':
+            use_sack = false;
+            break;
+        case 'c':
+            cc_ops = cc_find(optarg);
+            if (!cc_ops) {
+                fprintf(stderr, "오류: 알 수 없는 혼잡 제어 알고리즘: %s\n", optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
             }
+            break;
+        case 'p':
+            use_pacing = true;
+            break;
+        case 'R':
+            min_rto_ms = atoi(optarg);
+            if (min_rto_ms < 1) min_rto_ms = 1;
+            break;
+        case 'a':
+            ack_freq = atoi(optarg);
+            if (ack_freq < 1) ack_freq = 1;
+            if (ack_freq > ACK_FREQ_MAX) ack_freq = ACK_FREQ_MAX;
+            break;
+        case 'j':
+            nflows = atoi(optarg);
+            if (nflows < 1) nflows = 1;
+            if (nflows > MAX_STRIPES) nflows = MAX_STRIPES;
+            break;
+        case 'P':
+            cfg.probe_mtu = false;
+            break;
+        case 'C':
+            cfg.checksum = true;
+            break;
+        case OPT_NO_DIGEST:
+            use_digest = false;
+            break;
+        case 'F':
+            cfg.flow.fec = true;
+            break;
+        case OPT_FEC_K:
+            cfg.flow.fec = true;
+            cfg.flow.fec_k = (uint32_t)atoi(optarg);
+            if (cfg.flow.fec_k < FEC_K_MIN) cfg.flow.fec_k = FEC_K_MIN;
+            if (cfg.flow.fec_k > FEC_K_MAX) cfg.flow.fec_k = FEC_K_MAX;
+            break;
+        case OPT_FEC_KEEP_CWND:
+            cfg.flow.fec = true;
+            cfg.flow.fec_keep_cwnd = true;
+            break;
+        case OPT_NO_RACK:
+            use_rack = false;
+            break;
+        case OPT_SERIES:
+            cfg.series_path = optarg;
+            break;
+        case OPT_STATS:
+            cfg.stats_path = optarg;
+            break;
+        case OPT_SAMPLE_MS:
+            cfg.sample_ns = strtoull(optarg, NULL, 10) * 1000000ull;
+            if (cfg.sample_ns == 0) cfg.sample_ns = 1000000ull;
+            break;
+        case 'q':
+            cfg.trace_mode = TRACE_OFF;
+            break;
+        case 't':
+            cfg.trace_mode = TRACE_FILE;
+            cfg.trace_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
         }
     }
+    int nargs = argc - optind;
+    if (nargs < 4 || nargs > 5) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    char **args = argv + optind;
+
+    const char *receiver_ip = args[0];
+    int receiver_port = atoi(args[1]);
+    const char *input_path = args[2];
+    int mss = atoi(args[3]);
+    if (mss <= 0 || mss > MAX_PAYLOAD) mss = MAX_PAYLOAD;
+    // Initial RTO, used until the first RTT sample arrives
+    int rto_ms = (nargs == 5) ? atoi(args[4]) : 200;
+    if (rto_ms < min_rto_ms) rto_ms = min_rto_ms;
+
+    printf("=== 송신 프로그램 시작 ===\n");
+    printf("수신자: %s:%d\n", receiver_ip, receiver_port);
+    printf("입력 파일: %s\n", input_path);
+    printf("MSS 상한: %d 바이트 (핸드셰이크%s로 결정)\n", mss, cfg.probe_mtu ? "와 경로 MTU 탐색으" : "");
+    printf("RTO: 초기 %d 밀리초, 최소 %d 밀리초 (RTT 측정으로 조정)\n", rto_ms, min_rto_ms);
+    printf("배치 크기: %d 패킷\n", cfg.batch_size);
+    printf("SACK: %s, 손실 판정: %s\n", use_sack ? "사용" : "사용 안 함",
+           use_sack && use_rack ? "RACK-TLP" : use_sack ? "SACK 개수 (RFC 6675)" : "3-Dup ACK");
+    printf("ACK 빈도 요청: 세그먼트 %d개마다\n", ack_freq);
+    printf("혼잡 제어: %s%s\n", cc_ops->name, use_pacing && !cc_ops->pacing_rate ? " (페이싱)" : "");
+    if (cfg.checksum || use_digest) printf("CRC32C 구현: %s\n", crc32c_impl());
+    printf("파일 매핑 중...\n");
+
+    int in_fd = open(input_path, O_RDONLY);
+    if (in_fd < 0) {
+        fprintf(stderr, "오류: 입력 파일을 열 수 없습니다: %s\n", input_path);
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(in_fd, &st) < 0) die("fstat");
+
+    // Map the file instead of preloading it; only window metadata lives in memory
+    input_map_t in = {0};
+    in.size = (uint64_t)st.st_size;
+    in.mapped = true;
+    if (in.size > 0) {
+        void *map = mmap(NULL, (size_t)in.size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+        if (map == MAP_FAILED) die("mmap");
+        (void)madvise(map, (size_t)in.size, MADV_SEQUENTIAL);
+        in.data = (const uint8_t *)map;
+    }
+    close(in_fd);
+    uint64_t seq_cursor = in.size;
+    printf("파일 매핑 완료: %" PRIu64 " 바이트\n", seq_cursor);
+    printf("소켓 설정 중...\n");
+
+    cfg.peer.sin_family = AF_INET;
+    cfg.peer.sin_port = htons((uint16_t)receiver_port);
+    if (inet_pton(AF_INET, receiver_ip, &cfg.peer.sin_addr) != 1) {
+        fprintf(stderr, "오류: 잘못된 IP 주소: %s\n", receiver_ip);
+        exit(EXIT_FAILURE);
+    }
+
+    // Congestion control state - 바이트 단위
+    cfg.flow.mss = (uint32_t)mss;
+    cfg.flow.initial_rto_ns = (uint64_t)rto_ms * 1000000ull;
+    cfg.flow.min_rto_ns = (uint64_t)min_rto_ms * 1000000ull;
+    cfg.flow.cc = cc_ops;
+    cfg.flow.sack = use_sack;
+    cfg.flow.rack = use_rack;
+    cfg.flow.pacing = use_pacing;
+    cfg.flow.ack_freq = (uint32_t)ack_freq;
+    cfg.flow.digest = use_digest;
+
+    if (nflows > 1) {
+        run_striped(&cfg, &in, nflows);
+        if (in.data) munmap((void *)in.data, (size_t)in.size);
+        return 0;
+    }
 
-    // Send FIN and wait a bit for final ACK
+    static sender_t sender;
+    sender_t *s = &sender;
+    syn_t syn = {
+        .stripes = htons(1),
+        .size = htobe64(in.size),
+    };
+    sender_init(s, &cfg, &in, &syn);
+    s->syn.xfer_id = htonl(s->conn_id);
+    flow_t *f = &s->flow;
+    printf("연결 ID: %08x\n", s->conn_id);
+
+    if (cfg.trace_mode == TRACE_FILE) {
+        if (trace_open_file(&s->trace, cfg.trace_path, TRACE_DEFAULT_RECORDS) < 0) die("trace");
+        printf("트레이스 파일: %s\n", cfg.trace_path);
+    } else {
+        trace_init(&s->trace, cfg.trace_mode);
+    }
+    sender_open_telemetry(s, -1);
+    if (cfg.series_path) printf("시계열 파일: %s (%.1f 밀리초 간격)\n", cfg.series_path, (double)cfg.sample_ns / 1e6);
+    if (cfg.stats_path) printf("통계 엔드포인트: %s\n", cfg.stats_path);
+    printf("전송 시작!\n");
     printf("----------------------------------------\n");
-    printf("전송 완료! FIN 패킷 전송 중...\n");
-    send_fin_packet(seq_cursor, sockfd, &peer);
-    struct timeval tv2 = { .tv_sec = 0, .tv_usec = 200 * 1000 };
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv2, sizeof(tv2));
-    ack_packet_t dummy;
-    (void)recv(sockfd, &dummy, sizeof(dummy), 0);
 
-    double elapsed = (now_ms() - start_time) / 1000.0;
+    sender_run(s);
+
+    double elapsed = s->elapsed;
     double throughput = (double)seq_cursor / elapsed / 1024.0 / 1024.0; // MB/s
+    uint64_t seg_cnt = (seq_cursor + (uint64_t)f->mss - 1) / (uint64_t)f->mss;
 
     printf("\n=== 전송 통계 ===\n");
-    printf("전송된 데이터: %u 바이트 (%.2f KB)\n", seq_cursor, (double)seq_cursor / 1024.0);
-    printf("총 세그먼트 수: %zu\n", seg_cnt);
-    printf("전송 시간: %.2f 초\n", elapsed);
+    printf("전송된 데이터: %" PRIu64 " 바이트 (%.2f KB)\n", seq_cursor, (double)seq_cursor / 1024.0);
+    printf("총 세그먼트 수: %" PRIu64 "\n", seg_cnt);
+    printf("전송 시간: %.3f 초\n", elapsed);
     printf("처리량: %.2f MB/s\n", throughput);
-    printf("타임아웃 횟수: %u\n", timeout_count);
-    printf("중복 ACK 재전송: %u\n", dup_ack_retransmits);
-    printf("총 재전송 횟수: %u\n", total_retransmits);
-    printf("최종 cwnd: %.0f 바이트\n", cwnd);
-    printf("최종 ssthresh: %.0f 바이트\n", ssthresh);
+    flow_print_stats(f, stdout);
+    print_batch_stats(s->tx.packets, s->tx.syscalls, s->rx.packets, s->rx.syscalls);
+    printf("이벤트 루프 깨어남: %" PRIu64 "회 (타이머 설정 시스템 콜 %" PRIu64 "회)\n", s->loop.wakeups,
+           s->loop.timer_syscalls);
+    print_syscalls(s->tx.syscalls + s->rx.syscalls + s->loop.wakeups + s->loop.timer_syscalls, seq_cursor);
+    print_rusage();
+    if (f->trace.mode == TRACE_FILE) {
+        printf("트레이스 이벤트: %" PRIu64 "개\n", f->trace.head);
+    }
+    if (s->series.file) printf("시계열 샘플: %" PRIu64 "개\n", s->series.written + s->series.rows);
     printf("==================\n");
 
-    close(sockfd);
-    free(segments);
+    sender_free(s);
+    if (in.data) munmap((void *)in.data, (size_t)in.size);
     return 0;
 }
-
-
@@ -0,0 +1,598 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cc.h"
+#include "eventq.h"
+#include "flow.h"
+#include "netem.h"
+#include "protocol.h"
+#include "rng.h"
+#include "rxconn.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// Discrete-event simulation of one transfer: the sender (flow_t) and the
+// receiver (rxconn_t) state machines that the UDP programs use, connected
+// by two emulated links (netem.c, the same model the receiver can run)
+// and driven by a virtual clock. No sockets, no
+// timers, no sleeping; the same seed gives the same run bit for bit.
+
+#define SIM_EPOCH_NS 1000000000ull         // virtual clock start (0 means "unset" to the flow)
+#define SIM_CONN_ID 1
+#define SIM_SLOT_SIZE 64                   // packets cross the links as headers only
+#define SIM_MAX_TIME_NS (3600ull * 1000000000ull)
+#define SIM_DEFAULT_RATE_MBPS 100
+#define SIM_DEFAULT_DELAY_MS 10
+#define SIM_DEFAULT_LIMIT 100
+
+enum {
+    EV_FWD = 1,         // sender -> receiver link has work; tag: generation
+    EV_REV,             // receiver -> sender link
+    EV_RTO,
+    EV_PACE,
+    EV_ACK_DELAY,       // receiver's delayed ACK timer; tag: generation
+    EV_PERSIST,
+    EV_APP,             // receiving application drained some backlog
+};
+
+typedef struct {
+    netem_t em;
+    int kind;
+    uint64_t armed_ns;  // pending wakeup, 0 when none
+    uint64_t gen;
+} sim_link_t;
+
+typedef struct {
+    uint64_t now_ns;
+    eventq_t q;
+    rng_t rng;
+    sim_link_t fwd;     // sender -> receiver
+    sim_link_t rev;     // receiver -> sender
+    flow_t flow;
+    rxconn_t rx;
+    uint64_t timer_gen[3];
+    uint64_t ack_timer_gen;
+
+    // Receiving application (-B): delivered bytes queue up and drain at
+    // app_rate, so the receive window closes when it falls behind
+    double app_rate;        // bytes/s
+    double app_backlog;     // as of app_ns
+    uint64_t app_ns;
+    uint64_t app_wake_ns;   // pending EV_APP, 0 when none
+    uint64_t app_max_backlog;
+    uint64_t events;
+    uint64_t digest;    // FNV-1a over the dispatched event sequence
+    uint32_t drop_fins; // --drop-fin: FINs the forward link still loses
+    uint32_t fins_dropped;
+    telem_series_t series;  // --series; file is NULL when off
+} sim_t;
+
+static void die(const char *msg) {
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+static double wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static void digest_u64(uint64_t *h, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        *h ^= (v >> (8 * i)) & 0xff;
+        *h *= 0x100000001b3ull;
+    }
+}
+
+static uint64_t io_now_ns(void *ctx) {
+    sim_t *s = ctx;
+    return s->now_ns;
+}
+
+// Keep one wakeup scheduled for the link's next departure or arrival
+static void link_schedule(sim_t *s, sim_link_t *l) {
+    uint64_t next = netem_next_ns(&l->em);
+    if (next == 0 || next == l->armed_ns) return;
+    l->gen++;
+    l->armed_ns = next;
+    if (eventq_push(&s->q, next, l->kind, l->gen, NULL, 0) < 0) die("eventq_push");
+}
+
+// Data packets carry only their header through the link; the payload
+// length still counts against the link rate and queue
+static void io_send(void *ctx, const void *hdr, size_t hlen, const uint8_t *payload, size_t plen) {
+    (void)payload;
+    sim_t *s = ctx;
+    const packet_header_t *h = hdr;
+    if ((h->flags & FLAG_FIN) && s->drop_fins > 0) {
+        s->drop_fins--;
+        s->fins_dropped++;
+        return;
+    }
+    netem_enqueue(&s->fwd.em, s->now_ns, NULL, 0, hdr, (uint32_t)hlen, (uint32_t)(hlen + plen + NETEM_WIRE_OVERHEAD));
+    link_schedule(s, &s->fwd);
+}
+
+static void io_flush(void *ctx) {
+    (void)ctx;
+}
+
+// Re-arming or disarming bumps the generation; stale expiries are skipped
+static void io_timer(void *ctx, int which, uint64_t deadline_ns) {
+    sim_t *s = ctx;
+    s->timer_gen[which]++;
+    if (deadline_ns == 0) return;
+    int kind = which == FLOW_TIMER_RTO ? EV_RTO : which == FLOW_TIMER_PACE ? EV_PACE : EV_PERSIST;
+    if (eventq_push(&s->q, deadline_ns, kind, s->timer_gen[which], NULL, 0) < 0) die("eventq_push");
+}
+
+static void rx_timer(void *ctx, uint64_t deadline_ns) {
+    sim_t *s = ctx;
+    s->ack_timer_gen++;
+    if (eventq_push(&s->q, deadline_ns, EV_ACK_DELAY, s->ack_timer_gen, NULL, 0) < 0) die("eventq_push");
+}
+
+static void app_drain(sim_t *s) {
+    s->app_backlog -= s->app_rate * (double)(s->now_ns - s->app_ns) / 1e9;
+    if (s->app_backlog < 0.0) s->app_backlog = 0.0;
+    s->app_ns = s->now_ns;
+}
+
+// Wake when the backlog has shrunk by half the receive window or emptied,
+// whichever comes first; rxconn decides whether that is worth an update
+static void app_schedule(sim_t *s) {
+    if (s->app_wake_ns != 0 || s->app_backlog <= 0.0) return;
+    uint64_t full = s->rx.rcv_buf < s->rx.reasm.window ? s->rx.rcv_buf : s->rx.reasm.window;
+    double step = s->app_backlog < (double)(full / 2) ? s->app_backlog : (double)(full / 2);
+    s->app_wake_ns = s->now_ns + (uint64_t)ceil(step * 1e9 / s->app_rate);
+    if (eventq_push(&s->q, s->app_wake_ns, EV_APP, 0, NULL, 0) < 0) die("eventq_push");
+}
+
+static void rx_deliver(void *ctx, const uint8_t *data, uint32_t len, uint64_t off) {
+    (void)data;
+    (void)off;
+    sim_t *s = ctx;
+    app_drain(s);
+    s->app_backlog += len;
+    if ((uint64_t)s->app_backlog > s->app_max_backlog) s->app_max_backlog = (uint64_t)s->app_backlog;
+    app_schedule(s);
+}
+
+static uint64_t rx_backlog(void *ctx) {
+    sim_t *s = ctx;
+    app_drain(s);
+    return (uint64_t)ceil(s->app_backlog);
+}
+
+static void io_send_ack(void *ctx, const void *ack, size_t len) {
+    sim_t *s = ctx;
+    netem_enqueue(&s->rev.em, s->now_ns, NULL, 0, ack, (uint32_t)len, (uint32_t)(len + NETEM_WIRE_OVERHEAD));
+    link_schedule(s, &s->rev);
+}
+
+static void deliver_data(void *ctx, const void *meta, uint32_t meta_len, const uint8_t *data, uint32_t len) {
+    (void)meta;
+    (void)meta_len;
+    (void)len;
+    sim_t *s = ctx;
+    packet_header_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    rxconn_on_segment(&s->rx, ntohl(hdr.seq), ntohl(hdr.len), hdr.flags, hdr.fec, NULL);
+}
+
+static void deliver_ack(void *ctx, const void *meta, uint32_t meta_len, const uint8_t *data, uint32_t len) {
+    (void)meta;
+    (void)meta_len;
+    sim_t *s = ctx;
+    flow_on_ack_packet(&s->flow, data, len);
+}
+
+// Nothing changes between events, so every sample due before the next one
+// is the current state: the series lands on the exact interval grid
+// without putting events of its own in the queue (or the digest)
+static void sample_until(sim_t *s, uint64_t t_ns) {
+    telem_series_t *ts = &s->series;
+    while (ts->next_ns <= t_ns) {
+        telem_row_t row;
+        flow_sample(&s->flow, &row);
+        row.t_ns = ts->next_ns - ts->start_ns;
+        telem_series_push(ts, &row);
+        ts->next_ns += ts->interval_ns;
+    }
+}
+
+static void dispatch(sim_t *s, const eventq_ev_t *ev) {
+    s->now_ns = ev->time_ns;
+    s->events++;
+    digest_u64(&s->digest, ev->time_ns);
+    digest_u64(&s->digest, ((uint64_t)ev->kind << 32) | ev->len);
+
+    flow_t *f = &s->flow;
+    switch (ev->kind) {
+    case EV_FWD:
+        if (ev->tag != s->fwd.gen) break;
+        s->fwd.armed_ns = 0;
+        netem_poll(&s->fwd.em, s->now_ns, deliver_data, s);
+        link_schedule(s, &s->fwd);
+        break;
+    case EV_REV:
+        if (ev->tag != s->rev.gen) break;
+        s->rev.armed_ns = 0;
+        // Every ACK due at this instant, then one pump, like a recvmmsg batch
+        if (netem_poll(&s->rev.em, s->now_ns, deliver_ack, s) > 0 && !f->done) flow_pump(f);
+        link_schedule(s, &s->rev);
+        break;
+    case EV_RTO:
+        if (ev->tag == s->timer_gen[FLOW_TIMER_RTO]) flow_on_rto(f);
+        break;
+    case EV_PACE:
+        if (ev->tag == s->timer_gen[FLOW_TIMER_PACE]) flow_on_pace(f);
+        break;
+    case EV_ACK_DELAY:
+        if (ev->tag == s->ack_timer_gen) rxconn_on_timer(&s->rx);
+        break;
+    case EV_PERSIST:
+        if (ev->tag == s->timer_gen[FLOW_TIMER_PERSIST]) flow_on_persist(f);
+        break;
+    case EV_APP:
+        s->app_wake_ns = 0;
+        rxconn_on_drain(&s->rx);
+        app_schedule(s);
+        break;
+    }
+}
+
+// Long-only options
+enum {
+    OPT_FEC_K = 256,
+    OPT_FEC_KEEP_CWND,
+    OPT_DROP_FIN,
+    OPT_NO_RACK,
+    OPT_SERIES,
+    OPT_SAMPLE_MS,
+};
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [옵션] <전송_크기_바이트>\n", prog);
+    fprintf(stderr, "예시: %s -r 100 -d 10 -l 0.01 -c cubic 10000000\n", prog);
+    fprintf(stderr, "  -s N  난수 시드 (기본 1). 같은 시드와 옵션이면 결과가 비트 단위로 동일\n");
+    fprintf(stderr, "  -c 이름  혼잡 제어 알고리즘 선택:\n");
+    for (const cc_ops_t *const *ops = cc_algorithms; *ops; ops++) {
+        fprintf(stderr, "           %-8s %s\n", (*ops)->name, (*ops)->desc);
+    }
+    fprintf(stderr, "  -N    SACK 기반 복구를 끄고 누적 ACK만 사용\n");
+    fprintf(stderr, "  --no-rack   RACK-TLP 대신 3-Dup ACK/SACK 개수 규칙으로 손실 판정, 꼬리 손실 프로브 없음\n");
+    fprintf(stderr, "  -p    윈도우 기반 알고리즘도 cwnd/srtt 속도로 페이싱\n");
+    fprintf(stderr, "  -m N  MSS (바이트, 기본 %d)\n", DEFAULT_PAYLOAD);
+    fprintf(stderr, "  -l P  정방향 무작위 손실 확률 0.0-1.0 (기본 0)\n");
+    fprintf(stderr, "  -I ms 초기 RTO (기본 200 밀리초)\n");
+    fprintf(stderr, "  -R ms 최소 RTO (기본 %d 밀리초)\n", RTT_MIN_RTO_MS_DEFAULT);
+    fprintf(stderr, "  -a N  송신측이 요청하는 ACK 빈도: 전체 크기 세그먼트 N개마다 ACK (기본 %d, 최대 %d, 1이면 매 패킷)\n",
+            FLOW_ACK_FREQ_DEFAULT, ACK_FREQ_MAX);
+    fprintf(stderr, "  -A us 수신측 지연 ACK 타이머 (기본 %llu 마이크로초)\n", RXCONN_ACK_DELAY_NS / 1000ull);
+    fprintf(stderr, "  -W N  수신측이 광고할 수신 윈도우의 상한 (바이트, 기본: 제한 없음)\n");
+    fprintf(stderr, "  -B N  수신 애플리케이션의 처리 속도 (Mbps, 기본: 즉시). 밀린 데이터만큼 수신 윈도우가 줄어듦\n");
+    fprintf(stderr, "  -F    XOR 패리티 FEC (블록 크기는 손실률에 맞춰 %d ~ %d 세그먼트), --fec-k N이면 N으로 고정\n", FEC_K_MIN, FEC_K_MAX);
+    fprintf(stderr, "  --fec-keep-cwnd  패리티로 복구된 손실에는 윈도우를 줄이지 않음 (-F 포함)\n");
+    fprintf(stderr, "  --drop-fin N  처음 N개의 FIN을 정방향 링크에서 잃음 (FIN 재전송 확인용)\n");
+    fprintf(stderr, "  -v    패킷별 로그 출력 (가상 시각 기준)\n");
+    fprintf(stderr, "  -t, --trace 파일  송신측 이벤트를 바이너리 트레이스 파일에 기록 (trace_dump -t로 해독)\n");
+    fprintf(stderr, "  --series 파일     cwnd, ssthresh, 전송 중 바이트, RTT, 복구 상태를 가상 시각 기준 일정 간격으로 기록 (.csv면 CSV)\n");
+    fprintf(stderr, "  --sample-ms N     시계열 간격 (기본 %d 밀리초)\n", TELEM_INTERVAL_DEFAULT_MS);
+    netem_usage(stderr);
+    fprintf(stderr, "  (시뮬레이션 기본값: -r %d -d %d -Q %d, 역방향 링크는 속도·지연·큐만 적용)\n",
+            SIM_DEFAULT_RATE_MBPS, SIM_DEFAULT_DELAY_MS, SIM_DEFAULT_LIMIT);
+    fprintf(stderr, "  (페이로드를 싣지 않으므로 -X 손상은 시뮬레이션하지 않음)\n");
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = 1;
+    const cc_ops_t *cc_ops = &cc_reno;
+    bool use_sack = true;
+    bool use_rack = true;
+    bool use_pacing = false;
+    int mss = DEFAULT_PAYLOAD;
+    netem_config_t link;
+    netem_config_default(&link);
+    link.rate_bps = SIM_DEFAULT_RATE_MBPS * 1000000ull;
+    link.delay_ns = SIM_DEFAULT_DELAY_MS * 1000000ull;
+    link.limit = SIM_DEFAULT_LIMIT;
+    link.slot_size = SIM_SLOT_SIZE;
+    int rto_ms = 200;
+    int min_rto_ms = RTT_MIN_RTO_MS_DEFAULT;
+    int ack_freq = FLOW_ACK_FREQ_DEFAULT;
+    uint64_t ack_delay_ns = RXCONN_ACK_DELAY_NS;
+    uint64_t rcv_buf = RXCONN_RCV_BUF_DEFAULT;
+    double app_mbps = 0.0;
+    int trace_mode = TRACE_OFF;
+    const char *trace_path = NULL;
+    bool use_fec = false;
+    uint32_t fec_k = 0;
+    bool fec_keep_cwnd = false;
+    uint32_t drop_fins = 0;
+    const char *series_path = NULL;
+    uint64_t sample_ns = TELEM_INTERVAL_DEFAULT_MS * 1000000ull;
+    static const struct option long_opts[] = {
+        {"trace", required_argument, NULL, 't'},
+        {"fec-k", required_argument, NULL, OPT_FEC_K},
+        {"fec-keep-cwnd", no_argument, NULL, OPT_FEC_KEEP_CWND},
+        {"drop-fin", required_argument, NULL, OPT_DROP_FIN},
+        {"no-rack", no_argument, NULL, OPT_NO_RACK},
+        {"series", required_argument, NULL, OPT_SERIES},
+        {"sample-ms", required_argument, NULL, OPT_SAMPLE_MS},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:c:Npm:l:I:R:a:A:W:B:Fvt:" NETEM_OPTSTRING, long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'c':
+            cc_ops = cc_find(optarg);
+            if (!cc_ops) {
+                fprintf(stderr, "오류: 알 수 없는 혼잡 제어 알고리즘: %s\n", optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'N':
+            use_sack = false;
+            break;
+        case OPT_NO_RACK:
+            use_rack = false;
+            break;
+        case OPT_SERIES:
+            series_path = optarg;
+            break;
+        case OPT_SAMPLE_MS:
+            sample_ns = strtoull(optarg, NULL, 10) * 1000000ull;
+            if (sample_ns == 0) sample_ns = 1000000ull;
+            break;
+        case 'p':
+            use_pacing = true;
+            break;
+        case 'm':
+            mss = atoi(optarg);
+            if (mss <= 0 || mss > MAX_PAYLOAD) mss = MAX_PAYLOAD;
+            break;
+        case 'l':
+            link.loss = atof(optarg);
+            if (link.loss < 0.0) link.loss = 0.0;
+            if (link.loss > 1.0) link.loss = 1.0;
+            break;
+        case 'I':
+            rto_ms = atoi(optarg);
+            break;
+        case 'R':
+            min_rto_ms = atoi(optarg);
+            if (min_rto_ms < 1) min_rto_ms = 1;
+            break;
+        case 'a':
+            ack_freq = atoi(optarg);
+            if (ack_freq < 1) ack_freq = 1;
+            if (ack_freq > ACK_FREQ_MAX) ack_freq = ACK_FREQ_MAX;
+            break;
+        case 'A':
+            ack_delay_ns = strtoull(optarg, NULL, 10) * 1000ull;
+            break;
+        case 'W':
+            rcv_buf = strtoull(optarg, NULL, 10);
+            break;
+        case 'B':
+            app_mbps = atof(optarg);
+            if (app_mbps < 0.0) app_mbps = 0.0;
+            break;
+        case 'F':
+            use_fec = true;
+            break;
+        case OPT_FEC_K:
+            use_fec = true;
+            fec_k = (uint32_t)atoi(optarg);
+            if (fec_k < FEC_K_MIN) fec_k = FEC_K_MIN;
+            if (fec_k > FEC_K_MAX) fec_k = FEC_K_MAX;
+            break;
+        case OPT_FEC_KEEP_CWND:
+            use_fec = true;
+            fec_keep_cwnd = true;
+            break;
+        case OPT_DROP_FIN:
+            drop_fins = (uint32_t)atoi(optarg);
+            break;
+        case 'v':
+            trace_mode = TRACE_TEXT;
+            break;
+        case 't':
+            trace_mode = TRACE_FILE;
+            trace_path = optarg;
+            break;
+        case 'r':
+        case 'd':
+        case 'Q':
+        case 'E':
+        case 'G':
+        case 'O':
+        case 'D':
+            if (netem_parse_opt(&link, opt, optarg) < 0) {
+                fprintf(stderr, "오류: 잘못된 링크 옵션: -%c %s\n", opt, optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'X':
+            // Checksums cover the payload, which never crosses these links
+            fprintf(stderr, "오류: 시뮬레이터는 헤더만 전달하므로 -X(패킷 손상)를 지원하지 않습니다\n");
+            return EXIT_FAILURE;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - optind != 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint64_t size = strtoull(argv[optind], NULL, 10);
+    if (rto_ms < min_rto_ms) rto_ms = min_rto_ms;
+    if (rcv_buf < (uint64_t)mss) rcv_buf = (uint64_t)mss;
+
+    printf("=== 시뮬레이션 시작 ===\n");
+    printf("시드: %" PRIu64 "\n", seed);
+    printf("전송 크기: %" PRIu64 " 바이트, MSS: %d 바이트\n", size, mss);
+    netem_describe(&link, stdout);
+    printf("SACK: %s, 손실 판정: %s\n", use_sack ? "사용" : "사용 안 함",
+           use_sack && use_rack ? "RACK-TLP" : use_sack ? "SACK 개수 (RFC 6675)" : "3-Dup ACK");
+    printf("ACK 빈도: 세그먼트 %d개마다 (지연 타이머 %.3f 밀리초)\n", ack_freq, (double)ack_delay_ns / 1e6);
+    printf("혼잡 제어: %s%s\n", cc_ops->name, use_pacing && !cc_ops->pacing_rate ? " (페이싱)" : "");
+    if (rcv_buf != RXCONN_RCV_BUF_DEFAULT) printf("수신 윈도우: 최대 %" PRIu64 " 바이트\n", rcv_buf);
+    if (app_mbps > 0.0) printf("수신 애플리케이션: %.1f Mbps\n", app_mbps);
+    if (use_fec && fec_k) {
+        printf("FEC: 고정 블록 (세그먼트 %u개 이하)%s\n", fec_k, fec_keep_cwnd ? ", 복구된 손실에 윈도우 유지" : "");
+    } else if (use_fec) {
+        printf("FEC: 손실률에 따라 블록 크기 조정 (%d ~ %d 세그먼트)%s\n", FEC_K_MIN, FEC_K_MAX,
+               fec_keep_cwnd ? ", 복구된 손실에 윈도우 유지" : "");
+    }
+
+    static sim_t sim;
+    sim_t *s = &sim;
+    s->now_ns = SIM_EPOCH_NS;
+    s->digest = 0xcbf29ce484222325ull;
+    rng_seed(&s->rng, seed);
+    if (eventq_init(&s->q, 1024) < 0) die("eventq_init");
+    // ACKs see the same rate, delay and queue but none of the impairments
+    netem_config_t rev = link;
+    rev.qdisc = NETEM_DROPTAIL;
+    rev.loss = 0.0;
+    rev.ge_p = 0.0;
+    rev.reorder = 0.0;
+    rev.dup = 0.0;
+    if (netem_init(&s->fwd.em, &link, &s->rng) < 0) die("netem_init");
+    if (netem_init(&s->rev.em, &rev, &s->rng) < 0) die("netem_init");
+    s->fwd.kind = EV_FWD;
+    s->rev.kind = EV_REV;
+
+    flow_config_t cfg = {0};
+    cfg.conn_id = SIM_CONN_ID;
+    cfg.mss = (uint32_t)mss;
+    cfg.initial_rto_ns = (uint64_t)rto_ms * 1000000ull;
+    cfg.min_rto_ns = (uint64_t)min_rto_ms * 1000000ull;
+    cfg.cc = cc_ops;
+    cfg.sack = use_sack;
+    cfg.rack = use_rack;
+    cfg.pacing = use_pacing;
+    cfg.ack_freq = (uint32_t)ack_freq;
+    cfg.fec = use_fec;
+    cfg.fec_k = fec_k;
+    cfg.fec_keep_cwnd = fec_keep_cwnd;
+    cfg.rwnd = UINT32_MAX;   // no handshake here; the first ACK sets it
+    flow_io_t fio = {
+        .ctx = s,
+        .now_ns = io_now_ns,
+        .send = io_send,
+        .flush = io_flush,
+        .timer = io_timer,
+    };
+    input_map_t in = {0};
+    in.size = size;
+    flow_t *f = &s->flow;
+    if (flow_init(f, &cfg, &fio, &in) < 0) die("flow_init");
+
+    rxconn_io_t rio = {
+        .ctx = s,
+        .now_ns = io_now_ns,
+        .send_ack = io_send_ack,
+        .deliver = app_mbps > 0.0 ? rx_deliver : NULL,
+        .timer = rx_timer,
+        .backlog = app_mbps > 0.0 ? rx_backlog : NULL,
+    };
+    // Window large enough for anything the sender can have outstanding
+    if (rxconn_init(&s->rx, &rio, size + 1, seed) < 0) die("rxconn_init");
+    s->rx.conn_id = SIM_CONN_ID;
+    s->rx.ack_delay_ns = ack_delay_ns;
+    s->rx.rcv_buf = rcv_buf;
+    s->app_rate = app_mbps * 1e6 / 8.0;
+    s->app_ns = s->now_ns;
+
+    if (trace_mode == TRACE_FILE) {
+        if (trace_open_file(&f->trace, trace_path, TRACE_DEFAULT_RECORDS) < 0) die("trace");
+        f->trace.hdr->start_ns = SIM_EPOCH_NS;
+        trace_init(&s->rx.trace, TRACE_OFF);
+        printf("트레이스 파일: %s\n", trace_path);
+    } else {
+        trace_init(&f->trace, trace_mode);
+        trace_init(&s->rx.trace, trace_mode);
+    }
+    if (series_path) {
+        if (telem_series_open(&s->series, series_path, telem_series_format(series_path), sample_ns, SIM_EPOCH_NS) < 0) die("telemetry series");
+        printf("시계열 파일: %s (가상 시각 %.1f 밀리초 간격)\n", series_path, (double)sample_ns / 1e6);
+    }
+    printf("----------------------------------------\n");
+
+    double wall_start = wall_ms();
+    eventq_ev_t ev;
+    flow_pump(f);
+    while (!f->done && eventq_pop(&s->q, &ev)) {
+        if (ev.time_ns - SIM_EPOCH_NS > SIM_MAX_TIME_NS) {
+            fprintf(stderr, "오류: 가상 시간 %llu초 안에 전송이 끝나지 않았습니다\n",
+                    (unsigned long long)(SIM_MAX_TIME_NS / 1000000000ull));
+            return EXIT_FAILURE;
+        }
+        if (s->series.file) sample_until(s, ev.time_ns);
+        dispatch(s, &ev);
+    }
+    uint64_t done_ns = s->now_ns;
+
+    // Like the real sender, resend the FIN on the RTO until it is confirmed
+    s->drop_fins = drop_fins;
+    if (f->done) flow_send_fin(f);
+    while (!f->closed && eventq_pop(&s->q, &ev)) {
+        if (s->series.file) sample_until(s, ev.time_ns);
+        dispatch(s, &ev);
+    }
+    double wall_elapsed = wall_ms() - wall_start;
+    uint64_t samples = s->series.written + s->series.rows;
+    if (s->series.file && telem_series_close(&s->series) < 0) {
+        fprintf(stderr, "경고: 시계열 파일을 끝까지 쓰지 못했습니다\n");
+    }
+
+    double sim_sec = (double)(done_ns - SIM_EPOCH_NS) / 1e9;
+    printf("----------------------------------------\n");
+    printf("\n=== 시뮬레이션 결과 ===\n");
+    printf("전송 완료: %s\n", f->done ? "예" : "아니오");
+    printf("가상 전송 시간: %.6f 초\n", sim_sec);
+    if (sim_sec > 0.0) {
+        printf("처리량: %.2f Mbps\n", (double)size * 8.0 / sim_sec / 1e6);
+    }
+    flow_print_stats(f, stdout);
+    netem_print_stats(&s->fwd.em, "정방향 링크", stdout);
+    netem_print_stats(&s->rev.em, "역방향 링크", stdout);
+    rxconn_print_stats(&s->rx, stdout);
+    if (s->app_rate > 0.0) printf("수신 애플리케이션 최대 대기: %" PRIu64 " 바이트\n", s->app_max_backlog);
+    printf("FIN 수신: %s\n", s->rx.fin_received ? "예" : "아니오");
+    if (s->fins_dropped > 0) printf("잃은 FIN (--drop-fin): %u개\n", s->fins_dropped);
+    printf("처리한 이벤트: %" PRIu64 "개 (최대 대기 %zu개)\n", s->events, s->q.max_count);
+    printf("이벤트 다이제스트: %016" PRIx64 "\n", s->digest);
+    printf("실제 실행 시간: %.2f 밀리초\n", wall_elapsed);
+    if (f->trace.mode == TRACE_FILE) {
+        printf("트레이스 이벤트: %" PRIu64 "개\n", f->trace.head);
+    }
+    if (series_path) printf("시계열 샘플: %" PRIu64 "개\n", samples);
+    printf("========================\n");
+
+    flow_free(f);
+    rxconn_free(&s->rx);
+    eventq_free(&s->q);
+    netem_free(&s->fwd.em);
+    netem_free(&s->rev.em);
+    return f->done ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,264 @@
+#define _GNU_SOURCE
+#include "telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TELEM_SERIES_COLUMNS 10
+#define TELEM_READ_TRIES 1000000   // a writer killed mid-update leaves seq odd for good
+
+
+// Every column is allocated once, up front; sampling never allocates
+static int series_alloc(telem_series_t *s) {
+    size_t n = TELEM_SERIES_ROWS;
+    s->t_ns = calloc(n, sizeof(*s->t_ns));
+    s->acked = calloc(n, sizeof(*s->acked));
+    s->cwnd = calloc(n, sizeof(*s->cwnd));
+    s->ssthresh = calloc(n, sizeof(*s->ssthresh));
+    s->inflight = calloc(n, sizeof(*s->inflight));
+    s->srtt_us = calloc(n, sizeof(*s->srtt_us));
+    s->rtt_us = calloc(n, sizeof(*s->rtt_us));
+    s->retransmits = calloc(n, sizeof(*s->retransmits));
+    s->timeouts = calloc(n, sizeof(*s->timeouts));
+    s->state = calloc(n, sizeof(*s->state));
+    if (!s->t_ns || !s->acked || !s->cwnd || !s->ssthresh || !s->inflight || !s->srtt_us || !s->rtt_us ||
+        !s->retransmits || !s->timeouts || !s->state) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static void series_free(telem_series_t *s) {
+    free(s->t_ns);
+    free(s->acked);
+    free(s->cwnd);
+    free(s->ssthresh);
+    free(s->inflight);
+    free(s->srtt_us);
+    free(s->rtt_us);
+    free(s->retransmits);
+    free(s->timeouts);
+    free(s->state);
+    s->t_ns = s->acked = NULL;
+    s->cwnd = s->ssthresh = s->inflight = s->srtt_us = s->rtt_us = s->retransmits = s->timeouts = NULL;
+    s->state = NULL;
+}
+
+int telem_series_format(const char *path) {
+    size_t n = strlen(path);
+    return n >= 4 && strcmp(path + n - 4, ".csv") == 0 ? TELEM_CSV : TELEM_BINARY;
+}
+
+int telem_series_open(telem_series_t *s, const char *path, int format, uint64_t interval_ns, uint64_t start_ns) {
+    memset(s, 0, sizeof(*s));
+    s->format = format;
+    s->start_ns = start_ns;
+    s->interval_ns = interval_ns;
+    s->next_ns = start_ns;
+    if (series_alloc(s) < 0) goto fail;
+    s->file = fopen(path, "w");
+    if (!s->file) goto fail;
+    if (s->format == TELEM_CSV) {
+        telem_csv_header(s->file);
+    } else {
+        telem_series_hdr_t hdr = {0};
+        memcpy(hdr.magic, TELEM_SERIES_MAGIC, sizeof(TELEM_SERIES_MAGIC));
+        hdr.version = TELEM_VERSION;
+        hdr.columns = TELEM_SERIES_COLUMNS;
+        hdr.interval_ns = interval_ns;
+        hdr.start_ns = start_ns;
+        fwrite(&hdr, sizeof(hdr), 1, s->file);
+    }
+    return ferror(s->file) ? -1 : 0;
+
+fail:
+    {
+        int err = errno;
+        series_free(s);
+        errno = err;
+    }
+    return -1;
+}
+
+int telem_series_flush(telem_series_t *s) {
+    uint32_t n = s->rows;
+    if (n == 0 || !s->file) return 0;
+    if (s->format == TELEM_CSV) {
+        telem_row_t row;
+        for (uint32_t i = 0; i < n; i++) {
+            telem_series_row(s, i, &row);
+            telem_csv_row(s->file, &row);
+        }
+    } else {
+        uint64_t rows = n;
+        fwrite(&rows, sizeof(rows), 1, s->file);
+        fwrite(s->t_ns, sizeof(*s->t_ns), n, s->file);
+        fwrite(s->acked, sizeof(*s->acked), n, s->file);
+        fwrite(s->cwnd, sizeof(*s->cwnd), n, s->file);
+        fwrite(s->ssthresh, sizeof(*s->ssthresh), n, s->file);
+        fwrite(s->inflight, sizeof(*s->inflight), n, s->file);
+        fwrite(s->srtt_us, sizeof(*s->srtt_us), n, s->file);
+        fwrite(s->rtt_us, sizeof(*s->rtt_us), n, s->file);
+        fwrite(s->retransmits, sizeof(*s->retransmits), n, s->file);
+        fwrite(s->timeouts, sizeof(*s->timeouts), n, s->file);
+        fwrite(s->state, sizeof(*s->state), n, s->file);
+    }
+    s->written += n;
+    s->rows = 0;
+    return ferror(s->file) ? -1 : 0;
+}
+
+int telem_series_close(telem_series_t *s) {
+    int rc = telem_series_flush(s);
+    if (s->file && fclose(s->file) != 0) rc = -1;
+    s->file = NULL;
+    series_free(s);
+    return rc;
+}
+
+int telem_series_load(telem_series_t *s, FILE *in) {
+    memset(s, 0, sizeof(*s));
+    telem_series_hdr_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, in) != 1 || memcmp(hdr.magic, TELEM_SERIES_MAGIC, sizeof(TELEM_SERIES_MAGIC)) != 0 ||
+        hdr.version != TELEM_VERSION || hdr.columns != TELEM_SERIES_COLUMNS) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (series_alloc(s) < 0) {
+        series_free(s);
+        return -1;
+    }
+    s->format = TELEM_BINARY;
+    s->interval_ns = hdr.interval_ns;
+    s->start_ns = hdr.start_ns;
+    return 0;
+}
+
+int telem_series_next(telem_series_t *s, FILE *in) {
+    uint64_t rows;
+    s->rows = 0;
+    if (fread(&rows, sizeof(rows), 1, in) != 1) return 0;
+    if (rows == 0 || rows > TELEM_SERIES_ROWS) return -1;
+    size_t n = (size_t)rows;
+    if (fread(s->t_ns, sizeof(*s->t_ns), n, in) != n || fread(s->acked, sizeof(*s->acked), n, in) != n ||
+        fread(s->cwnd, sizeof(*s->cwnd), n, in) != n || fread(s->ssthresh, sizeof(*s->ssthresh), n, in) != n ||
+        fread(s->inflight, sizeof(*s->inflight), n, in) != n || fread(s->srtt_us, sizeof(*s->srtt_us), n, in) != n ||
+        fread(s->rtt_us, sizeof(*s->rtt_us), n, in) != n || fread(s->retransmits, sizeof(*s->retransmits), n, in) != n ||
+        fread(s->timeouts, sizeof(*s->timeouts), n, in) != n || fread(s->state, sizeof(*s->state), n, in) != n) {
+        return -1;
+    }
+    s->rows = (uint32_t)n;
+    s->written += n;
+    return (int)n;
+}
+
+void telem_series_row(const telem_series_t *s, uint32_t i, telem_row_t *row) {
+    row->t_ns = s->t_ns[i];
+    row->acked = s->acked[i];
+    row->cwnd = s->cwnd[i];
+    row->ssthresh = s->ssthresh[i];
+    row->inflight = s->inflight[i];
+    row->srtt_us = s->srtt_us[i];
+    row->rtt_us = s->rtt_us[i];
+    row->retransmits = s->retransmits[i];
+    row->timeouts = s->timeouts[i];
+    row->state = s->state[i];
+}
+
+void telem_csv_header(FILE *out) {
+    fprintf(out, "t_ms,acked,cwnd,ssthresh,inflight,srtt_us,rtt_us,retransmits,timeouts,state\n");
+}
+
+void telem_csv_row(FILE *out, const telem_row_t *row) {
+    fprintf(out, "%.3f,%" PRIu64 ",%u,%u,%u,%u,%u,%u,%u,%s\n", (double)row->t_ns / 1e6, row->acked, row->cwnd,
+            row->ssthresh, row->inflight, row->srtt_us, row->rtt_us, row->retransmits, row->timeouts,
+            telem_state_name(row->state));
+}
+
+void telem_counters_add_rx(telem_counters_t *sum, const telem_counters_t *c) {
+    sum->bytes += c->bytes;
+    sum->flows += c->flows;
+    sum->total_packets += c->total_packets;
+    sum->dropped_packets += c->dropped_packets;
+    sum->out_of_order_packets += c->out_of_order_packets;
+    sum->duplicate_packets += c->duplicate_packets;
+    sum->corrupt_packets += c->corrupt_packets;
+    sum->fec_repaired += c->fec_repaired;
+    sum->acks_sent += c->acks_sent;
+    sum->adv_wnd += c->adv_wnd;
+}
+
+telem_stats_t *telem_stats_open(const char *path, uint32_t role, uint64_t start_ns) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)sizeof(telem_stats_t)) < 0) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(telem_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    telem_stats_t *st = map;
+    st->version = TELEM_VERSION;
+    st->size = sizeof(telem_stats_t);
+    st->role = role;
+    st->pid = (uint32_t)getpid();
+    st->start_ns = start_ns;
+    atomic_store_explicit(&st->seq, 0, memory_order_relaxed);
+    // The magic goes in last so a reader never sees a half-written header
+    atomic_thread_fence(memory_order_release);
+    memcpy(st->magic, TELEM_STATS_MAGIC, sizeof(TELEM_STATS_MAGIC));
+    return st;
+}
+
+void telem_stats_close(telem_stats_t *st) {
+    if (st) munmap(st, sizeof(*st));
+}
+
+const telem_stats_t *telem_stats_attach(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat sb;
+    if (fstat(fd, &sb) < 0) {
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)sb.st_size < sizeof(telem_stats_t)) {
+        close(fd);
+        errno = EPROTO;
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(telem_stats_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    const telem_stats_t *st = map;
+    if (memcmp(st->magic, TELEM_STATS_MAGIC, sizeof(TELEM_STATS_MAGIC)) != 0 || st->version != TELEM_VERSION ||
+        st->size != sizeof(telem_stats_t)) {
+        munmap(map, sizeof(telem_stats_t));
+        errno = EPROTO;
+        return NULL;
+    }
+    return st;
+}
+
+void telem_stats_detach(const telem_stats_t *st) {
+    if (st) munmap((void *)st, sizeof(*st));
+}
+
+bool telem_stats_read(const telem_stats_t *st, telem_counters_t *c) {
+    for (int i = 0; i < TELEM_READ_TRIES; i++) {
+        uint64_t seq = atomic_load_explicit(&st->seq, memory_order_acquire);
+        if (seq & 1) continue;
+        memcpy(c, (const void *)&st->c, sizeof(*c));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&st->seq, memory_order_relaxed) == seq) return true;
+    }
+    return false;
+}
@@ -0,0 +1,198 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Live telemetry, two pieces:
+//
+// A time series of the sender's window state (cwnd, ssthresh, bytes in
+// flight, RTT, recovery state), sampled on a timer at a fixed interval
+// rather than per packet. Storage is columnar: one preallocated array per
+// column, so a sample is a few stores, and a full buffer goes out as one
+// write per column (binary) or as CSV text, never on the packet path.
+//
+// A stats block another process can poll while the transfer runs: a small
+// mmap'd file (on /dev/shm it never touches a disk) holding the counters
+// under a sequence lock. The writer makes seq odd, stores, makes it even;
+// a reader copies the block and retries when seq was odd or moved. Neither
+// side takes a lock or makes a syscall, so polling never stalls the sender.
+// telemetry_dump reads both.
+
+#define TELEM_SERIES_MAGIC "UDPTS1"
+#define TELEM_STATS_MAGIC "UDPST1"
+#define TELEM_VERSION 1
+#define TELEM_SERIES_ROWS 4096                  // samples buffered per write
+#define TELEM_INTERVAL_DEFAULT_MS 10
+
+enum {
+    TELEM_CSV = 0,      // chosen by a .csv file name
+    TELEM_BINARY,
+};
+
+// Sender state in a sample
+enum {
+    TELEM_STATE_OPEN = 0,
+    TELEM_STATE_RECOVERY,   // fast recovery
+    TELEM_STATE_TIMEOUT,    // RTO backed off, no RTT sample since
+};
+
+enum {
+    TELEM_ROLE_SENDER = 1,
+    TELEM_ROLE_RECEIVER,
+};
+
+// One sample; the series stores each field in its own column
+typedef struct {
+    uint64_t t_ns;          // since the series started
+    uint64_t acked;         // cumulatively acked bytes
+    uint32_t cwnd;
+    uint32_t ssthresh;
+    uint32_t inflight;      // bytes sent and neither acked nor lost
+    uint32_t srtt_us;
+    uint32_t rtt_us;        // latest sample
+    uint32_t retransmits;   // so far
+    uint32_t timeouts;
+    uint8_t state;          // TELEM_STATE_*
+} telem_row_t;
+
+typedef struct {
+    int format;
+    FILE *file;             // being written; NULL on the read side
+    uint64_t start_ns;
+    uint64_t interval_ns;
+    uint64_t next_ns;       // next sample due
+    uint32_t rows;          // buffered
+    uint64_t written;       // rows flushed so far
+    uint64_t *t_ns;
+    uint64_t *acked;
+    uint32_t *cwnd;
+    uint32_t *ssthresh;
+    uint32_t *inflight;
+    uint32_t *srtt_us;
+    uint32_t *rtt_us;
+    uint32_t *retransmits;
+    uint32_t *timeouts;
+    uint8_t *state;
+} telem_series_t;
+
+// Binary series: this header, then one block per flush: a uint64_t row
+// count followed by the columns in telem_row_t order, that many values each
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t columns;
+    uint64_t interval_ns;
+    uint64_t start_ns;
+} telem_series_hdr_t;
+
+// What the stats block publishes. A sender fills the first part, a
+// receiver the second; the other stays zero.
+typedef struct {
+    uint64_t t_ns;          // since start, as of this update
+    uint64_t bytes;         // acked (sender) or received in order (receiver)
+    uint64_t size;          // transfer size when known
+    uint32_t done;          // transfer finished
+    uint32_t flows;         // flows summed into this block
+
+    uint32_t cwnd;
+    uint32_t ssthresh;
+    uint32_t inflight;
+    uint32_t srtt_us;
+    uint32_t rto_us;
+    uint32_t state;         // TELEM_STATE_*
+    uint32_t total_retransmits;
+    uint32_t timeout_count;
+    uint32_t dup_ack_retransmits;
+    uint32_t rack_losses;
+    uint32_t tlp_probes;
+    uint64_t retransmitted_bytes;
+
+    uint32_t total_packets;
+    uint32_t dropped_packets;
+    uint32_t out_of_order_packets;
+    uint32_t duplicate_packets;
+    uint32_t corrupt_packets;
+    uint32_t fec_repaired;
+    uint32_t acks_sent;
+    uint32_t adv_wnd;
+} telem_counters_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;          // sizeof(telem_stats_t)
+    uint32_t role;          // TELEM_ROLE_*
+    uint32_t pid;
+    uint64_t start_ns;      // CLOCK_MONOTONIC
+    _Atomic uint64_t seq;   // odd while an update is in progress
+    telem_counters_t c;
+} telem_stats_t;
+
+// TELEM_CSV when path ends in .csv, else TELEM_BINARY
+int telem_series_format(const char *path);
+// Series to path in format, a sample every interval_ns from start_ns on
+int telem_series_open(telem_series_t *s, const char *path, int format, uint64_t interval_ns, uint64_t start_ns);
+// Write out what is buffered
+int telem_series_flush(telem_series_t *s);
+// Flush and close; returns the flush result
+int telem_series_close(telem_series_t *s);
+
+// Read side of a binary series: check the header and set up the columns,
+// then fetch one flushed block at a time (its rows; 0 at the end, -1 when
+// the block is cut short). Release with telem_series_close; in stays the
+// caller's.
+int telem_series_load(telem_series_t *s, FILE *in);
+int telem_series_next(telem_series_t *s, FILE *in);
+// Row i of what is buffered
+void telem_series_row(const telem_series_t *s, uint32_t i, telem_row_t *row);
+
+void telem_csv_header(FILE *out);
+void telem_csv_row(FILE *out, const telem_row_t *row);
+
+// Append a sample (the caller stamps row->t_ns relative to start_ns)
+static inline void telem_series_push(telem_series_t *s, const telem_row_t *row) {
+    uint32_t i = s->rows;
+    s->t_ns[i] = row->t_ns;
+    s->acked[i] = row->acked;
+    s->cwnd[i] = row->cwnd;
+    s->ssthresh[i] = row->ssthresh;
+    s->inflight[i] = row->inflight;
+    s->srtt_us[i] = row->srtt_us;
+    s->rtt_us[i] = row->rtt_us;
+    s->retransmits[i] = row->retransmits;
+    s->timeouts[i] = row->timeouts;
+    s->state[i] = row->state;
+    if (++s->rows == TELEM_SERIES_ROWS) (void)telem_series_flush(s);
+}
+
+// Create (or truncate) the stats file at path and map it
+telem_stats_t *telem_stats_open(const char *path, uint32_t role, uint64_t start_ns);
+void telem_stats_close(telem_stats_t *st);
+// Map an existing stats file read-only; NULL with errno set, EPROTO when
+// it is not one
+const telem_stats_t *telem_stats_attach(const char *path);
+void telem_stats_detach(const telem_stats_t *st);
+
+static inline void telem_stats_publish(telem_stats_t *st, const telem_counters_t *c) {
+    uint64_t seq = atomic_load_explicit(&st->seq, memory_order_relaxed);
+    atomic_store_explicit(&st->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    st->c = *c;
+    atomic_store_explicit(&st->seq, seq + 2, memory_order_release);
+}
+
+// Add a receiver's counters into sum (server mode sums its workers)
+void telem_counters_add_rx(telem_counters_t *sum, const telem_counters_t *c);
+
+// Consistent copy of the counters, retrying while the writer is
+// mid-update; false when no consistent copy could be had
+bool telem_stats_read(const telem_stats_t *st, telem_counters_t *c);
+
+static inline const char *telem_state_name(uint32_t state) {
+    return state == TELEM_STATE_RECOVERY ? "recovery" : state == TELEM_STATE_TIMEOUT ? "timeout" : "open";
+}
+
+#endif
@@ -0,0 +1,133 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+// Read the telemetry the sender, receiver and simulator write: poll a live
+// stats block (--stats) while the transfer runs, one key=value line per
+// poll, or turn a binary time series (--series) into CSV.
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-w 밀리초] [-n 횟수] <통계파일>\n", prog);
+    fprintf(stderr, "       %s -s <시계열파일>\n", prog);
+    fprintf(stderr, "  -w ms 통계 블록을 이 간격으로 계속 읽음 (전송이 끝나거나 기록하던 프로세스가 사라지면 멈춤)\n");
+    fprintf(stderr, "  -n N  N번 읽고 멈춤 (-w가 없으면 %d 밀리초 간격)\n", TELEM_INTERVAL_DEFAULT_MS);
+    fprintf(stderr, "  -s    바이너리 시계열 파일을 CSV로 변환해 출력\n");
+}
+
+static void print_counters(const telem_stats_t *st, const telem_counters_t *c) {
+    printf("t_ms=%.3f role=%s pid=%u flows=%u done=%u bytes=%" PRIu64, (double)c->t_ns / 1e6,
+           st->role == TELEM_ROLE_SENDER ? "sender" : "receiver", st->pid, c->flows, c->done, c->bytes);
+    if (st->role == TELEM_ROLE_SENDER) {
+        printf(" size=%" PRIu64 " cwnd=%u ssthresh=%u inflight=%u srtt_us=%u rto_us=%u state=%s"
+               " total_retransmits=%u timeout_count=%u dup_ack_retransmits=%u rack_losses=%u tlp_probes=%u"
+               " retransmitted_bytes=%" PRIu64 "\n",
+               c->size, c->cwnd, c->ssthresh, c->inflight, c->srtt_us, c->rto_us, telem_state_name(c->state),
+               c->total_retransmits, c->timeout_count, c->dup_ack_retransmits, c->rack_losses, c->tlp_probes,
+               c->retransmitted_bytes);
+    } else {
+        printf(" total_packets=%u dropped_packets=%u out_of_order_packets=%u duplicate_packets=%u"
+               " corrupt_packets=%u fec_repaired=%u acks_sent=%u adv_wnd=%u\n",
+               c->total_packets, c->dropped_packets, c->out_of_order_packets, c->duplicate_packets,
+               c->corrupt_packets, c->fec_repaired, c->acks_sent, c->adv_wnd);
+    }
+    fflush(stdout);
+}
+
+static int poll_stats(const char *path, uint64_t wait_ms, long count) {
+    const telem_stats_t *st = telem_stats_attach(path);
+    if (!st) {
+        if (errno == EPROTO) {
+            fprintf(stderr, "오류: 통계 파일이 아닙니다: %s\n", path);
+        } else {
+            fprintf(stderr, "오류: 통계 파일을 열 수 없습니다: %s\n", path);
+        }
+        return EXIT_FAILURE;
+    }
+    struct timespec gap = {
+        .tv_sec = (time_t)(wait_ms / 1000),
+        .tv_nsec = (long)(wait_ms % 1000) * 1000000L,
+    };
+    for (long i = 0; count <= 0 || i < count; i++) {
+        telem_counters_t c;
+        if (!telem_stats_read(st, &c)) {
+            fprintf(stderr, "오류: 기록 중인 통계를 일관되게 읽지 못했습니다: %s\n", path);
+            telem_stats_detach(st);
+            return EXIT_FAILURE;
+        }
+        print_counters(st, &c);
+        if (wait_ms == 0 || c.done) break;
+        // The writer is gone: nothing will change any more
+        if (kill((pid_t)st->pid, 0) < 0 && errno == ESRCH) break;
+        nanosleep(&gap, NULL);
+    }
+    telem_stats_detach(st);
+    return 0;
+}
+
+static int dump_series(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "오류: 시계열 파일을 열 수 없습니다: %s\n", path);
+        return EXIT_FAILURE;
+    }
+    telem_series_t s;
+    if (telem_series_load(&s, in) < 0) {
+        fprintf(stderr, "오류: 바이너리 시계열 파일이 아닙니다: %s\n", path);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    telem_csv_header(stdout);
+    int n;
+    telem_row_t row;
+    while ((n = telem_series_next(&s, in)) > 0) {
+        for (uint32_t i = 0; i < (uint32_t)n; i++) {
+            telem_series_row(&s, i, &row);
+            telem_csv_row(stdout, &row);
+        }
+    }
+    // Still being written: the last block may not be all there yet
+    if (n < 0) fprintf(stderr, "경고: 마지막 블록이 잘려 있습니다 (샘플 %" PRIu64 "개까지 출력)\n", s.written);
+    telem_series_close(&s);
+    fclose(in);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bool series = false;
+    uint64_t wait_ms = 0;
+    long count = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "sw:n:")) != -1) {
+        switch (opt) {
+        case 's':
+            series = true;
+            break;
+        case 'w':
+            wait_ms = strtoull(optarg, NULL, 10);
+            if (wait_ms == 0) wait_ms = 1;
+            break;
+        case 'n':
+            count = atol(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - optind != 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (count > 1 && wait_ms == 0) wait_ms = TELEM_INTERVAL_DEFAULT_MS;
+    if (series) return dump_series(argv[optind]);
+    return poll_stats(argv[optind], wait_ms, count);
+}
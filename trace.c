@@ -0,0 +1,177 @@
+#define _GNU_SOURCE
+#include "trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void trace_init(trace_t *t, int mode) {
+    memset(t, 0, sizeof(*t));
+    t->mode = mode;
+    t->fd = -1;
+}
+
+int trace_open_file(trace_t *t, const char *path, uint64_t cap) {
+    trace_init(t, TRACE_FILE);
+    if (cap == 0 || (cap & (cap - 1)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    t->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (t->fd < 0) return -1;
+    // The file is sparse until records land, so a large ring costs nothing up front
+    t->map_len = sizeof(trace_hdr_t) + (size_t)cap * sizeof(trace_rec_t);
+    if (ftruncate(t->fd, (off_t)t->map_len) < 0) goto fail;
+    void *map = mmap(NULL, t->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, t->fd, 0);
+    if (map == MAP_FAILED) goto fail;
+    t->hdr = map;
+    t->ring = (trace_rec_t *)((uint8_t *)map + sizeof(trace_hdr_t));
+    t->mask = cap - 1;
+    memcpy(t->hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    t->hdr->version = TRACE_VERSION;
+    t->hdr->rec_size = sizeof(trace_rec_t);
+    t->hdr->cap = cap;
+    t->hdr->start_ns = trace_now_ns();
+    atomic_store_explicit(&t->hdr->head, 0, memory_order_release);
+    return 0;
+
+fail:
+    close(t->fd);
+    t->fd = -1;
+    return -1;
+}
+
+void trace_close(trace_t *t) {
+    if (t->hdr) munmap(t->hdr, t->map_len);
+    if (t->fd >= 0) close(t->fd);
+    t->hdr = NULL;
+    t->ring = NULL;
+    t->fd = -1;
+}
+
+static const char *recovery_reason(int32_t aux) {
+    switch (aux) {
+    case TR_REASON_SACK:
+        return "SACK 손실 감지";
+    case TR_REASON_RACK:
+        return "RACK 손실 감지";
+    default:
+        return "3-Dup ACK";
+    }
+}
+
+void trace_format(FILE *out, const trace_rec_t *rec) {
+    switch (rec->type) {
+    case TR_SEND:
+        fprintf(out, "→ 패킷 (seq:%" PRIu64 ", size:%u) 송신%s\n", rec->seq, rec->len, rec->aux ? " (타이머)" : "");
+        break;
+    case TR_RETRANSMIT:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 재전송\n", rec->seq, rec->len);
+        break;
+    case TR_ACK_NEW:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신 => cwin %d 바이트 증가(%u 바이트)\n", rec->seq, rec->aux, rec->cwnd);
+        break;
+    case TR_ACK_DUP:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신 (중복 #%u)\n", rec->seq, rec->len);
+        if (rec->aux) fprintf(out, "  => Fast Recovery: cwin %u 바이트로 증가\n", rec->cwnd);
+        break;
+    case TR_ACK_PARTIAL:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신 (부분 ACK, Fast Recovery 유지) => cwin %u 바이트\n", rec->seq, rec->cwnd);
+        break;
+    case TR_ACK_RECOVERED:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신 (Fast Recovery 종료) => cwin %u 바이트\n", rec->seq, rec->cwnd);
+        break;
+    case TR_RECOVERY:
+        fprintf(out, "<<< %s 사건 발생>>>\n", recovery_reason(rec->aux));
+        fprintf(out, "- cwin: %u 바이트로 조정 (복구 지점 %" PRIu64 ")\n", rec->cwnd, rec->arg);
+        fprintf(out, "- 임계값: %u 바이트로 설정\n", rec->ssthresh);
+        break;
+    case TR_TIMEOUT:
+        fprintf(out, "<<<타임아웃 사건 발생>>>\n");
+        fprintf(out, "- cwin: %u 바이트로 조정\n", rec->cwnd);
+        fprintf(out, "- 임계값: %u 바이트로 설정\n", rec->ssthresh);
+        fprintf(out, "- RTO: %.1f 밀리초로 증가 (백오프 %d회)\n", (double)rec->arg / 1e6, rec->aux);
+        break;
+    case TR_RX:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 수신\n", rec->seq, rec->len);
+        break;
+    case TR_RX_OOO:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 순서 외 수신 (버퍼링)\n", rec->seq, rec->len);
+        break;
+    case TR_RX_DUP:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 중복 수신\n", rec->seq, rec->len);
+        break;
+    case TR_RX_WINDOW:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 수신 오류 (재조립 윈도우 초과)\n", rec->seq, rec->len);
+        break;
+    case TR_RX_DROP:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 손실\n", rec->seq, rec->len);
+        break;
+    case TR_RX_FIN:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", FIN) 수신\n", rec->seq);
+        break;
+    case TR_ACK_SENT:
+        if (rec->aux > 0) {
+            fprintf(out, "<--- ACK %" PRIu64 " 송신 (SACK %" PRIu64 "-%" PRIu64 "%s)\n", rec->seq, rec->arg,
+                    rec->arg + rec->len, rec->aux > 1 ? " 외" : "");
+        } else {
+            fprintf(out, "<--- ACK %" PRIu64 " 송신\n", rec->seq);
+        }
+        break;
+    case TR_WND_PROBE:
+        fprintf(out, "→ 윈도우 프로브 (seq:%" PRIu64 ") 송신 (수신 윈도우 %" PRIu64 " 바이트, %d번째)\n", rec->seq, rec->arg, rec->aux);
+        break;
+    case TR_RX_WND_PROBE:
+        fprintf(out, "---→ 윈도우 프로브 (seq:%" PRIu64 ") 수신\n", rec->seq);
+        break;
+    case TR_WND_UPDATE:
+        fprintf(out, "<--- 윈도우 갱신: ACK %" PRIu64 ", 수신 윈도우 %" PRIu64 " 바이트\n", rec->seq, rec->arg);
+        break;
+    case TR_RX_CORRUPT:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 체크섬 오류 (손실로 처리)\n", rec->seq, rec->len);
+        break;
+    case TR_RX_DIGEST:
+        fprintf(out, "---→ FIN 다이제스트 확인: %" PRIu64 " 바이트, CRC32C %08" PRIx64 " %s\n", rec->seq, rec->arg,
+                rec->aux == 1 ? "일치" : rec->aux == 2 ? "확인 불가" : "불일치");
+        break;
+    case TR_FEC_PARITY:
+        fprintf(out, "→ 패리티 (seq:%" PRIu64 ", size:%u) 송신: 세그먼트 %" PRIu64 "개 (k=%d)\n", rec->seq, rec->len,
+                rec->arg, rec->aux);
+        break;
+    case TR_FEC_REPAIRED:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신: 수신측이 패리티로 %d개 복구 (누적 %" PRIu64 "개) => cwin %u 바이트\n",
+                rec->seq, rec->aux, rec->arg, rec->cwnd);
+        break;
+    case TR_RX_FEC_PARITY:
+        fprintf(out, "---→ 패리티 (seq:%" PRIu64 ", size:%u) 수신: 세그먼트 %" PRIu64 "개\n", rec->seq, rec->len, rec->arg);
+        break;
+    case TR_RX_FEC_REPAIR:
+        fprintf(out, "---→ 패킷 (seq:%" PRIu64 ", size:%u) 패리티로 복구\n", rec->seq, rec->len);
+        break;
+    case TR_FIN:
+        fprintf(out, "→ FIN (seq:%" PRIu64 ") %s\n", rec->seq, rec->aux > 1 ? "재전송" : "송신");
+        break;
+    case TR_FIN_ACKED:
+        fprintf(out, "<--- FIN 확인 수신 (FIN %d번 송신)\n", rec->aux);
+        break;
+    case TR_TLP:
+        fprintf(out, "→ 꼬리 손실 프로브 (seq:%" PRIu64 ", size:%u)%s\n", rec->seq, rec->len, rec->aux ? " 재전송" : "");
+        break;
+    case TR_TLP_RECOVERED:
+        fprintf(out, "<--- ACK %" PRIu64 " 수신: 프로브 재전송으로 꼬리 손실 복구 => cwin %u 바이트\n", rec->seq, rec->cwnd);
+        break;
+    default:
+        fprintf(out, "(알 수 없는 이벤트 %u)\n", rec->type);
+        break;
+    }
+}
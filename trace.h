@@ -0,0 +1,126 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Per-packet event tracing. Every send, retransmit, ACK, drop and recovery
+// event is a fixed-size record. Text mode formats it straight to stdout
+// (the classic log), quiet mode drops it, and file mode stores it in an
+// mmap'd ring with no formatting or syscalls on the hot path. The writer
+// is single-threaded; head is published with a release store, so a reader
+// mapping the same file can follow a live transfer. trace_dump decodes a
+// file back into the text log with the same formatter.
+
+#define TRACE_MAGIC "UDPTRC1"
+#define TRACE_VERSION 1
+#define TRACE_DEFAULT_RECORDS (1u << 21)   // ring size, power of two (96 MB file)
+
+enum {
+    TRACE_TEXT = 0,
+    TRACE_OFF,
+    TRACE_FILE,
+};
+
+enum {
+    // sender
+    TR_SEND = 1,        // aux: RTO timer was already running
+    TR_RETRANSMIT,
+    TR_ACK_NEW,         // aux: cwnd change
+    TR_ACK_DUP,         // len: dup count, aux: window inflated
+    TR_ACK_PARTIAL,
+    TR_ACK_RECOVERED,
+    TR_RECOVERY,        // arg: recovery point, aux: TR_REASON_*
+    TR_TIMEOUT,         // arg: new RTO (ns), aux: backoff count
+    // receiver
+    TR_RX,
+    TR_RX_OOO,
+    TR_RX_DUP,
+    TR_RX_WINDOW,       // beyond the reassembly window
+    TR_RX_DROP,         // simulated loss
+    TR_RX_FIN,
+    TR_ACK_SENT,        // seq: ack, arg: first SACK start, len: its length, aux: blocks
+    // flow control
+    TR_WND_PROBE,       // sender; arg: advertised window, aux: probe count
+    TR_RX_WND_PROBE,
+    TR_WND_UPDATE,      // receiver reopens the window; arg: window
+    // integrity
+    TR_RX_CORRUPT,      // failed the checksum; len: payload bytes
+    TR_RX_DIGEST,       // FIN digest checked; seq: bytes, arg: ours, aux: RX_DIGEST_*
+    // forward error correction
+    TR_FEC_PARITY,      // sender; seq: block start, len: parity bytes, arg: segments, aux: k
+    TR_FEC_REPAIRED,    // sender learns of repairs; seq: ack, arg: total, aux: new
+    TR_RX_FEC_PARITY,   // arg: segments
+    TR_RX_FEC_REPAIR,   // segment rebuilt from its block's parity
+    // teardown
+    TR_FIN,             // sender; seq: flow length, aux: sends so far
+    TR_FIN_ACKED,       // sender; aux: sends it took
+    // RACK-TLP
+    TR_TLP,             // tail loss probe; arg: highest byte sent, aux: it was a retransmission
+    TR_TLP_RECOVERED,   // the probe's retransmission alone repaired the tail; seq: ack
+    TR_EVENT_MAX,
+};
+
+enum {
+    TR_REASON_DUPACK = 0,
+    TR_REASON_SACK,
+    TR_REASON_RACK,
+};
+
+typedef struct {
+    uint64_t ts_ns;     // CLOCK_MONOTONIC
+    uint64_t seq;       // segment offset or ACK
+    uint64_t arg;       // event specific
+    uint32_t len;
+    uint32_t cwnd;      // sender window state after the event (bytes)
+    uint32_t ssthresh;
+    int32_t aux;        // event specific
+    uint8_t type;
+    uint8_t pad[7];
+} trace_rec_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rec_size;
+    uint64_t cap;               // records in the ring
+    uint64_t start_ns;          // first record's clock base
+    _Atomic uint64_t head;      // records ever written; ring keeps the last cap
+} trace_hdr_t;
+
+typedef struct {
+    int mode;
+    int fd;
+    trace_hdr_t *hdr;
+    trace_rec_t *ring;
+    uint64_t mask;
+    uint64_t head;
+    size_t map_len;
+} trace_t;
+
+// Text (mode TRACE_TEXT) or quiet (TRACE_OFF) tracing; no resources
+void trace_init(trace_t *t, int mode);
+// Binary ring in an mmap'd file of cap records (power of two)
+int trace_open_file(trace_t *t, const char *path, uint64_t cap);
+void trace_close(trace_t *t);
+
+uint64_t trace_now_ns(void);
+
+// Print one record in the human-readable Korean log format
+void trace_format(FILE *out, const trace_rec_t *rec);
+
+// Record one event; the caller stamps rec->ts_ns from its own clock
+// (virtual time under the simulator)
+static inline void trace_write(trace_t *t, trace_rec_t *rec) {
+    if (t->mode == TRACE_OFF) return;
+    if (t->mode == TRACE_TEXT) {
+        trace_format(stdout, rec);
+        return;
+    }
+    t->ring[t->head & t->mask] = *rec;
+    t->head++;
+    atomic_store_explicit(&t->hdr->head, t->head, memory_order_release);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+// Decode a binary trace written with --trace back into the text log the
+// sender and receiver print without it.
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-t] <트레이스파일>\n", prog);
+    fprintf(stderr, "  -t    각 이벤트 앞에 트레이스 시작 기준 시각(초)을 표시\n");
+}
+
+int main(int argc, char **argv) {
+    bool show_time = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "t")) != -1) {
+        switch (opt) {
+        case 't':
+            show_time = true;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - optind != 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *path = argv[optind];
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "오류: 트레이스 파일을 열 수 없습니다: %s\n", path);
+        return EXIT_FAILURE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(trace_hdr_t)) {
+        fprintf(stderr, "오류: 트레이스 파일이 아닙니다: %s\n", path);
+        return EXIT_FAILURE;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    trace_hdr_t *hdr = map;
+    if (memcmp(hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || hdr->version != TRACE_VERSION ||
+        hdr->rec_size != sizeof(trace_rec_t) || hdr->cap == 0 || (hdr->cap & (hdr->cap - 1)) != 0 ||
+        sizeof(trace_hdr_t) + hdr->cap * sizeof(trace_rec_t) > (uint64_t)st.st_size) {
+        fprintf(stderr, "오류: 지원하지 않는 트레이스 형식입니다: %s\n", path);
+        return EXIT_FAILURE;
+    }
+    const trace_rec_t *ring = (const trace_rec_t *)((const uint8_t *)map + sizeof(trace_hdr_t));
+    uint64_t head = atomic_load_explicit(&hdr->head, memory_order_acquire);
+    uint64_t first = head > hdr->cap ? head - hdr->cap : 0;
+    if (first > 0) {
+        printf("(앞선 이벤트 %" PRIu64 "개는 링에서 덮어써짐)\n", first);
+    }
+
+    for (uint64_t i = first; i < head; i++) {
+        const trace_rec_t *rec = &ring[i & (hdr->cap - 1)];
+        if (show_time) {
+            double t = rec->ts_ns >= hdr->start_ns ? (double)(rec->ts_ns - hdr->start_ns) / 1e9 : 0.0;
+            printf("[%12.6f] ", t);
+        }
+        trace_format(stdout, rec);
+    }
+
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "twheel.h"
+
+#include <string.h>
+
+static void list_init(twheel_entry_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static void list_push(twheel_entry_t *head, twheel_entry_t *e) {
+    e->prev = head->prev;
+    e->next = head;
+    head->prev->next = e;
+    head->prev = e;
+}
+
+static void list_unlink(twheel_entry_t *e) {
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+    e->next = NULL;
+    e->prev = NULL;
+}
+
+void twheel_init(twheel_t *w, uint64_t now_ns) {
+    memset(w, 0, sizeof(*w));
+    for (unsigned i = 0; i < TWHEEL_SLOTS; i++) list_init(&w->slots[i]);
+    list_init(&w->expired);
+    w->tick = now_ns >> TWHEEL_TICK_SHIFT;
+}
+
+void twheel_add(twheel_t *w, twheel_entry_t *e, uint64_t deadline_ns) {
+    uint64_t tick = (deadline_ns + (1ull << TWHEEL_TICK_SHIFT) - 1) >> TWHEEL_TICK_SHIFT;
+    if (tick < w->tick) tick = w->tick;
+    unsigned s = (unsigned)(tick & TWHEEL_MASK);
+    e->tick = tick;
+    list_push(&w->slots[s], e);
+    w->map[s / 64] |= 1ull << (s % 64);
+    w->count++;
+}
+
+void twheel_del(twheel_t *w, twheel_entry_t *e) {
+    if (!twheel_linked(e)) return;
+    bool expired = e->tick == TWHEEL_EXPIRED;
+    unsigned s = (unsigned)(e->tick & TWHEEL_MASK);
+    list_unlink(e);
+    if (expired) return;
+    w->count--;
+    twheel_entry_t *slot = &w->slots[s];
+    if (slot->next == slot) w->map[s / 64] &= ~(1ull << (s % 64));
+}
+
+// First non-empty slot at or after s, going round once; -1 when all empty
+static int next_slot(const twheel_t *w, unsigned s) {
+    unsigned word = s / 64;
+    uint64_t bits = w->map[word] & (~0ull << (s % 64));
+    for (unsigned i = 0; i <= TWHEEL_SLOTS / 64; i++) {
+        if (bits) return (int)((word * 64 + (unsigned)__builtin_ctzll(bits)) & TWHEEL_MASK);
+        word = (word + 1) % (TWHEEL_SLOTS / 64);
+        bits = w->map[word];
+    }
+    return -1;
+}
+
+void twheel_advance(twheel_t *w, uint64_t now_ns) {
+    uint64_t now_tick = now_ns >> TWHEEL_TICK_SHIFT;
+    if (now_tick < w->tick) return;
+    // Each slot needs one visit however far the clock jumped
+    uint64_t span = now_tick - w->tick + 1;
+    if (span > TWHEEL_SLOTS) span = TWHEEL_SLOTS;
+    uint64_t done = 0;
+    while (done < span && w->count > 0) {
+        unsigned from = (unsigned)((w->tick + done) & TWHEEL_MASK);
+        int s = next_slot(w, from);
+        if (s < 0) break;
+        uint64_t dist = ((unsigned)s - from) & TWHEEL_MASK;
+        if (done + dist >= span) break;
+        done += dist;
+        twheel_entry_t *slot = &w->slots[s];
+        for (twheel_entry_t *e = slot->next; e != slot;) {
+            twheel_entry_t *next = e->next;
+            if (e->tick <= now_tick) {
+                list_unlink(e);
+                e->tick = TWHEEL_EXPIRED;
+                list_push(&w->expired, e);
+                w->count--;
+            }
+            e = next;
+        }
+        if (slot->next == slot) w->map[s / 64] &= ~(1ull << (s % 64));
+        done++;
+    }
+    w->tick = now_tick + 1;
+}
+
+twheel_entry_t *twheel_pop_expired(twheel_t *w) {
+    twheel_entry_t *e = w->expired.next;
+    if (e == &w->expired) return NULL;
+    list_unlink(e);
+    return e;
+}
+
+uint64_t twheel_next_ns(const twheel_t *w) {
+    if (w->count == 0) return 0;
+    unsigned from = (unsigned)(w->tick & TWHEEL_MASK);
+    int s = next_slot(w, from);
+    if (s < 0) return 0;
+    return twheel_tick_ns(w->tick + (((unsigned)s - from) & TWHEEL_MASK));
+}
@@ -0,0 +1,64 @@
+#ifndef TWHEEL_H
+#define TWHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hashed timer wheel (Varghese & Lauck, scheme 6): TWHEEL_SLOTS buckets of
+// 2^TWHEEL_TICK_SHIFT ns each. An entry goes, unsorted, into the bucket of
+// its deadline tick, so arming and cancelling are O(1) list operations
+// however many timers are pending. Advancing the wheel visits each elapsed
+// non-empty bucket once and takes the entries whose tick has come; entries
+// a revolution or more ahead stay for a later pass. A bitmap of non-empty
+// buckets finds the next one to wake up for without walking empty buckets.
+//
+// Deadlines round up to the next tick: an entry never fires early and at
+// most one tick late. Entries are intrusive; the wheel allocates nothing.
+
+#define TWHEEL_TICK_SHIFT 16                    // 65.5 us per tick
+#define TWHEEL_SLOTS 4096                       // one revolution ~268 ms
+#define TWHEEL_MASK (TWHEEL_SLOTS - 1)
+#define TWHEEL_EXPIRED UINT64_MAX               // entry tick once on the expired list
+
+typedef struct twheel_entry {
+    struct twheel_entry *next;  // NULL when not linked
+    struct twheel_entry *prev;
+    uint64_t tick;              // due tick, TWHEEL_EXPIRED once taken
+} twheel_entry_t;
+
+typedef struct {
+    twheel_entry_t slots[TWHEEL_SLOTS];         // list heads
+    uint64_t map[TWHEEL_SLOTS / 64];            // non-empty slots
+    twheel_entry_t expired;                     // taken by twheel_advance, not fired yet
+    uint64_t tick;                              // every tick before this one is done
+    uint64_t count;                             // entries in slots
+} twheel_t;
+
+void twheel_init(twheel_t *w, uint64_t now_ns);
+
+// Link e (not linked) to fire at deadline_ns; a deadline already past fires
+// on the next advance
+void twheel_add(twheel_t *w, twheel_entry_t *e, uint64_t deadline_ns);
+// Unlink e from its slot or from the expired list; no-op when not linked
+void twheel_del(twheel_t *w, twheel_entry_t *e);
+
+// Move every entry due by now_ns onto the expired list
+void twheel_advance(twheel_t *w, uint64_t now_ns);
+// Unlink and return the first expired entry, NULL when none
+twheel_entry_t *twheel_pop_expired(twheel_t *w);
+
+// Start of the first tick with a non-empty slot, 0 when nothing is pending.
+// That slot may only hold later revolutions: a wakeup there finds nothing
+// due and asks again.
+uint64_t twheel_next_ns(const twheel_t *w);
+
+static inline bool twheel_linked(const twheel_entry_t *e) {
+    return e->next != NULL;
+}
+
+static inline uint64_t twheel_tick_ns(uint64_t tick) {
+    return tick << TWHEEL_TICK_SHIFT;
+}
+
+#endif
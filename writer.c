@@ -0,0 +1,328 @@
+#define _GNU_SOURCE
+#include "writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int ring_init(writer_ring_t *r, uint32_t entries) {
+    uint32_t cap = 1;
+    while (cap < entries) cap <<= 1;
+    r->slots = calloc(cap, sizeof(*r->slots));
+    if (!r->slots) return -1;
+    r->mask = cap - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return sem_init(&r->sem, 0, 0);
+}
+
+static void ring_free(writer_ring_t *r) {
+    if (!r->slots) return;
+    sem_destroy(&r->sem);
+    free(r->slots);
+    r->slots = NULL;
+}
+
+static void ring_push(writer_ring_t *r, uint32_t idx) {
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    r->slots[t & r->mask] = idx;
+    atomic_store_explicit(&r->tail, t + 1, memory_order_release);
+    sem_post(&r->sem);
+}
+
+// The caller already took one count off r->sem
+static uint32_t ring_pop(writer_ring_t *r) {
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    (void)atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t idx = r->slots[h & r->mask];
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+    return idx;
+}
+
+static void sem_wait_intr(sem_t *sem) {
+    while (sem_wait(sem) < 0 && errno == EINTR) {}
+}
+
+// ---- writer thread ----
+
+static void fail(const char *what) {
+    fprintf(stderr, "오류: 파일 %s 실패: %s\n", what, strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+static void write_all(writer_t *wr, int fd, const uint8_t *data, uint64_t len, uint64_t off) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, data, len, (off_t)off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("쓰기");
+        }
+        wr->writes++;
+        data += n;
+        len -= (uint64_t)n;
+        off += (uint64_t)n;
+    }
+}
+
+static void write_chunk(writer_t *wr, const writer_chunk_t *ch) {
+    const uint8_t *p = ch->buf + ch->skew;
+    uint64_t off = ch->off;
+    uint64_t end = off + ch->len;
+    uint64_t a0 = (off + WRITER_ALIGN - 1) & ~(uint64_t)(WRITER_ALIGN - 1);
+    uint64_t a1 = end & ~(uint64_t)(WRITER_ALIGN - 1);
+    if (ch->dfd < 0 || a1 <= a0) {
+        write_all(wr, ch->fd, p, ch->len, off);
+        return;
+    }
+    // Partial pages through the page cache, whole pages direct. A device
+    // that wants a coarser alignment refuses with EINVAL: fall back.
+    write_all(wr, ch->fd, p, a0 - off, off);
+    ssize_t n = pwrite(ch->dfd, p + (a0 - off), a1 - a0, (off_t)a0);
+    if (n < 0 && errno != EINVAL && errno != EINTR) fail("쓰기");
+    if (n < 0) {
+        n = 0;
+        wr->direct_fallbacks++;
+    } else {
+        wr->writes++;
+        wr->direct_bytes += (uint64_t)n;
+    }
+    write_all(wr, ch->fd, p + (a0 - off) + n, end - a0 - (uint64_t)n, a0 + (uint64_t)n);
+}
+
+static void *writer_main(void *arg) {
+    writer_t *wr = arg;
+    for (;;) {
+        sem_wait_intr(&wr->todo.sem);
+        uint32_t idx = ring_pop(&wr->todo);
+        writer_chunk_t *ch = &wr->chunks[idx];
+        if (ch->op & WR_OP_STOP) break;
+        uint64_t t0 = mono_ns();
+        if (ch->len > 0) write_chunk(wr, ch);
+        if (ch->op & WR_OP_FSYNC) {
+            if (fsync(ch->fd) < 0) fail("fsync");
+            wr->fsyncs++;
+        }
+        if (ch->op & WR_OP_CLOSE) {
+            close(ch->fd);
+            if (ch->dfd >= 0) close(ch->dfd);
+        }
+        uint64_t dt = mono_ns() - t0;
+        wr->sum_write_ns += dt;
+        if (dt > wr->max_write_ns) wr->max_write_ns = dt;
+        wr->chunks_written++;
+
+        atomic_fetch_add_explicit(&wr->written, ch->len, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&wr->queued, 1, memory_order_relaxed);
+        ring_push(&wr->done, idx);
+        uint64_t one = 1;
+        (void)write(wr->event_fd, &one, sizeof(one));
+    }
+    return NULL;
+}
+
+// ---- producer (worker thread) ----
+
+static void reclaim(writer_t *wr) {
+    wr->free_stack[wr->nfree++] = ring_pop(&wr->done);
+}
+
+static void submit(writer_t *wr, uint32_t idx) {
+    writer_chunk_t *ch = &wr->chunks[idx];
+    if (ch->owner) {
+        // Swap-remove from the open list
+        uint32_t last = wr->open[--wr->nopen];
+        wr->open[ch->open_pos] = last;
+        wr->chunks[last].open_pos = ch->open_pos;
+        ch->owner->open = -1;
+        ch->owner = NULL;
+    }
+    atomic_fetch_add_explicit(&wr->queued, 1, memory_order_relaxed);
+    ring_push(&wr->todo, idx);
+}
+
+static void submit_open(writer_t *wr) {
+    while (wr->nopen > 0) submit(wr, wr->open[wr->nopen - 1]);
+}
+
+static uint32_t get_chunk(writer_t *wr) {
+    if (wr->nfree == 0) {
+        if (sem_trywait(&wr->done.sem) < 0) {
+            // Pool exhausted: every chunk is queued or being filled. Hand
+            // over the partial ones too, or nothing might ever come back.
+            wr->stalls++;
+            submit_open(wr);
+            sem_wait_intr(&wr->done.sem);
+        }
+        reclaim(wr);
+    }
+    uint32_t idx = wr->free_stack[--wr->nfree];
+    writer_chunk_t *ch = &wr->chunks[idx];
+    ch->len = 0;
+    ch->skew = 0;
+    ch->op = 0;
+    ch->owner = NULL;
+    return idx;
+}
+
+int writer_init(writer_t *wr, uint64_t pool_bytes) {
+    memset(wr, 0, sizeof(*wr));
+    wr->event_fd = -1;
+    uint64_t n = pool_bytes / WRITER_CHUNK;
+    if (n < 2) n = 2;
+    wr->nchunks = (uint32_t)n;
+    // Pages are only touched as chunks get used, and the free stack hands
+    // the most recently returned chunk out first, so RSS follows the backlog
+    wr->arena_len = (size_t)n * WRITER_CHUNK;
+    void *arena = mmap(NULL, wr->arena_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) return -1;
+    wr->arena = arena;
+    wr->chunks = calloc(n, sizeof(*wr->chunks));
+    wr->free_stack = calloc(n, sizeof(*wr->free_stack));
+    wr->open = calloc(n, sizeof(*wr->open));
+    if (!wr->chunks || !wr->free_stack || !wr->open) goto fail;
+    if (ring_init(&wr->todo, wr->nchunks) < 0 || ring_init(&wr->done, wr->nchunks) < 0) goto fail;
+    for (uint32_t i = 0; i < wr->nchunks; i++) {
+        wr->chunks[i].buf = wr->arena + (size_t)i * WRITER_CHUNK;
+        wr->free_stack[wr->nfree++] = wr->nchunks - 1 - i;
+    }
+    atomic_init(&wr->written, 0);
+    atomic_init(&wr->queued, 0);
+    wr->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wr->event_fd < 0) goto fail;
+    if (pthread_create(&wr->thread, NULL, writer_main, wr) != 0) goto fail;
+    return 0;
+
+fail:
+    if (wr->event_fd >= 0) close(wr->event_fd);
+    ring_free(&wr->todo);
+    ring_free(&wr->done);
+    free(wr->chunks);
+    free(wr->free_stack);
+    free(wr->open);
+    munmap(wr->arena, wr->arena_len);
+    wr->arena = NULL;
+    return -1;
+}
+
+void writer_free(writer_t *wr) {
+    if (!wr->arena) return;
+    writer_drain(wr);
+    uint32_t idx = get_chunk(wr);
+    wr->chunks[idx].op = WR_OP_STOP;
+    ring_push(&wr->todo, idx);
+    pthread_join(wr->thread, NULL);
+    close(wr->event_fd);
+    ring_free(&wr->todo);
+    ring_free(&wr->done);
+    free(wr->chunks);
+    free(wr->free_stack);
+    free(wr->open);
+    munmap(wr->arena, wr->arena_len);
+    wr->arena = NULL;
+}
+
+int writer_file_open(writer_t *wr, writer_file_t *wf, int fd, bool direct) {
+    (void)wr;
+    wf->open = -1;
+    wf->dfd = -1;
+    wf->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (wf->fd < 0) return -1;
+    if (!direct) return 0;
+    // A second open file description, so O_DIRECT leaves the buffered
+    // descriptor (and the caller's) alone
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    wf->dfd = open(path, O_WRONLY | O_DIRECT | O_CLOEXEC);
+    return wf->dfd < 0 ? -1 : 0;
+}
+
+void writer_put(writer_t *wr, writer_file_t *wf, const uint8_t *data, uint32_t len, uint64_t off) {
+    while (len > 0) {
+        writer_chunk_t *ch = wf->open >= 0 ? &wr->chunks[wf->open] : NULL;
+        if (ch && off != ch->off + ch->len) {
+            submit(wr, (uint32_t)wf->open);
+            ch = NULL;
+        }
+        if (!ch) {
+            uint32_t idx = get_chunk(wr);
+            ch = &wr->chunks[idx];
+            ch->fd = wf->fd;
+            ch->dfd = wf->dfd;
+            ch->off = off;
+            ch->skew = (uint32_t)(off % WRITER_ALIGN);
+            ch->owner = wf;
+            ch->open_pos = wr->nopen;
+            wr->open[wr->nopen++] = idx;
+            wf->open = (int32_t)idx;
+        }
+        uint32_t room = WRITER_CHUNK - ch->skew - ch->len;
+        uint32_t n = len < room ? len : room;
+        memcpy(ch->buf + ch->skew + ch->len, data, n);
+        ch->len += n;
+        wr->submitted += n;
+        data += n;
+        len -= n;
+        off += n;
+        if (n == room) submit(wr, (uint32_t)wf->open);
+    }
+}
+
+void writer_file_close(writer_t *wr, writer_file_t *wf, bool fsync) {
+    if (wf->fd < 0) return;
+    uint32_t idx;
+    if (wf->open >= 0) {
+        idx = (uint32_t)wf->open;
+    } else {
+        idx = get_chunk(wr);
+        wr->chunks[idx].fd = wf->fd;
+        wr->chunks[idx].dfd = wf->dfd;
+    }
+    wr->chunks[idx].op = WR_OP_CLOSE | (fsync ? WR_OP_FSYNC : 0);
+    submit(wr, idx);
+    wf->fd = -1;
+    wf->dfd = -1;
+}
+
+void writer_kick(writer_t *wr) {
+    if (atomic_load_explicit(&wr->queued, memory_order_relaxed) == 0) submit_open(wr);
+}
+
+void writer_reap(writer_t *wr) {
+    uint64_t v;
+    (void)read(wr->event_fd, &v, sizeof(v));
+    while (sem_trywait(&wr->done.sem) == 0) reclaim(wr);
+}
+
+void writer_drain(writer_t *wr) {
+    submit_open(wr);
+    while (wr->nfree < wr->nchunks) {
+        sem_wait_intr(&wr->done.sem);
+        reclaim(wr);
+    }
+}
+
+void writer_print_stats(const writer_t *wr, FILE *out) {
+    uint64_t bytes = atomic_load_explicit(&wr->written, memory_order_relaxed);
+    fprintf(out, "디스크 쓰기: %" PRIu64 " 바이트, pwrite %" PRIu64 "회 (청크 %" PRIu64 "개, 평균 %.1f KB), 청크당 평균 %.3f / 최대 %.3f 밀리초\n",
+            bytes, wr->writes, wr->chunks_written,
+            wr->chunks_written ? (double)bytes / 1024.0 / (double)wr->chunks_written : 0.0,
+            wr->chunks_written ? (double)wr->sum_write_ns / 1e6 / (double)wr->chunks_written : 0.0,
+            (double)wr->max_write_ns / 1e6);
+    if (wr->stalls > 0) fprintf(out, "쓰기 버퍼 풀 부족으로 대기: %" PRIu64 "회\n", wr->stalls);
+    if (wr->direct_bytes > 0 || wr->direct_fallbacks > 0) {
+        fprintf(out, "O_DIRECT: %" PRIu64 " 바이트 (거부되어 일반 쓰기로 대체 %" PRIu64 "회)\n", wr->direct_bytes, wr->direct_fallbacks);
+    }
+    if (wr->fsyncs > 0) fprintf(out, "fsync: %" PRIu64 "회\n", wr->fsyncs);
+}
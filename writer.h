@@ -0,0 +1,131 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Asynchronous positional writes for one receive worker. Payloads are
+// copied into page-aligned chunks from a preallocated pool; segments that
+// continue the previous one's file offset share a chunk. Full chunks go to
+// a writer thread over a single-producer single-consumer ring and come
+// back over another once pwrite()n, so the packet path only ever copies.
+// It waits on the disk only when the whole pool is queued.
+//
+// A chunk's data starts at the same offset within a page as its file
+// offset, so with O_DIRECT the page-aligned middle of every chunk goes
+// straight to the device and only the partial pages at its ends take the
+// page cache.
+
+#define WRITER_CHUNK (1u << 20)
+#define WRITER_ALIGN 4096u
+#define WRITER_DEFAULT_POOL (64ull << 20)
+
+enum {
+    WR_OP_FSYNC = 0x01,     // after the data: fsync the file
+    WR_OP_CLOSE = 0x02,     // then close its descriptors
+    WR_OP_STOP = 0x04,      // writer thread exits
+};
+
+typedef struct writer_file writer_file_t;
+
+typedef struct {
+    uint8_t *buf;           // WRITER_CHUNK bytes, page aligned
+    int fd;
+    int dfd;
+    uint64_t off;           // file offset of the first byte
+    uint32_t skew;          // data starts at buf + skew (off % WRITER_ALIGN)
+    uint32_t len;
+    uint8_t op;             // WR_OP_*
+    writer_file_t *owner;   // while open for appends
+    uint32_t open_pos;      // index in open[]
+} writer_chunk_t;
+
+// One output file as seen by the writer. The descriptors are the writer's
+// own (a dup, and an O_DIRECT reopen when asked for); it closes them after
+// the last chunk, so the caller may close its descriptor right away.
+struct writer_file {
+    int fd;
+    int dfd;                // -1 when not writing direct
+    int32_t open;           // chunk being filled, -1 if none
+};
+
+// Chunk indices in flight between the threads; sem counts the entries
+typedef struct {
+    uint32_t *slots;
+    uint32_t mask;
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    sem_t sem;
+} writer_ring_t;
+
+typedef struct {
+    writer_chunk_t *chunks;
+    uint8_t *arena;
+    size_t arena_len;
+    uint32_t nchunks;
+    pthread_t thread;
+    int event_fd;           // readable after chunks complete (for an evloop)
+
+    // Producer side
+    writer_ring_t todo;     // to the writer thread
+    writer_ring_t done;     // back from it
+    uint32_t *free_stack;
+    uint32_t nfree;
+    uint32_t *open;         // chunks being filled, one per file at most
+    uint32_t nopen;
+    uint64_t submitted;     // bytes handed over (open chunks included)
+    _Atomic uint64_t written;
+    _Atomic uint32_t queued; // chunks in the todo ring or being written
+    uint64_t stalls;        // times the pool ran dry and the worker waited
+
+    // Writer thread side, read after writer_drain
+    uint64_t writes;        // pwrite calls
+    uint64_t direct_bytes;
+    uint64_t direct_fallbacks;
+    uint64_t fsyncs;
+    uint64_t max_write_ns;  // slowest chunk, fsync included
+    uint64_t sum_write_ns;
+    uint64_t chunks_written;
+} writer_t;
+
+// Pool of pool_bytes (rounded to whole chunks, at least two); starts the thread
+int writer_init(writer_t *wr, uint64_t pool_bytes);
+// Drain, stop the thread and release the pool
+void writer_free(writer_t *wr);
+
+// Take over fd for writing; direct reopens it with O_DIRECT as well.
+// Returns 0, or -1 when only the O_DIRECT reopen failed (buffered writes
+// still work).
+int writer_file_open(writer_t *wr, writer_file_t *wf, int fd, bool direct);
+// Queue len bytes for file offset off
+void writer_put(writer_t *wr, writer_file_t *wf, const uint8_t *data, uint32_t len, uint64_t off);
+// Last write for the file: optionally fsync, then close its descriptors
+void writer_file_close(writer_t *wr, writer_file_t *wf, bool fsync);
+
+// Hand open chunks over if the writer thread has nothing to do: it stays
+// busy while the worker keeps coalescing behind it
+void writer_kick(writer_t *wr);
+// After event_fd fired: clear it and reclaim finished chunks
+void writer_reap(writer_t *wr);
+// Submit everything and wait until it is on disk
+void writer_drain(writer_t *wr);
+
+// Bytes accepted but not written yet
+static inline uint64_t writer_backlog(const writer_t *wr) {
+    return wr->submitted - atomic_load_explicit(&wr->written, memory_order_relaxed);
+}
+
+// Bytes the pool can still take before writer_put has to wait
+static inline uint64_t writer_room(const writer_t *wr) {
+    uint64_t pool = (uint64_t)wr->nchunks * WRITER_CHUNK;
+    uint64_t backlog = writer_backlog(wr);
+    return backlog < pool ? pool - backlog : 0;
+}
+
+void writer_print_stats(const writer_t *wr, FILE *out);
+
+#endif